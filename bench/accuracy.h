@@ -0,0 +1,298 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <Eigen/LU>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <ostream>
+#include <type_traits>
+
+// Accuracy of benchmarked results against a double-double reference.
+//
+// The reference is computed from the operands as stored in the benchmarked
+// type (every posit and float converts to double exactly), so it measures
+// the arithmetic and not the rounding of the inputs. Products of doubles are
+// exact in double-double and sums carry 106 bits, far below the error of any
+// 32-bit format, so the posit32 quire's correctly rounded dot products come
+// out at no more than half an ulp. References are built once per input set;
+// compare() then reports absolute and relative error, error in ulps of the
+// result type, a histogram of decimal accuracy (-log10 |log10(x / ref)|,
+// Gustafson's measure) and a per-element map of the ulp error.
+namespace bench
+{
+    template<typename Scalar>
+    double to_double(const Scalar& x)
+    {
+        if constexpr (std::is_arithmetic_v<Scalar>) return double(x);
+        else return x.toDouble();
+    }
+
+    // Unevaluated sum hi + lo, |lo| at most half an ulp of hi.
+    struct dd
+    {
+        double hi{};
+        double lo{};
+    };
+
+    inline dd two_sum(double a, double b)
+    {
+        double s = a + b;
+        double bb = s - a;
+        return { s, (a - (s - bb)) + (b - bb) };
+    }
+
+    inline dd fast_two_sum(double a, double b)
+    {
+        double s = a + b;
+        return { s, b - (s - a) };
+    }
+
+    inline dd two_prod(double a, double b)
+    {
+        double p = a * b;
+        return { p, std::fma(a, b, -p) };
+    }
+
+    inline dd operator+(dd a, dd b)
+    {
+        dd s = two_sum(a.hi, b.hi);
+        dd t = two_sum(a.lo, b.lo);
+        s = fast_two_sum(s.hi, s.lo + t.hi);
+        return fast_two_sum(s.hi, s.lo + t.lo);
+    }
+
+    struct reference
+    {
+        Eigen::MatrixXd hi;
+        Eigen::MatrixXd lo;
+    };
+
+    template<typename Derived>
+    Eigen::MatrixXd exact_double(const Eigen::MatrixBase<Derived>& m)
+    {
+        Eigen::MatrixXd out(m.rows(), m.cols());
+        for (Eigen::Index j{}; j < m.cols(); ++j)
+            for (Eigen::Index i{}; i < m.rows(); ++i) out(i, j) = to_double(m.coeff(i, j));
+        return out;
+    }
+
+    inline reference reference_product(const Eigen::MatrixXd& a, const Eigen::MatrixXd& b)
+    {
+        reference ref{ Eigen::MatrixXd(a.rows(), b.cols()), Eigen::MatrixXd(a.rows(), b.cols()) };
+        for (Eigen::Index j{}; j < b.cols(); ++j) {
+            for (Eigen::Index i{}; i < a.rows(); ++i) {
+                dd acc;
+                for (Eigen::Index k{}; k < a.cols(); ++k) acc = acc + two_prod(a(i, k), b(k, j));
+                ref.hi(i, j) = acc.hi;
+                ref.lo(i, j) = acc.lo;
+            }
+        }
+        return ref;
+    }
+
+    // a + sign * b, exact
+    inline reference reference_sum(const Eigen::MatrixXd& a, const Eigen::MatrixXd& b, double sign = 1.0)
+    {
+        reference ref{ Eigen::MatrixXd(a.rows(), a.cols()), Eigen::MatrixXd(a.rows(), a.cols()) };
+        for (Eigen::Index j{}; j < a.cols(); ++j) {
+            for (Eigen::Index i{}; i < a.rows(); ++i) {
+                dd s = two_sum(a(i, j), sign * b(i, j));
+                ref.hi(i, j) = s.hi;
+                ref.lo(i, j) = s.lo;
+            }
+        }
+        return ref;
+    }
+
+    // f of every element, evaluated in long double.
+    template<typename F>
+    reference reference_map(const Eigen::MatrixXd& a, F f)
+    {
+        reference ref{ Eigen::MatrixXd(a.rows(), a.cols()), Eigen::MatrixXd(a.rows(), a.cols()) };
+        for (Eigen::Index j{}; j < a.cols(); ++j) {
+            for (Eigen::Index i{}; i < a.rows(); ++i) {
+                long double y = f(static_cast<long double>(a(i, j)));
+                ref.hi(i, j) = double(y);
+                ref.lo(i, j) = double(y - ref.hi(i, j));
+            }
+        }
+        return ref;
+    }
+
+    // Solution of a x = b: a double LU solve refined twice with residuals
+    // accumulated in double-double, close to exact while cond(a) stays well
+    // below 1e16.
+    inline reference reference_solve(const Eigen::MatrixXd& a, const Eigen::MatrixXd& b)
+    {
+        Eigen::PartialPivLU<Eigen::MatrixXd> lu(a);
+        reference x{ lu.solve(b), Eigen::MatrixXd::Zero(b.rows(), b.cols()) };
+        Eigen::MatrixXd residual(b.rows(), b.cols());
+        for (int step{}; step < 2; ++step) {
+            for (Eigen::Index j{}; j < b.cols(); ++j) {
+                for (Eigen::Index i{}; i < a.rows(); ++i) {
+                    dd acc{ b(i, j), 0.0 };
+                    for (Eigen::Index k{}; k < a.cols(); ++k)
+                        acc = acc + two_prod(-a(i, k), x.hi(k, j)) + two_prod(-a(i, k), x.lo(k, j));
+                    residual(i, j) = acc.hi;
+                }
+            }
+            Eigen::MatrixXd correction = lu.solve(residual);
+            for (Eigen::Index j{}; j < b.cols(); ++j) {
+                for (Eigen::Index i{}; i < b.rows(); ++i) {
+                    dd s = two_sum(x.hi(i, j), correction(i, j));
+                    s = fast_two_sum(s.hi, s.lo + x.lo(i, j));
+                    x.hi(i, j) = s.hi;
+                    x.lo(i, j) = s.lo;
+                }
+            }
+        }
+        return x;
+    }
+
+    struct least_squares_reference
+    {
+        reference x;
+        reference residual;
+    };
+
+    // Least-squares solution of a x = b, a m x n with m >= n and full rank,
+    // and its residual b - a x, from the augmented system
+    // [I a; a^T 0] [r; x] = [b; 0] through reference_solve.
+    inline least_squares_reference reference_lstsq(const Eigen::MatrixXd& a, const Eigen::MatrixXd& b)
+    {
+        Eigen::Index m = a.rows(), n = a.cols();
+        Eigen::MatrixXd augmented = Eigen::MatrixXd::Zero(m + n, m + n);
+        augmented.topLeftCorner(m, m).setIdentity();
+        augmented.topRightCorner(m, n) = a;
+        augmented.bottomLeftCorner(n, m) = a.transpose();
+        Eigen::MatrixXd rhs = Eigen::MatrixXd::Zero(m + n, b.cols());
+        rhs.topRows(m) = b;
+        reference solution = reference_solve(augmented, rhs);
+        return { { solution.hi.bottomRows(n), solution.lo.bottomRows(n) }, { solution.hi.topRows(m), solution.lo.topRows(m) } };
+    }
+
+    // Distance between the two values of Scalar around x; at a value of
+    // Scalar, the step away from zero.
+    template<typename Scalar>
+    double ulp_at(double x)
+    {
+        double ax = std::fabs(x);
+        if constexpr (std::is_floating_point_v<Scalar>) {
+            Scalar below = Scalar(ax);
+            if (double(below) > ax) below = std::nextafter(below, Scalar(0));
+            return double(std::nextafter(below, std::numeric_limits<Scalar>::infinity())) - double(below);
+        } else {
+            Scalar below = Scalar(ax);
+            if (to_double(below) > ax) --below.value;
+            Scalar above = below;
+            ++above.value;
+            // maxpos has no successor
+            if (!(to_double(above) > to_double(below))) above = below, --below.value;
+            return to_double(above) - to_double(below);
+        }
+    }
+
+    // Bins of the decimal accuracy histogram: [0] fewer than one correct
+    // digit (wrong sign, NaR, zero for nonzero), [k] k to k + 1 digits,
+    // [10] ten or more, [11] exact.
+    constexpr int decimal_bins = 12;
+    // decimal accuracy credited to an exact result
+    constexpr double exact_decimals = 17.0;
+
+    struct accuracy
+    {
+        double max_abs{ std::numeric_limits<double>::quiet_NaN() };
+        double mean_abs{ std::numeric_limits<double>::quiet_NaN() };
+        double max_rel{ std::numeric_limits<double>::quiet_NaN() };
+        double mean_rel{ std::numeric_limits<double>::quiet_NaN() };
+        double max_ulp{ std::numeric_limits<double>::quiet_NaN() };
+        double mean_ulp{ std::numeric_limits<double>::quiet_NaN() };
+        double min_decimals{ std::numeric_limits<double>::quiet_NaN() };
+        double mean_decimals{ std::numeric_limits<double>::quiet_NaN() };
+        // results that are NaR, NaN or infinite against a finite reference
+        long invalid{};
+        // nonzero results against a reference of exactly zero; zero references
+        // have no relative error and are left out of max_rel and mean_rel
+        long zero_reference{};
+        std::array<long, decimal_bins> histogram{};
+        // ulp error per element, NaN where invalid
+        Eigen::MatrixXd ulp_map;
+
+        bool measured() const { return !std::isnan(mean_decimals); }
+    };
+
+    template<typename Derived>
+    accuracy compare(const Eigen::MatrixBase<Derived>& result, const reference& ref)
+    {
+        typedef typename Derived::Scalar Scalar;
+        accuracy acc;
+        acc.max_abs = acc.mean_abs = acc.max_rel = acc.mean_rel = acc.max_ulp = acc.mean_ulp = acc.mean_decimals = 0.0;
+        acc.min_decimals = exact_decimals;
+        acc.ulp_map.resize(result.rows(), result.cols());
+
+        long valid{}, relative{};
+        for (Eigen::Index j{}; j < result.cols(); ++j) {
+            for (Eigen::Index i{}; i < result.rows(); ++i) {
+                double x = to_double(result.coeff(i, j));
+                double hi = ref.hi(i, j), lo = ref.lo(i, j);
+                if (!std::isfinite(x)) {
+                    ++acc.invalid;
+                    ++acc.histogram[0];
+                    acc.min_decimals = 0.0;
+                    acc.ulp_map(i, j) = std::numeric_limits<double>::quiet_NaN();
+                    continue;
+                }
+                dd diff = two_sum(x, -hi);
+                double err = diff.hi + (diff.lo - lo);
+                double abs_err = std::fabs(err);
+                double ulp = abs_err / ulp_at<Scalar>(hi);
+
+                double decimals;
+                if (abs_err == 0.0) decimals = exact_decimals;
+                else if (x == 0.0 || hi == 0.0 || (x < 0.0) != (hi < 0.0)) decimals = 0.0;
+                else decimals = std::clamp(-std::log10(std::fabs(std::log1p(err / hi)) / std::log(10.0)), 0.0, exact_decimals);
+                acc.histogram[abs_err == 0.0 ? decimal_bins - 1 : std::min(int(decimals), decimal_bins - 2)]++;
+
+                if (hi == 0.0) {
+                    if (abs_err != 0.0) ++acc.zero_reference;
+                } else {
+                    double rel = abs_err / std::fabs(hi);
+                    acc.max_rel = std::max(acc.max_rel, rel);
+                    acc.mean_rel += rel;
+                    ++relative;
+                }
+
+                acc.max_abs = std::max(acc.max_abs, abs_err);
+                acc.max_ulp = std::max(acc.max_ulp, ulp);
+                acc.min_decimals = std::min(acc.min_decimals, decimals);
+                acc.mean_abs += abs_err;
+                acc.mean_ulp += ulp;
+                acc.mean_decimals += decimals;
+                acc.ulp_map(i, j) = ulp;
+                ++valid;
+            }
+        }
+        if (valid) {
+            acc.mean_abs /= valid;
+            acc.mean_ulp /= valid;
+            acc.mean_decimals /= valid;
+        }
+        if (relative) acc.mean_rel /= relative;
+        else acc.max_rel = acc.mean_rel = std::numeric_limits<double>::quiet_NaN();
+        return acc;
+    }
+
+    // One row per matrix row, comma separated; empty where invalid.
+    inline void write_error_map(std::ostream& out, const Eigen::MatrixXd& map)
+    {
+        for (Eigen::Index i{}; i < map.rows(); ++i) {
+            for (Eigen::Index j{}; j < map.cols(); ++j) {
+                if (j) out << ',';
+                if (!std::isnan(map(i, j))) out << map(i, j);
+            }
+            out << '\n';
+        }
+    }
+}
@@ -0,0 +1,193 @@
+#include "softposit_cpp.h"
+#include "../posit/cast.h"
+#include "../posit/lut_packet_math.h"
+#include "../posit/packet_math.h"
+#include "../posit/parallel.h"
+#include "../posit/posit.h"
+#include "harness.h"
+#include <Eigen/Core>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Measures the cost of posit add, mul, div, sqrt and conversion on this host
+// and writes them, in Eigen's unit of one scalar float add, as the header
+// posit/costs.h includes when EIGEN_POSIT_COSTS_HEADER names it:
+//
+//     ./bench/calibrate build/posit_costs.h
+//
+// Every posit operation is timed as an Eigen array expression, out = a + b
+// and so on, over operands large enough to defeat branch prediction, so it
+// takes the path Eigen takes: the packet math of packet_math.h and
+// lut_packet_math.h where the type vectorizes, the runtime-dispatched
+// kernels included, and whole-array casts from cast.h, on one thread. The
+// time of a plain copy, out = a, is subtracted. The unit is a scalar float
+// add, one result per element with a compiler barrier in between so nothing
+// vectorizes, less the same loop copying instead of adding. Arithmetic
+// done in software, posit32's and posit<N, ES>'s, costs several of those; a
+// table lookup (posit8 and posit16 arithmetic) or a conversion costs at
+// least one. An operation measured below its floor means the measurement
+// failed, and no header is written.
+
+namespace
+{
+    constexpr int operands = 4096;
+    constexpr double software_floor = 3.0, lookup_floor = 1.0;
+
+    bench::options timing()
+    {
+        bench::options opt;
+        opt.budget = std::chrono::milliseconds(50);
+        return opt;
+    }
+
+    // Median ns per element of out[i] = op(i).
+    template<typename T, typename F>
+    double per_element(std::vector<T>& out, F&& op)
+    {
+        bench::result r = bench::measure([&] {
+            for (int i{}; i < operands; ++i) {
+                out[i] = op(i);
+                bench::do_not_optimize(out[i]);
+            }
+        }, timing());
+        return r.median * 1000.0 / operands;
+    }
+
+    // Median ns per element of the array assignment assign(), which writes out.
+    template<typename Out, typename F>
+    double per_array_element(Out& out, F&& assign)
+    {
+        bench::result r = bench::measure([&] {
+            assign();
+            bench::do_not_optimize(out);
+        }, timing());
+        return r.median * 1000.0 / operands;
+    }
+
+    struct timings
+    {
+        double add, mul, div, sqrt, convert;
+    };
+
+    template<typename Posit>
+    timings time_posit(std::mt19937_64& rng)
+    {
+        typedef Eigen::Array<Posit, Eigen::Dynamic, 1> Array;
+        // magnitudes spread over [2^-8, 2^8], random signs
+        std::uniform_real_distribution<double> exponent(-8.0, 8.0);
+        Array a(operands), b(operands), out(operands);
+        Eigen::ArrayXf f(operands);
+        Eigen::ArrayXd d(operands);
+        for (int i{}; i < operands; ++i) {
+            a[i] = Posit(std::exp2(exponent(rng)) * (rng() & 1 ? 1.0 : -1.0));
+            b[i] = Posit(std::exp2(exponent(rng)) * (rng() & 1 ? 1.0 : -1.0));
+            f[i] = float(std::exp2(exponent(rng)));
+        }
+
+        double copy = per_array_element(out, [&] { out = a; });
+        timings t;
+        t.add = per_array_element(out, [&] { out = a + b; }) - copy;
+        t.mul = per_array_element(out, [&] { out = a * b; }) - copy;
+        t.div = per_array_element(out, [&] { out = a / b; }) - copy;
+        a = a.abs();
+        t.sqrt = per_array_element(out, [&] { out = a.sqrt(); }) - copy;
+        double from = per_array_element(out, [&] { out = f.template cast<Posit>(); });
+        double to = per_array_element(d, [&] { d = a.template cast<double>(); });
+        t.convert = (from + to) / 2 - copy;
+        return t;
+    }
+
+    double time_float_add(std::mt19937_64& rng)
+    {
+        std::uniform_real_distribution<float> value(-100.0f, 100.0f);
+        std::vector<float> a(operands), b(operands), out(operands);
+        for (int i{}; i < operands; ++i) {
+            a[i] = value(rng);
+            b[i] = value(rng);
+        }
+        double add = per_element(out, [&](int i) { return Eigen::internal::scalar_sum_op<float, float>()(a[i], b[i]); });
+        return add - per_element(out, [&](int i) { return a[i]; });
+    }
+
+    int units(double ns, double unit) { return int(ns / unit + 0.5); }
+
+    // The operations of t measured below their floor in float adds, comma
+    // separated; arithmetic has arithmetic_floor, conversion lookup_floor.
+    std::string too_cheap(const timings& t, double unit, double arithmetic_floor)
+    {
+        const char* names[] = { "add", "mul", "div", "sqrt", "convert" };
+        double ns[] = { t.add, t.mul, t.div, t.sqrt, t.convert };
+        std::string list;
+        for (int i{}; i < 5; ++i)
+            if (!(ns[i] >= (i < 4 ? arithmetic_floor : lookup_floor) * unit)) list += (list.empty() ? "" : ", ") + std::string(names[i]);
+        return list;
+    }
+
+    std::string costs_line(const char* name, const timings& t, double unit)
+    {
+        char line[160];
+        std::snprintf(line, sizeof(line), "    constexpr op_costs %s{ %d, %d, %d, %d, %d };\n", name,
+                      units(t.add, unit), units(t.mul, unit), units(t.div, unit), units(t.sqrt, unit), units(t.convert, unit));
+        return line;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::mt19937_64 rng(2024);
+    // the whole-array casts would otherwise split across the posit pool
+    eigen_posit::set_num_threads(1);
+    double unit = time_float_add(rng);
+
+    const char* names[] = { "softposit8", "softposit16", "softposit32", "header8", "header16", "header32" };
+    timings measured[] = {
+        time_posit<posit8>(rng),
+        time_posit<posit16>(rng),
+        time_posit<posit32>(rng),
+        time_posit<eigen_posit::posit<8, 0>>(rng),
+        time_posit<eigen_posit::posit<16, 1>>(rng),
+        time_posit<eigen_posit::posit<32, 2>>(rng),
+    };
+
+    std::cerr << "float add: " << unit << " ns\n";
+    for (int i{}; i < 6; ++i)
+        std::cerr << names[i] << ": add " << measured[i].add << " ns, mul " << measured[i].mul << " ns, div "
+                  << measured[i].div << " ns, sqrt " << measured[i].sqrt << " ns, convert " << measured[i].convert << " ns\n";
+
+    bool valid = unit > 0.0;
+    if (!valid) std::cerr << "float add measured no slower than a copy\n";
+    for (int i{}; i < 6; ++i) {
+        // posit8 and posit16 arithmetic are table lookups
+        std::string cheap = too_cheap(measured[i], unit, i < 2 ? lookup_floor : software_floor);
+        if (cheap.empty()) continue;
+        std::cerr << names[i] << ": " << cheap << " below its floor in float adds\n";
+        valid = false;
+    }
+    if (!valid) {
+        std::cerr << "Costs not written\n";
+        return 1;
+    }
+
+    std::string header =
+        "#pragma once\n"
+        "\n"
+        "// Posit operation costs measured by bench/calibrate on the build host, in\n"
+        "// Eigen's unit of one scalar float add; included by posit/costs.h.\n"
+        "namespace eigen_posit\n"
+        "{\n"
+        "namespace costs\n"
+        "{\n";
+    for (int i{}; i < 6; ++i) header += costs_line(names[i], measured[i], unit);
+    header += "}\n}\n";
+
+    if (argc > 1) {
+        std::ofstream(argv[1]) << header;
+        std::cerr << "Wrote " << argv[1] << "\n";
+    } else
+        std::cout << header;
+    return 0;
+}
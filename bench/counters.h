@@ -0,0 +1,128 @@
+#pragma once
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <utility>
+
+#if defined(__linux__) && __has_include(<linux/perf_event.h>)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define EIGEN_POSIT_BENCH_PERF 1
+#endif
+
+// Hardware performance counters around a benchmarked span, through Linux
+// perf_event_open: cycles, instructions, L1 data read misses, last-level
+// cache misses and branch misses, user space only, on the calling thread.
+//
+// Each counter opens on its own, so a host that offers some of them (VMs
+// often lack the cache events) still reports the rest; the kernel may then
+// multiplex them, and the counts are scaled by the share of the span each
+// one ran. Counters that will not open, in containers without
+// perf_event_paranoid access or off Linux, read as NaN and error() says why.
+namespace bench
+{
+    constexpr int counter_count = 5;
+    constexpr const char* counter_names[counter_count] = { "cycles", "instructions", "l1_misses", "llc_misses", "branch_misses" };
+
+    typedef std::array<double, counter_count> counter_values;
+
+    inline counter_values no_counts()
+    {
+        counter_values values;
+        values.fill(std::numeric_limits<double>::quiet_NaN());
+        return values;
+    }
+
+    class counters
+    {
+    public:
+        counters()
+        {
+            fds.fill(-1);
+#ifdef EIGEN_POSIT_BENCH_PERF
+            const std::pair<uint32_t, uint64_t> events[counter_count] = {
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+                { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+            };
+            for (int i{}; i < counter_count; ++i) {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = events[i].first;
+                attr.config = events[i].second;
+                attr.disabled = 1;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                fds[i] = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+                if (fds[i] < 0 && message.empty())
+                    message = std::string(counter_names[i]) + ": perf_event_open: " + std::strerror(errno);
+            }
+#else
+            message = "perf_event_open needs Linux";
+#endif
+        }
+
+        ~counters()
+        {
+#ifdef EIGEN_POSIT_BENCH_PERF
+            for (int fd : fds)
+                if (fd >= 0) close(fd);
+#endif
+        }
+
+        counters(const counters&) = delete;
+        counters& operator=(const counters&) = delete;
+
+        bool available() const
+        {
+            for (int fd : fds)
+                if (fd >= 0) return true;
+            return false;
+        }
+
+        // The first counter that failed to open and why; empty if all opened.
+        const std::string& error() const { return message; }
+
+        void start()
+        {
+#ifdef EIGEN_POSIT_BENCH_PERF
+            for (int fd : fds) {
+                if (fd < 0) continue;
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+        }
+
+        // Counts since start(), NaN for counters that are not open or never ran.
+        counter_values stop()
+        {
+            counter_values values = no_counts();
+#ifdef EIGEN_POSIT_BENCH_PERF
+            for (int fd : fds)
+                if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            for (int i{}; i < counter_count; ++i) {
+                // value, time enabled, time running
+                uint64_t data[3];
+                if (fds[i] < 0 || read(fds[i], data, sizeof(data)) != ssize_t(sizeof(data)) || data[2] == 0) continue;
+                values[i] = double(data[0]) * double(data[1]) / double(data[2]);
+            }
+#endif
+            return values;
+        }
+
+    private:
+        std::array<int, counter_count> fds;
+        std::string message;
+    };
+}
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "softposit_cpp.h"
+#include "../posit/posit.h"
+#include "accuracy.h"
+#include "counters.h"
+
+// Micro-benchmark harness.
+//
+// measure() runs an operation a few times to warm caches and lazily built
+// tables, estimates its cost, and then takes enough timed samples to fill
+// a time budget. Operations faster than sample_floor are batched so each
+// sample spans at least that long and the clock's own cost stays out of the
+// numbers. Results keep the whole distribution summary (min, median, p95,
+// p99) rather than a mean, and write as CSV or JSON. The operation must do
+// its work through side effects (assign into a preallocated output), since
+// an expression template that is never evaluated costs nothing.
+namespace bench
+{
+    using clock = std::chrono::steady_clock;
+
+    struct options
+    {
+        int warmup = 3;
+        int min_samples = 10;
+        int max_samples = 10000;
+        // total timed budget per operation
+        std::chrono::microseconds budget{ 200000 };
+        // shortest sample; faster operations are repeated inside one sample
+        std::chrono::microseconds sample_floor{ 20 };
+        // if set, hardware counters around the timed samples
+        counters* hardware{};
+    };
+
+    struct result
+    {
+        std::string operation;
+        std::string scalar;
+        long rows{};
+        long cols{};
+        std::string input;
+        int threads{ 1 };
+        int samples{};
+        int batch{};
+        // microseconds per call
+        double min{};
+        double median{};
+        double p95{};
+        double p99{};
+        double mean{};
+        // work per call, zero when not counted: arithmetic operations, result
+        // elements and compulsory memory traffic (operands read once, result
+        // written once)
+        double flops{};
+        double elements{};
+        double bytes{};
+        // hardware counts per call; NaN unless options::hardware was set and the counter opened
+        counter_values counts = no_counts();
+        // share of the host's roofline reached at the median; NaN unless measured
+        double roofline_fraction{ std::numeric_limits<double>::quiet_NaN() };
+        // against the double-double reference; unmeasured unless acc.measured()
+        accuracy acc;
+
+        double gflops() const { return flops / median / 1e3; }
+        double gbytes_per_s() const { return bytes / median / 1e3; }
+    };
+
+    // Keeps the compiler from discarding a result that is never read.
+    template<typename T>
+    inline void do_not_optimize(const T& value)
+    {
+        asm volatile("" : : "r"(&value) : "memory");
+    }
+
+    template<typename Scalar> const char* scalar_name();
+    template<> inline const char* scalar_name<float>() { return "float"; }
+    template<> inline const char* scalar_name<double>() { return "double"; }
+    template<> inline const char* scalar_name<Eigen::half>() { return "half"; }
+    template<> inline const char* scalar_name<Eigen::bfloat16>() { return "bfloat16"; }
+    template<> inline const char* scalar_name<posit8>() { return "posit8"; }
+    template<> inline const char* scalar_name<posit16>() { return "posit16"; }
+    template<> inline const char* scalar_name<posit32>() { return "posit32"; }
+    template<> inline const char* scalar_name<eigen_posit::posit<16, 1>>() { return "posit16_header"; }
+    template<> inline const char* scalar_name<eigen_posit::posit<32, 2>>() { return "posit32_header"; }
+
+    // Nearest-rank percentile of sorted samples, p in [0, 1].
+    inline double percentile(const std::vector<double>& sorted, double p)
+    {
+        std::size_t rank = std::size_t(std::ceil(p * double(sorted.size())));
+        return sorted[std::min(sorted.size() - 1, rank == 0 ? 0 : rank - 1)];
+    }
+
+    template<typename F>
+    result measure(F&& op, const options& opt = {})
+    {
+        using std::chrono::duration;
+        for (int i{}; i < opt.warmup; ++i) op();
+
+        auto start = clock::now();
+        op();
+        double estimate = std::max(1e-3, duration<double, std::micro>(clock::now() - start).count());
+
+        double floor = double(opt.sample_floor.count());
+        int batch = estimate < floor ? int(std::ceil(floor / estimate)) : 1;
+        double per_sample = estimate * batch;
+        int samples = int(std::clamp(double(opt.budget.count()) / per_sample, double(opt.min_samples), double(opt.max_samples)));
+
+        std::vector<double> times(samples);
+        if (opt.hardware) opt.hardware->start();
+        for (double& t : times) {
+            auto begin = clock::now();
+            for (int i{}; i < batch; ++i) op();
+            t = duration<double, std::micro>(clock::now() - begin).count() / batch;
+        }
+
+        result r;
+        if (opt.hardware) {
+            r.counts = opt.hardware->stop();
+            for (double& c : r.counts) c /= double(samples) * batch;
+        }
+        r.samples = samples;
+        r.batch = batch;
+        r.mean = 0;
+        for (double t : times) r.mean += t;
+        r.mean /= samples;
+        std::sort(times.begin(), times.end());
+        r.min = times.front();
+        r.median = percentile(times, 0.5);
+        r.p95 = percentile(times, 0.95);
+        r.p99 = percentile(times, 0.99);
+        return r;
+    }
+
+    inline void write_csv(std::ostream& out, const std::vector<result>& results)
+    {
+        out << "operation,scalar,rows,cols,input,threads,samples,batch,min_us,median_us,p95_us,p99_us,mean_us,"
+               "flops,bytes,gflops,gbytes_per_s,roofline_fraction,"
+               "cycles_per_element,instructions_per_element,l1_misses_per_element,llc_misses_per_element,branch_misses_per_element,"
+               "cycles_per_flop,instructions_per_flop,l1_misses_per_flop,llc_misses_per_flop,branch_misses_per_flop,"
+               "mean_abs_error,max_abs_error,mean_rel_error,max_rel_error,mean_ulp,max_ulp,mean_decimals,min_decimals,invalid,"
+               "zero_reference";
+        for (int b{}; b < decimal_bins; ++b) out << ",decimals_" << (b == decimal_bins - 1 ? std::string("exact") : std::to_string(b));
+        out << '\n';
+        for (const result& r : results) {
+            out << r.operation << ',' << r.scalar << ',' << r.rows << ',' << r.cols << ',' << r.input << ',' << r.threads << ','
+                << r.samples << ',' << r.batch << ',' << r.min << ',' << r.median << ',' << r.p95 << ','
+                << r.p99 << ',' << r.mean << ',';
+            if (r.flops > 0) out << r.flops << ',' << r.bytes << ',' << r.gflops() << ',' << r.gbytes_per_s();
+            else out << ",,,";
+            out << ',';
+            if (!std::isnan(r.roofline_fraction)) out << r.roofline_fraction;
+            for (double per : { r.elements, r.flops })
+                for (double c : r.counts) {
+                    out << ',';
+                    if (!std::isnan(c) && per > 0) out << c / per;
+                }
+            const accuracy& a = r.acc;
+            if (a.measured()) {
+                out << ',' << a.mean_abs << ',' << a.max_abs << ',' << a.mean_rel << ',' << a.max_rel << ',' << a.mean_ulp << ','
+                    << a.max_ulp << ',' << a.mean_decimals << ',' << a.min_decimals << ',' << a.invalid << ',' << a.zero_reference;
+                for (long count : a.histogram) out << ',' << count;
+            } else
+                out << std::string(10 + decimal_bins, ',');
+            out << '\n';
+        }
+    }
+
+    // A double as a JSON value: JSON has no NaN or infinity, so those are null.
+    struct json_number
+    {
+        double value;
+    };
+
+    inline std::ostream& operator<<(std::ostream& out, json_number x)
+    {
+        if (std::isfinite(x.value)) return out << x.value;
+        return out << "null";
+    }
+
+    inline void write_json(std::ostream& out, const std::vector<result>& results)
+    {
+        out << "[\n";
+        for (std::size_t i{}; i < results.size(); ++i) {
+            const result& r = results[i];
+            out << "  {\"operation\": \"" << r.operation << "\", \"scalar\": \"" << r.scalar
+                << "\", \"rows\": " << r.rows << ", \"cols\": " << r.cols << ", \"input\": \"" << r.input
+                << "\", \"threads\": " << r.threads << ", \"samples\": " << r.samples << ", \"batch\": " << r.batch
+                << ", \"min_us\": " << json_number{ r.min } << ", \"median_us\": " << json_number{ r.median }
+                << ", \"p95_us\": " << json_number{ r.p95 } << ", \"p99_us\": " << json_number{ r.p99 }
+                << ", \"mean_us\": " << json_number{ r.mean } << ", \"throughput\": ";
+            if (r.flops > 0) {
+                out << "{\"flops\": " << json_number{ r.flops } << ", \"bytes\": " << json_number{ r.bytes }
+                    << ", \"gflops\": " << json_number{ r.gflops() } << ", \"gbytes_per_s\": " << json_number{ r.gbytes_per_s() }
+                    << ", \"roofline_fraction\": " << json_number{ r.roofline_fraction } << "}";
+            } else
+                out << "null";
+            out << ", \"counters\": ";
+            if (std::all_of(r.counts.begin(), r.counts.end(), [](double c) { return std::isnan(c); })) out << "null";
+            else {
+                const char* per_name[] = { "per_element", "per_flop" };
+                const double per[] = { r.elements, r.flops };
+                out << "{";
+                for (int p{}; p < 2; ++p) {
+                    out << (p ? ", \"" : "\"") << per_name[p] << "\": {";
+                    for (int c{}; c < counter_count; ++c) {
+                        out << (c ? ", \"" : "\"") << counter_names[c] << "\": ";
+                        out << json_number{ per[p] > 0 ? r.counts[c] / per[p] : std::numeric_limits<double>::quiet_NaN() };
+                    }
+                    out << "}";
+                }
+                out << "}";
+            }
+            out << ", \"accuracy\": ";
+            const accuracy& a = r.acc;
+            if (!a.measured()) out << "null";
+            else {
+                out << "{\"mean_abs_error\": " << json_number{ a.mean_abs } << ", \"max_abs_error\": " << json_number{ a.max_abs }
+                    << ", \"mean_rel_error\": " << json_number{ a.mean_rel } << ", \"max_rel_error\": " << json_number{ a.max_rel }
+                    << ", \"mean_ulp\": " << json_number{ a.mean_ulp } << ", \"max_ulp\": " << json_number{ a.max_ulp }
+                    << ", \"mean_decimals\": " << json_number{ a.mean_decimals } << ", \"min_decimals\": " << json_number{ a.min_decimals }
+                    << ", \"invalid\": " << a.invalid << ", \"zero_reference\": " << a.zero_reference << ", \"decimal_histogram\": [";
+                for (int b{}; b < decimal_bins; ++b) out << (b ? ", " : "") << a.histogram[b];
+                out << "]}";
+            }
+            out << (i + 1 < results.size() ? "},\n" : "}\n");
+        }
+        out << "]\n";
+    }
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include "../posit/parallel.h"
+#include <Eigen/Core>
+#include <Eigen/QR>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <random>
+#include <tuple>
+#include <type_traits>
+
+// Seeded input matrices for the benchmarks.
+//
+// An input_spec names a distribution and its parameters:
+//
+//   constant      every element p0
+//   uniform       uniform on [p0, p1)
+//   log_uniform   magnitude log-uniform on [p0, p1), random sign
+//   normal        normal with mean p0, standard deviation p1
+//   heavy_tailed  Student's t with p0 degrees of freedom, scaled by p1
+//   sparse        fraction p0 of the elements standard normal, the rest 0
+//   conditioned   U * S * V^T with U, V random orthogonal and singular
+//                 values spaced geometrically from 1 down to 1 / p0
+//   covariance    U * S * U^T, symmetric positive definite, eigenvalues
+//                 spaced geometrically from 1 down to 1 / p0 (square only)
+//
+// Elements are drawn in double, column by column on the posit thread pool;
+// each column has its own generator seeded from the spec's seed and the
+// column index, so the values do not depend on the thread count. The same
+// pass rounds every element into each of the input_set's scalar types, and
+// input_cache keeps the sets, so every type and every sweep over the same
+// spec and size sees the same matrix.
+namespace bench
+{
+    enum class distribution { constant, uniform, log_uniform, normal, heavy_tailed, sparse, conditioned, covariance };
+
+    struct input_spec
+    {
+        distribution kind{ distribution::constant };
+        double p0{};
+        double p1{};
+        uint64_t seed{ 1 };
+    };
+
+namespace detail
+{
+    inline uint64_t splitmix64(uint64_t x)
+    {
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    // Haar-distributed random orthogonal n x n matrix.
+    inline Eigen::MatrixXd random_orthogonal(Eigen::Index n, std::mt19937_64& rng)
+    {
+        std::normal_distribution<double> normal;
+        Eigen::MatrixXd g(n, n);
+        for (Eigen::Index j{}; j < n; ++j)
+            for (Eigen::Index i{}; i < n; ++i) g(i, j) = normal(rng);
+        Eigen::HouseholderQR<Eigen::MatrixXd> qr(g);
+        Eigen::MatrixXd q = qr.householderQ();
+        for (Eigen::Index j{}; j < n; ++j)
+            if (qr.matrixQR()(j, j) < 0) q.col(j) = -q.col(j);
+        return q;
+    }
+
+    inline Eigen::MatrixXd conditioned(Eigen::Index rows, Eigen::Index cols, double condition, uint64_t seed)
+    {
+        std::mt19937_64 rng(splitmix64(seed));
+        Eigen::Index m = std::min(rows, cols);
+        Eigen::VectorXd singular(m);
+        for (Eigen::Index k{}; k < m; ++k) singular(k) = m > 1 ? std::pow(condition, -double(k) / double(m - 1)) : 1.0;
+        Eigen::MatrixXd u = random_orthogonal(rows, rng);
+        Eigen::MatrixXd v = random_orthogonal(cols, rng);
+        return u.leftCols(m) * singular.asDiagonal() * v.leftCols(m).transpose();
+    }
+
+    inline Eigen::MatrixXd covariance(Eigen::Index n, double condition, uint64_t seed)
+    {
+        std::mt19937_64 rng(splitmix64(seed));
+        Eigen::VectorXd eigenvalues(n);
+        for (Eigen::Index k{}; k < n; ++k) eigenvalues(k) = n > 1 ? std::pow(condition, -double(k) / double(n - 1)) : 1.0;
+        Eigen::MatrixXd u = random_orthogonal(n, rng);
+        Eigen::MatrixXd c = u * eigenvalues.asDiagonal() * u.transpose();
+        // exactly symmetric, so every scalar type rounds it to a symmetric matrix
+        return (c + c.transpose()) / 2;
+    }
+
+    template<typename Rng>
+    double draw(const input_spec& spec, Rng& rng)
+    {
+        switch (spec.kind) {
+        case distribution::constant:
+            return spec.p0;
+        case distribution::uniform:
+            return std::uniform_real_distribution<double>(spec.p0, spec.p1)(rng);
+        case distribution::log_uniform: {
+            double magnitude = std::exp(std::uniform_real_distribution<double>(std::log(spec.p0), std::log(spec.p1))(rng));
+            return rng() & 1 ? magnitude : -magnitude;
+        }
+        case distribution::normal:
+            return std::normal_distribution<double>(spec.p0, spec.p1)(rng);
+        case distribution::heavy_tailed:
+            return spec.p1 * std::student_t_distribution<double>(spec.p0)(rng);
+        case distribution::sparse:
+            return std::uniform_real_distribution<double>()(rng) < spec.p0 ? std::normal_distribution<double>()(rng) : 0.0;
+        default:
+            return 0.0;
+        }
+    }
+}
+
+    // One generated matrix, in double as drawn and rounded to each of Scalars.
+    template<typename... Scalars>
+    class input_set
+    {
+    public:
+        input_set(const input_spec& spec, Eigen::Index rows, Eigen::Index cols)
+            : values(rows, cols), copies(Eigen::Matrix<Scalars, Eigen::Dynamic, Eigen::Dynamic>(rows, cols)...)
+        {
+            bool generated = spec.kind == distribution::conditioned || spec.kind == distribution::covariance;
+            if (spec.kind == distribution::conditioned) values = detail::conditioned(rows, cols, spec.p0, spec.seed);
+            if (spec.kind == distribution::covariance) values = detail::covariance(rows, spec.p0, spec.seed);
+            // drawing and rounding an element costs a few multiply-adds
+            eigen_posit::parallel_slices(cols, Eigen::Index(1), 4.0 * double(rows), [&](Eigen::Index begin, Eigen::Index end) {
+                for (Eigen::Index j = begin; j < end; ++j) {
+                    std::mt19937_64 rng(detail::splitmix64(spec.seed ^ detail::splitmix64(uint64_t(j))));
+                    if (!generated)
+                        for (Eigen::Index i{}; i < rows; ++i) values(i, j) = detail::draw(spec, rng);
+                    ((std::get<Eigen::Matrix<Scalars, Eigen::Dynamic, Eigen::Dynamic>>(copies).col(j) = values.col(j).template cast<Scalars>()), ...);
+                }
+            });
+        }
+
+        template<typename Scalar>
+        const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>& as() const
+        {
+            if constexpr (std::is_same_v<Scalar, double>) return values;
+            else return std::get<Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>>(copies);
+        }
+
+    private:
+        Eigen::MatrixXd values;
+        std::tuple<Eigen::Matrix<Scalars, Eigen::Dynamic, Eigen::Dynamic>...> copies;
+    };
+
+    template<typename... Scalars>
+    class input_cache
+    {
+    public:
+        const input_set<Scalars...>& get(const input_spec& spec, Eigen::Index rows, Eigen::Index cols)
+        {
+            key k{ int(spec.kind), spec.p0, spec.p1, spec.seed, rows, cols };
+            std::unique_ptr<input_set<Scalars...>>& set = sets[k];
+            if (!set) set.reset(new input_set<Scalars...>(spec, rows, cols));
+            return *set;
+        }
+
+        void clear() { sets.clear(); }
+
+    private:
+        typedef std::tuple<int, double, double, uint64_t, Eigen::Index, Eigen::Index> key;
+        std::map<key, std::unique_ptr<input_set<Scalars...>>> sets;
+    };
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "../posit/parallel.h"
+#include "harness.h"
+#include <Eigen/Core>
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+// Roofline of the host: peak float and double multiply-add throughput and
+// peak memory bandwidth, measured on the posit thread pool.
+//
+// The compute peaks run chains of independent fused multiply-adds, enough of
+// them to cover the FMA latency on every port; the bandwidth peak is a STREAM
+// triad over arrays far larger than the last-level cache. Both take the
+// fastest sample. An operation doing `flops` arithmetic over `bytes` of
+// compulsory memory traffic can then reach at most
+// min(peak flops, flops / bytes * peak bandwidth), and fraction() says how
+// much of that it achieved; the roof is DRAM bandwidth, so working sets that
+// stay in cache can pass 1. Posits, half and bfloat16 compute in software or
+// in float, so they are held against the float ceiling.
+namespace bench
+{
+    struct roofline
+    {
+        double float_gflops{};
+        double double_gflops{};
+        double gbytes_per_s{};
+        // pool threads the peaks were measured on
+        int threads{ 1 };
+
+        template<typename Scalar>
+        double peak_gflops() const { return std::is_same_v<Scalar, double> ? double_gflops : float_gflops; }
+
+        template<typename Scalar>
+        double attainable_gflops(double flops, double bytes) const
+        {
+            return std::min(peak_gflops<Scalar>(), flops / bytes * gbytes_per_s);
+        }
+
+        // Achieved over attainable for a result with flops, bytes and timing.
+        template<typename Scalar>
+        double fraction(const result& r) const
+        {
+            return r.gflops() / attainable_gflops<Scalar>(r.flops, r.bytes);
+        }
+    };
+
+namespace detail
+{
+    // Ten packets of independent chains cover two FMA ports at four cycles
+    // latency and still fit in the register file.
+    template<typename T>
+    constexpr int fma_chains = 10 * Eigen::internal::packet_traits<T>::size;
+    constexpr int fma_rounds = 1 << 16;
+
+    template<typename T>
+    void fma_kernel(T* x)
+    {
+        const T m = T(0.999999), a = T(1e-6);
+        for (int r{}; r < fma_rounds; ++r)
+            for (int i{}; i < fma_chains<T>; ++i) x[i] = x[i] * m + a;
+    }
+
+    template<typename T>
+    double peak_gflops(const options& opt)
+    {
+        const int threads = eigen_posit::num_threads();
+        std::vector<T> chains(std::size_t(threads) * fma_chains<T>, T(1));
+        result r = measure([&] {
+            eigen_posit::parallel_slices(threads, 1, eigen_posit::parallel_min_work, [&](int begin, int end) {
+                for (int t = begin; t < end; ++t) {
+                    fma_kernel(chains.data() + std::size_t(t) * fma_chains<T>);
+                    do_not_optimize(chains[std::size_t(t) * fma_chains<T>]);
+                }
+            });
+        }, opt);
+        return 2.0 * fma_chains<T> * fma_rounds * threads / r.min / 1e3;
+    }
+
+    inline double peak_bandwidth(const options& opt, std::size_t elements)
+    {
+        std::vector<double> a(elements), b(elements, 1.0), c(elements, 2.0);
+        result r = measure([&] {
+            eigen_posit::parallel_slices(std::ptrdiff_t(elements), std::ptrdiff_t(4096), eigen_posit::parallel_min_work,
+                                         [&](std::ptrdiff_t begin, std::ptrdiff_t end) {
+                for (std::ptrdiff_t i = begin; i < end; ++i) a[i] = b[i] + 3.0 * c[i];
+            });
+            do_not_optimize(a[0]);
+        }, opt);
+        return 3.0 * sizeof(double) * double(elements) / r.min / 1e3;
+    }
+}
+
+    // Roughly a second; the triad arrays take 3 * 8 * elements bytes.
+    inline roofline measure_roofline(std::size_t elements = std::size_t(1) << 24)
+    {
+        options opt;
+        opt.budget = std::chrono::milliseconds(300);
+        roofline peak;
+        peak.threads = eigen_posit::num_threads();
+        peak.float_gflops = detail::peak_gflops<float>(opt);
+        peak.double_gflops = detail::peak_gflops<double>(opt);
+        peak.gbytes_per_s = detail::peak_bandwidth(opt, elements);
+        return peak;
+    }
+}
@@ -1,138 +1,662 @@
-
 #include "softposit_cpp.h"
+#include "posit/cast.h"
+#include "posit/cholesky.h"
+#include "posit/counted.h"
+#include "posit/dispatch.h"
+#include "posit/gemm.h"
+#include "posit/lu.h"
+#include "posit/lut_gemm.h"
+#include "posit/parallel_assign.h"
+#include "posit/posit.h"
+#include "posit/qr.h"
+#include "posit/range_profile.h"
+#include "posit/redux.h"
+#include "posit/refine.h"
+#include "bench/harness.h"
+#include "bench/inputs.h"
+#include "bench/roofline.h"
 #include <Eigen/Dense>
 #include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
 
-namespace Eigen 
-{
-    template<>
-    struct NumTraits<posit16> {
-        using Self = posit16;
-        using Real = posit16;
-        using NonInteger = posit16;
-        using Nested = posit16;
-        using Literal = float;
-    
-        enum {
-            IsComplex = 0,
-            IsInteger = 0,
-            IsSigned = 1,
-            RequireInitialization = 1,
-            ReadCost = 1,
-            AddCost = 2,
-            MulCost = 2
-        };
-    
-        static inline Real epsilon() { return p16(0.00001f); }
-        static inline Real dummy_precision() { return p16(0.00001f); }
-        static inline int digits10() { return 3; }  // arbitrary safe num
+// Where per-element ulp error maps go; empty for none.
+std::string error_map_dir;
+
+// Longest matrix product per call the size sweep will start.
+double sweep_gemm_seconds{ 30.0 };
+
+// Hardware counters for every timed operation; null unless --counters on.
+std::unique_ptr<bench::counters> perf_counters;
+
+// Runs the posit thread pool and Eigen's own (OpenMP) products on the same
+// number of threads, so posit and IEEE results and the roofline compare like
+// with like. Without OpenMP Eigen stays on one thread.
+void set_threads(int threads)
+{
+    eigen_posit::set_num_threads(threads);
+    Eigen::setNbThreads(threads);
+}
+
+// dst = src, on the posit thread pool for posit types (parallel_assign.h);
+// Eigen keeps coefficient-wise IEEE expressions on the calling thread.
+template<typename Dst, typename Src>
+void assign(Dst& dst, const Src& src)
+{
+    if constexpr (eigen_posit::detail::has_posit_costs<typename Dst::Scalar>::value) eigen_posit::parallel(dst) = src;
+    else dst.noalias() = src;
+}
+
+// Operands of every benchmarked type, generated once per spec and size.
+bench::input_cache<posit32, posit16, eigen_posit::posit<32, 2>, eigen_posit::posit<16, 1>, float> inputs;
+
+// Named pair of operand distributions; B defaults to A's distribution with the next seed.
+struct input_case
+{
+    const char* name;
+    bench::input_spec a;
+    bench::input_spec b;
+};
+
+input_case constant_case(const char* name, double a, double b)
+{
+    return { name, { bench::distribution::constant, a }, { bench::distribution::constant, b } };
+}
+
+input_case random_case(const char* name, bench::distribution kind, double p0, double p1 = 0.0)
+{
+    return { name, { kind, p0, p1, 1 }, { kind, p0, p1, 2 } };
+}
+
+const std::vector<input_case>& input_cases()
+{
+    using bench::distribution;
+    static const std::vector<input_case> cases{
+        constant_case("baseline", 1.0, 2.0),
+        constant_case("precision", 1.00001, 0.99999),
+        constant_case("underflow", 1e-5, 2e-5),
+        constant_case("overflow", 1e4, 1e4),
+        random_case("uniform", distribution::uniform, -1.0, 1.0),
+        random_case("log_uniform", distribution::log_uniform, 1e-4, 1e4),
+        random_case("normal", distribution::normal, 0.0, 1.0),
+        random_case("heavy_tailed", distribution::heavy_tailed, 2.0, 1.0),
+        random_case("sparse", distribution::sparse, 0.1),
+        random_case("conditioned", distribution::conditioned, 1e6),
     };
+    return cases;
+}
+
+const input_case& input_case_named(const std::string& name)
+{
+    for (const input_case& in : input_cases())
+        if (in.name == name) return in;
+    throw std::invalid_argument("no input case " + name);
+}
+
+template<typename Scalar>
+bench::result record(std::vector<bench::result>& results, bench::result r, const char* operation, int rows, int cols, const char* input)
+{
+    r.operation = operation;
+    r.scalar = bench::scalar_name<Scalar>();
+    r.rows = rows;
+    r.cols = cols;
+    r.input = input;
+    r.threads = eigen_posit::num_threads();
+    std::cout << "\t" << r.scalar << " " << operation << " " << rows << "x" << cols << " " << input
+              << "\tmin " << r.min << " us\tmedian " << r.median << " us\tp95 " << r.p95 << " us\tp99 " << r.p99
+              << " us\t(" << r.samples << " samples)";
+    if (r.flops > 0)
+    {
+        std::cout << "\t" << r.gflops() << " GFLOPS\t" << r.gbytes_per_s() << " GB/s";
+        if (!std::isnan(r.roofline_fraction)) std::cout << "\troofline " << r.roofline_fraction;
+    }
+    if (r.elements > 0 && std::any_of(r.counts.begin(), r.counts.end(), [](double c) { return !std::isnan(c); }))
+    {
+        std::cout << "\tper element:";
+        for (int i{}; i < bench::counter_count; ++i)
+            if (!std::isnan(r.counts[i])) std::cout << " " << bench::counter_names[i] << " " << r.counts[i] / r.elements;
+    }
+    if (r.acc.measured())
+    {
+        std::cout << "\trel error mean " << r.acc.mean_rel << " max " << r.acc.max_rel << "\tulp max " << r.acc.max_ulp
+                  << "\tdecimals mean " << r.acc.mean_decimals << " min " << r.acc.min_decimals;
+        if (r.acc.zero_reference) std::cout << "\tnonzero for zero " << r.acc.zero_reference;
+        if (!error_map_dir.empty())
+        {
+            std::ofstream map(error_map_dir + "/" + r.scalar + "_" + operation + "_" + std::to_string(rows) + "x"
+                              + std::to_string(cols) + "_" + input + ".csv");
+            bench::write_error_map(map, r.acc.ulp_map);
+        }
+        // the map is written; keep the results small
+        r.acc.ulp_map.resize(0, 0);
+    }
+    std::cout << "\n";
+    results.push_back(r);
+    return r;
+}
+
+// Times C = A * B, y = A * x (x the first column of B), C = A + B and
+// C = A - B, each evaluated into a preallocated C or y, and measures the
+// accuracy of each against a double-double reference built once from the
+// operands; then times rounding A's double values into Scalar, whose error
+// is the input rounding itself.
+template<typename Scalar>
+void benchmark(std::vector<bench::result>& results, const bench::options& opt, int r, int c, const input_case& in)
+{
+    using namespace Eigen;
+
+    const char* input = in.name;
+    const Matrix<Scalar, Dynamic, Dynamic>& a = inputs.get(in.a, r, c).template as<Scalar>();
+    const Matrix<Scalar, Dynamic, Dynamic>& b = inputs.get(in.b, c, r).template as<Scalar>();
+    Matrix<Scalar, Dynamic, Dynamic> out(r, r);
+    Matrix<Scalar, Dynamic, Dynamic> sum(r, c);
+    Matrix<Scalar, Dynamic, Dynamic> bt = b.transpose();
+    Matrix<Scalar, Dynamic, 1> x = b.col(0);
+    Matrix<Scalar, Dynamic, 1> y(r);
 
-    template<>
-    struct NumTraits<posit32> {
-        using Self = posit32;
-        using Real = posit32;
-        using NonInteger = posit32;
-        using Nested = posit32;
-        using Literal = float;
-    
-        enum {
-            IsComplex = 0,
-            IsInteger = 0,
-            IsSigned = 1,
-            RequireInitialization = 1,
-            ReadCost = 1,
-            AddCost = 2,
-            MulCost = 2
+    MatrixXd da = bench::exact_double(a);
+    MatrixXd db = bench::exact_double(b);
+    MatrixXd dbt = db.transpose();
+    bench::reference product_ref = bench::reference_product(da, db);
+    bench::reference vector_ref = bench::reference_product(da, db.col(0));
+    bench::reference sum_ref = bench::reference_sum(da, dbt);
+    bench::reference difference_ref = bench::reference_sum(da, dbt, -1.0);
+
+    bench::result gemm = bench::measure([&] {
+        out.noalias() = a * b;
+        bench::do_not_optimize(out(0, 0));
+    }, opt);
+    gemm.flops = 2.0 * r * r * c;
+    gemm.elements = double(r) * r;
+    gemm.bytes = 3.0 * r * c * sizeof(Scalar);
+    gemm.acc = bench::compare(out, product_ref);
+    record<Scalar>(results, gemm, "gemm", r, c, input);
+
+    bench::result gemv = bench::measure([&] {
+        y.noalias() = a * x;
+        bench::do_not_optimize(y(0));
+    }, opt);
+    gemv.flops = 2.0 * r * c;
+    gemv.elements = r;
+    gemv.bytes = (double(r) * c + c + r) * sizeof(Scalar);
+    gemv.acc = bench::compare(y, vector_ref);
+    record<Scalar>(results, gemv, "gemv", r, c, input);
+
+    bench::result add = bench::measure([&] {
+        assign(sum, a + bt);
+        bench::do_not_optimize(sum(0, 0));
+    }, opt);
+    add.flops = add.elements = double(r) * c;
+    add.bytes = 3.0 * r * c * sizeof(Scalar);
+    add.acc = bench::compare(sum, sum_ref);
+    record<Scalar>(results, add, "add", r, c, input);
+
+    bench::result sub = bench::measure([&] {
+        assign(sum, a - bt);
+        bench::do_not_optimize(sum(0, 0));
+    }, opt);
+    sub.flops = sub.elements = double(r) * c;
+    sub.bytes = 3.0 * r * c * sizeof(Scalar);
+    sub.acc = bench::compare(sum, difference_ref);
+    record<Scalar>(results, sub, "sub", r, c, input);
+
+    const MatrixXd& values = inputs.get(in.a, r, c).template as<double>();
+    bench::result convert = bench::measure([&] {
+        sum = values.template cast<Scalar>();
+        bench::do_not_optimize(sum(0, 0));
+    }, opt);
+    convert.flops = convert.elements = double(r) * c;
+    convert.bytes = (sizeof(double) + sizeof(Scalar)) * double(r) * c;
+    convert.acc = bench::compare(sum, bench::reference{ values, MatrixXd::Zero(r, c) });
+    record<Scalar>(results, convert, "convert", r, c, input);
+}
+
+// Runs the suite's operations once in counted<Posit> on every input set and
+// prints the posit work each one did, per result element.
+template<typename Posit>
+void op_census(int n)
+{
+    using namespace Eigen;
+    typedef eigen_posit::counted<Posit> counted;
+    typedef Matrix<counted, Dynamic, Dynamic> matrix;
+    auto wrap = [](const Posit& p) { return counted(p); };
+
+    std::cout << "\t--------counted<" << bench::scalar_name<Posit>() << "> " << n << "x" << n << "--------\n";
+    for (const input_case& in : input_cases())
+    {
+        matrix a = inputs.get(in.a, n, n).template as<Posit>().unaryExpr(wrap);
+        matrix b = inputs.get(in.b, n, n).template as<Posit>().unaryExpr(wrap);
+        const MatrixXd& values = inputs.get(in.a, n, n).template as<double>();
+        matrix out(n, n);
+        auto report = [&](const char* operation, auto&& op) {
+            eigen_posit::count_scope scope;
+            op();
+            eigen_posit::op_counts c = scope.counts();
+            std::cout << "\t" << operation << " " << in.name << "\t" << c << "\tper element";
+            for (int i{}; i < eigen_posit::op_counts::kinds; ++i)
+                if (c.*eigen_posit::op_counts::fields[i])
+                    std::cout << " " << eigen_posit::op_counts::names[i] << " " << double(c.*eigen_posit::op_counts::fields[i]) / out.size();
+            std::cout << "\n";
         };
-    
-        static inline Real epsilon() { return p32(0.00001f); }
-        static inline Real dummy_precision() { return p32(0.00001f); }
-        static inline int digits10() { return 3; }  // arbitrary safe num
-    };
+        report("gemm", [&] { out.noalias() = a * b; });
+        report("add", [&] { out = a + b; });
+        report("sub", [&] { out = a - b; });
+        report("convert", [&] { out = values.template cast<counted>(); });
+    }
 }
 
-template<typename A, typename B>
-void benchmark(int r, int c, int repetitions, A&& numa, B&& numb)
+// Runs the suite's operations at n x n on every input set in range_probe,
+// sampling the inputs and every intermediate and result, and prints the
+// spread of their binary scales and the posit format recommended for a
+// relative error budget.
+void range_census(int n, double error_budget)
 {
-    assert(repetitions > 0);
-    using namespace std::chrono;
     using namespace Eigen;
+    typedef Matrix<eigen_posit::range_probe, Dynamic, Dynamic> matrix;
 
-    Matrix<posit32, Dynamic, Dynamic> pa(r, c);
-    Matrix<posit32, Dynamic, Dynamic> pb(r, c);
-
-    Matrix<float, Dynamic, Dynamic> fa(r, c);
-    Matrix<float, Dynamic, Dynamic> fb(r, c);
-
-    Matrix<double, Dynamic, Dynamic> da(r, c);
-    Matrix<double, Dynamic, Dynamic> db(r, c);
-
-    pa.fill(p32(std::forward<A>(numa)));
-    pb.fill(p32(std::forward<B>(numb)));
-    fa.fill(float(std::forward<A>(numa)));
-    fb.fill(float(std::forward<B>(numb)));
-    da.fill(std::forward<A>(numa));
-    db.fill(std::forward<B>(numb));
-
-    duration<double, std::micro> pelapsed; 
-    duration<double, std::micro> felapsed;
-    double posit_mean_error{};
-    double float_mean_error{};
-    for(int i {}; i < repetitions; ++i)
-    {
-        auto pstart = high_resolution_clock::now();
-        auto pmul = pa * pb;
-        volatile auto padd = pa + pb;
-        volatile auto pmin = pa - pb;
-        auto pend = high_resolution_clock::now();
-        pelapsed += pend - pstart;
-
-        auto fstart = high_resolution_clock::now();
-        auto fmul = fa * fb;
-        volatile auto fadd = fa + fb;
-        volatile auto fmin = fa - fb;
-        auto fend = high_resolution_clock::now();
-        felapsed += fend - fstart;
-        
-        // calculate error
-        Matrix<double, Dynamic, Dynamic> ref = da * db;
-        Matrix<double, Dynamic, Dynamic> p_to_d(r, c);
-
-        for(int row{}; row < pmul.rows(); ++row) {
-            for(int col{}; col < pmul.cols(); ++col) {
-                p_to_d(row, col) = pmul(row, col).toDouble();
-            }
-        }
+    std::cout << "\t--------range profile " << n << "x" << n << ", relative error " << error_budget << "--------\n";
+    for (const input_case& in : input_cases())
+    {
+        eigen_posit::reset_range_profile();
+        matrix a = inputs.get(in.a, n, n).as<double>().cast<eigen_posit::range_probe>();
+        matrix b = inputs.get(in.b, n, n).as<double>().cast<eigen_posit::range_probe>();
+        matrix out(n, n);
+        out.noalias() = a * b;
+        out = a + b;
+        out = a - b;
+
+        eigen_posit::range_histogram h = eigen_posit::range_profile();
+        std::cout << "\t" << in.name << "\t" << h.count() << " samples, " << h.zeros << " zero\tscales " << h.quantile(0.0)
+                  << " / " << h.quantile(0.0005) << " / " << h.quantile(0.5) << " / " << h.quantile(0.9995) << " / "
+                  << h.quantile(1.0) << " (min / 0.05% / median / 99.95% / max)\n\t\t"
+                  << eigen_posit::recommend(h, error_budget) << "\n";
+    }
+}
+
+// Times a * b at 1, 2, 4, ... threads up to the hardware concurrency and
+// reports speedup and parallel efficiency of the medians against one thread.
+// Hardware counters follow the calling thread only, so they are left out
+// above one thread. Restores the thread count it found.
+template<typename Scalar>
+void thread_sweep(std::vector<bench::result>& results, const bench::options& opt, int n)
+{
+    using namespace Eigen;
+
+    const input_case& in = input_case_named("uniform");
+    const Matrix<Scalar, Dynamic, Dynamic>& a = inputs.get(in.a, n, n).template as<Scalar>();
+    const Matrix<Scalar, Dynamic, Dynamic>& b = inputs.get(in.b, n, n).template as<Scalar>();
+    Matrix<Scalar, Dynamic, Dynamic> prod(n, n);
+
+    int hardware = std::max(1, int(std::thread::hardware_concurrency()));
+    int previous = eigen_posit::num_threads();
+    bench::options threaded = opt;
+    threaded.hardware = nullptr;
+    double single{};
+    for (int threads{ 1 }; ; threads = std::min(threads * 2, hardware))
+    {
+        set_threads(threads);
+        bench::result r = bench::measure([&] {
+            prod.noalias() = a * b;
+            bench::do_not_optimize(prod(0, 0));
+        }, threads == 1 ? opt : threaded);
+        r = record<Scalar>(results, r, "gemm_threads", n, n, in.name);
+        if (threads == 1) single = r.median;
+        std::cout << "\t\tthreads " << threads << "\tspeedup " << single / r.median
+                  << "\tefficiency " << single / r.median / threads << "\n";
+        if (threads == hardware) break;
+    }
+    set_threads(previous);
+}
+
+// One n x n operand in Scalar alone; the sweep's sizes are too large to
+// keep every type's copy in the input cache.
+template<typename Scalar>
+Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic> sweep_operand(const bench::input_spec& spec, int n)
+{
+    if constexpr (std::is_same_v<Scalar, double>) return bench::input_set<>(spec, n, n).template as<double>();
+    else return bench::input_set<Scalar>(spec, n, n).template as<Scalar>();
+}
 
-        if (!fmul.allFinite()) {
-            std::cerr << "Float result has NaN or Inf at size " << r << "x" << c << "\n";
-            return;
+// Times C = A * B and C = A + B on uniform n x n matrices for n = 512, 1024,
+// ... up to max_size and places each on the host's roofline. The product
+// grows eightfold per doubling, so it stops once the next size would pass
+// sweep_gemm_seconds per call; the sum runs at every size. Accuracy is left
+// to the suite, its references would cost more than the sweep.
+template<typename Scalar>
+void size_sweep(std::vector<bench::result>& results, const bench::options& opt, const bench::roofline& peak, int max_size)
+{
+    using namespace Eigen;
+
+    std::cout << "\t--------" << bench::scalar_name<Scalar>() << " sweep--------\n";
+    const input_case& in = input_case_named("uniform");
+    bool gemm{ true };
+    for (int n{ 512 }; n <= max_size; n *= 2)
+    {
+        Matrix<Scalar, Dynamic, Dynamic> a = sweep_operand<Scalar>(in.a, n);
+        Matrix<Scalar, Dynamic, Dynamic> b = sweep_operand<Scalar>(in.b, n);
+        Matrix<Scalar, Dynamic, Dynamic> out(n, n);
+        double elements = double(n) * n;
+
+        if (gemm)
+        {
+            bench::result r = bench::measure([&] {
+                out.noalias() = a * b;
+                bench::do_not_optimize(out(0, 0));
+            }, opt);
+            r.flops = 2.0 * elements * n;
+            r.elements = elements;
+            r.bytes = 3.0 * elements * sizeof(Scalar);
+            r.roofline_fraction = peak.fraction<Scalar>(r);
+            record<Scalar>(results, r, "gemm", n, n, in.name);
+            gemm = 8.0 * r.median <= sweep_gemm_seconds * 1e6;
+            if (!gemm && 2 * n <= max_size) std::cout << "\t\tgemm stops here, " << 2 * n << " would take over " << sweep_gemm_seconds << " s\n";
         }
-        if (!pa.allFinite() || !pb.allFinite()) {
-            std::cerr << "Posit input matrices are invalid at size " << r << "x" << c << "\n";
-            return;
+
+        bench::result r = bench::measure([&] {
+            assign(out, a + b);
+            bench::do_not_optimize(out(0, 0));
+        }, opt);
+        r.flops = r.elements = elements;
+        r.bytes = 3.0 * elements * sizeof(Scalar);
+        r.roofline_fraction = peak.fraction<Scalar>(r);
+        record<Scalar>(results, r, "add", n, n, in.name);
+    }
+}
+
+// Times PartialPivLU and FullPivLU of an n x n matrix and the partial-pivoting
+// solve of one right-hand side, and measures both solutions against the
+// refined solution of the system as stored in Scalar.
+template<typename Scalar>
+void solve_benchmark(std::vector<bench::result>& results, const bench::options& opt, int n, const input_case& in)
+{
+    using namespace Eigen;
+
+    const Matrix<Scalar, Dynamic, Dynamic>& a = inputs.get(in.a, n, n).template as<Scalar>();
+    const Matrix<Scalar, Dynamic, Dynamic>& b = inputs.get(in.b, n, 1).template as<Scalar>();
+    bench::reference ref = bench::reference_solve(bench::exact_double(a), bench::exact_double(b));
+    double elements = double(n) * n;
+
+    PartialPivLU<Matrix<Scalar, Dynamic, Dynamic>> lu(n);
+    bench::result factor = bench::measure([&] {
+        lu.compute(a);
+        bench::do_not_optimize(lu.matrixLU()(0, 0));
+    }, opt);
+    factor.flops = 2.0 / 3.0 * elements * n;
+    factor.elements = elements;
+    factor.bytes = 2.0 * elements * sizeof(Scalar);
+    record<Scalar>(results, factor, "lu", n, n, in.name);
+
+    Matrix<Scalar, Dynamic, Dynamic> x(n, 1);
+    bench::result solve = bench::measure([&] {
+        x = lu.solve(b);
+        bench::do_not_optimize(x(0, 0));
+    }, opt);
+    solve.flops = 2.0 * elements;
+    solve.elements = n;
+    solve.bytes = elements * sizeof(Scalar);
+    solve.acc = bench::compare(x, ref);
+    record<Scalar>(results, solve, "lu_solve", n, 1, in.name);
+
+    FullPivLU<Matrix<Scalar, Dynamic, Dynamic>> full(n, n);
+    bench::result full_factor = bench::measure([&] {
+        full.compute(a);
+        bench::do_not_optimize(full.matrixLU()(0, 0));
+    }, opt);
+    full_factor.flops = 2.0 / 3.0 * elements * n;
+    full_factor.elements = elements;
+    full_factor.bytes = 2.0 * elements * sizeof(Scalar);
+    x = full.solve(b);
+    full_factor.acc = bench::compare(x, ref);
+    record<Scalar>(results, full_factor, "full_lu", n, n, in.name);
+}
+
+// Times mixed-precision refinement of an n x n posit32 system: the posit16
+// factorization, then solves of one right-hand side refined with quire and
+// with posit32 residuals, each measured as solve_benchmark measures lu_solve.
+void refine_benchmark(std::vector<bench::result>& results, const bench::options& opt, int n, const input_case& in)
+{
+    using namespace Eigen;
+
+    const Matrix<posit32, Dynamic, Dynamic>& a = inputs.get(in.a, n, n).as<posit32>();
+    const Matrix<posit32, Dynamic, Dynamic>& b = inputs.get(in.b, n, 1).as<posit32>();
+    bench::reference ref = bench::reference_solve(bench::exact_double(a), bench::exact_double(b));
+    double elements = double(n) * n;
+
+    eigen_posit::IterativeRefinementSolver<PartialPivLU, posit32, posit16> ir;
+    bench::result factor = bench::measure([&] {
+        ir.compute(a);
+        bench::do_not_optimize(ir.factorDecomposition().matrixLU()(0, 0));
+    }, opt);
+    factor.flops = 2.0 / 3.0 * elements * n;
+    factor.elements = elements;
+    factor.bytes = elements * (sizeof(posit32) + 2 * sizeof(posit16));
+    record<posit32>(results, factor, "ir_lu", n, n, in.name);
+
+    Matrix<posit32, Dynamic, Dynamic> x(n, 1);
+    auto run = [&](const char* operation, const auto& solver) {
+        bench::result solve = bench::measure([&] {
+            x = solver.solve(b);
+            bench::do_not_optimize(x(0, 0));
+        }, opt);
+        // a residual and a low-precision solve per iteration
+        solve.flops = 4.0 * elements * (solver.iterations() + 1);
+        solve.elements = n;
+        solve.bytes = elements * (sizeof(posit32) + sizeof(posit16)) * (solver.iterations() + 1);
+        solve.acc = bench::compare(x, ref);
+        record<posit32>(results, solve, operation, n, 1, in.name);
+        std::cout << "\t\t" << solver.iterations() << " iterations" << (solver.fellBack() ? ", fell back on posit32 LU" : "")
+                  << (solver.info() == Success ? "" : ", not converged") << "\n";
+    };
+    run("ir_solve", ir);
+    eigen_posit::IterativeRefinementSolver<PartialPivLU, posit32, posit16, posit32> ir_p32(a);
+    run("ir_solve_p32", ir_p32);
+}
+
+// Times LLT and LDLT of an n x n symmetric positive definite matrix, each
+// with the accuracy of its solve of one right-hand side.
+template<typename Scalar>
+void cholesky_benchmark(std::vector<bench::result>& results, const bench::options& opt, int n, const input_case& in)
+{
+    using namespace Eigen;
+
+    const Matrix<Scalar, Dynamic, Dynamic>& a = inputs.get(in.a, n, n).template as<Scalar>();
+    const Matrix<Scalar, Dynamic, Dynamic>& b = inputs.get(in.b, n, 1).template as<Scalar>();
+    bench::reference ref = bench::reference_solve(bench::exact_double(a), bench::exact_double(b));
+    double elements = double(n) * n;
+    Matrix<Scalar, Dynamic, Dynamic> x(n, 1);
+
+    LLT<Matrix<Scalar, Dynamic, Dynamic>> llt(n);
+    bench::result factor = bench::measure([&] {
+        llt.compute(a);
+        bench::do_not_optimize(llt.matrixLLT()(0, 0));
+    }, opt);
+    factor.flops = elements * n / 3.0;
+    factor.elements = elements;
+    factor.bytes = 2.0 * elements * sizeof(Scalar);
+    x = llt.solve(b);
+    factor.acc = bench::compare(x, ref);
+    record<Scalar>(results, factor, "llt", n, n, in.name);
+
+    LDLT<Matrix<Scalar, Dynamic, Dynamic>> ldlt(n);
+    bench::result pivoted = bench::measure([&] {
+        ldlt.compute(a);
+        bench::do_not_optimize(ldlt.matrixLDLT()(0, 0));
+    }, opt);
+    pivoted.flops = elements * n / 3.0;
+    pivoted.elements = elements;
+    pivoted.bytes = 2.0 * elements * sizeof(Scalar);
+    x = ldlt.solve(b);
+    pivoted.acc = bench::compare(x, ref);
+    record<Scalar>(results, pivoted, "ldlt", n, n, in.name);
+}
+
+// Times HouseholderQR and ColPivHouseholderQR of a 2n x n matrix, each with
+// the accuracy of its least-squares solution of one right-hand side, and the
+// HouseholderQR solve with the accuracy of the residual b - a x it leaves,
+// taken exactly and rounded to Scalar.
+template<typename Scalar>
+void lstsq_benchmark(std::vector<bench::result>& results, const bench::options& opt, int n, const input_case& in)
+{
+    using namespace Eigen;
+
+    int m = 2 * n;
+    const Matrix<Scalar, Dynamic, Dynamic>& a = inputs.get(in.a, m, n).template as<Scalar>();
+    const Matrix<Scalar, Dynamic, Dynamic>& b = inputs.get(in.b, m, 1).template as<Scalar>();
+    MatrixXd ad = bench::exact_double(a), bd = bench::exact_double(b);
+    bench::least_squares_reference ref = bench::reference_lstsq(ad, bd);
+    double elements = double(m) * n;
+    Matrix<Scalar, Dynamic, Dynamic> x(n, 1);
+
+    HouseholderQR<Matrix<Scalar, Dynamic, Dynamic>> qr(m, n);
+    bench::result factor = bench::measure([&] {
+        qr.compute(a);
+        bench::do_not_optimize(qr.matrixQR()(0, 0));
+    }, opt);
+    factor.flops = 2.0 * elements * n - 2.0 / 3.0 * double(n) * n * n;
+    factor.elements = elements;
+    factor.bytes = 2.0 * elements * sizeof(Scalar);
+    x = qr.solve(b);
+    factor.acc = bench::compare(x, ref.x);
+    record<Scalar>(results, factor, "qr", m, n, in.name);
+
+    bench::result solve = bench::measure([&] {
+        x = qr.solve(b);
+        bench::do_not_optimize(x(0, 0));
+    }, opt);
+    solve.flops = 4.0 * elements - double(n) * n;
+    solve.elements = m;
+    solve.bytes = elements * sizeof(Scalar);
+    bench::reference residual = bench::reference_sum(bd, ad * bench::exact_double(x), -1.0);
+    Matrix<Scalar, Dynamic, Dynamic> r = (residual.hi + residual.lo).template cast<Scalar>();
+    solve.acc = bench::compare(r, ref.residual);
+    record<Scalar>(results, solve, "qr_solve", m, 1, in.name);
+
+    ColPivHouseholderQR<Matrix<Scalar, Dynamic, Dynamic>> colpiv(m, n);
+    bench::result pivoted = bench::measure([&] {
+        colpiv.compute(a);
+        bench::do_not_optimize(colpiv.matrixQR()(0, 0));
+    }, opt);
+    pivoted.flops = factor.flops;
+    pivoted.elements = elements;
+    pivoted.bytes = 2.0 * elements * sizeof(Scalar);
+    x = colpiv.solve(b);
+    pivoted.acc = bench::compare(x, ref.x);
+    record<Scalar>(results, pivoted, "colpiv_qr", m, n, in.name);
+}
+
+// Dense solves at n = 64, 128, ... up to max_size (just max_size if below 64)
+// on the uniform, normal and ill-conditioned inputs, for posit32 also refined from posit16 factors,
+// Cholesky factorizations of covariance matrices and least squares on 2n x n
+// normal matrices.
+template<typename Scalar>
+void solve_suite(std::vector<bench::result>& results, const bench::options& opt, int max_size)
+{
+    static const input_case covariance{ "covariance", { bench::distribution::covariance, 1e3, 0.0, 1 },
+                                        { bench::distribution::normal, 0.0, 1.0, 2 } };
+    std::cout << "\t--------" << bench::scalar_name<Scalar>() << " solve--------\n";
+    for (int n{ std::min(64, max_size) }; n <= max_size; n *= 2)
+    {
+        for (const char* name : { "uniform", "normal", "conditioned" })
+        {
+            const input_case& in = input_case_named(name);
+            solve_benchmark<Scalar>(results, opt, n, in);
+            if constexpr (std::is_same_v<Scalar, posit32>) refine_benchmark(results, opt, n, in);
         }
+        cholesky_benchmark<Scalar>(results, opt, n, covariance);
+        lstsq_benchmark<Scalar>(results, opt, n, input_case_named("normal"));
+    }
+}
+
+// Times exp and tanh of an n x n array and log and sqrt of its absolute
+// values, each measured against the function in long double. For posits it
+// also times exp through a double round trip, the only way to get it before
+// elementary.h.
+template<typename Scalar>
+void math_benchmark(std::vector<bench::result>& results, const bench::options& opt, int n, const input_case& in)
+{
+    using namespace Eigen;
+    typedef Array<Scalar, Dynamic, Dynamic> ArrayType;
 
-        auto posit_abs_error = (ref - p_to_d).cwiseAbs();
-        auto float_abs_error = (ref - fmul.cast<double>()).cwiseAbs();
-        posit_mean_error += posit_abs_error.mean();
-        float_mean_error += float_abs_error.mean();
+    const ArrayType a = inputs.get(in.a, n, n).template as<Scalar>().array();
+    const ArrayType magnitude = a.abs();
+    MatrixXd da = bench::exact_double(a.matrix()), dm = bench::exact_double(magnitude.matrix());
+    ArrayType out(n, n);
+    double elements = double(n) * n;
+
+    auto run = [&](const char* operation, auto&& f, const bench::reference& ref) {
+        bench::result r = bench::measure([&] {
+            f();
+            bench::do_not_optimize(out(0, 0));
+        }, opt);
+        r.flops = r.elements = elements;
+        r.bytes = 2.0 * elements * sizeof(Scalar);
+        r.acc = bench::compare(out.matrix(), ref);
+        record<Scalar>(results, r, operation, n, n, in.name);
+    };
+
+    // exp of the log-uniform values, up to 1e4, is past every format's range
+    if (std::string(in.name) != "log_uniform")
+    {
+        bench::reference exp_ref = bench::reference_map(da, [](long double x) { return std::exp(x); });
+        run("exp", [&] { out = a.exp(); }, exp_ref);
+        if constexpr (!std::is_floating_point_v<Scalar>)
+            run("exp_roundtrip", [&] { out = a.template cast<double>().exp().template cast<Scalar>(); }, exp_ref);
     }
-    pelapsed /= repetitions;
-    felapsed /= repetitions;
-    posit_mean_error /= repetitions;
-    float_mean_error /= repetitions;
+    run("tanh", [&] { out = a.tanh(); }, bench::reference_map(da, [](long double x) { return std::tanh(x); }));
+    run("log", [&] { out = magnitude.log(); }, bench::reference_map(dm, [](long double x) { return std::log(x); }));
+    run("sqrt", [&] { out = magnitude.sqrt(); }, bench::reference_map(dm, [](long double x) { return std::sqrt(x); }));
+}
 
-    std::cout << "\t--------Matrix Size: " << 
-    r << "x" << c << "--------\n";
-    std::cout << "\t Posit Time taken: " << pelapsed.count() << "\n";
-    std::cout << "\t Float Time taken: " << felapsed.count() << "\n";
-    std::cout << "\t Posit Mean Absolute Error: " << posit_mean_error << "\n";
-    std::cout << "\t Float Mean Absolute Error: " << float_mean_error << "\n";
+// Elementary functions on the uniform, normal and log-uniform inputs.
+template<typename Scalar>
+void math_suite(std::vector<bench::result>& results, const bench::options& opt, int n)
+{
+    std::cout << "\t--------" << bench::scalar_name<Scalar>() << " math--------\n";
+    for (const char* name : { "uniform", "normal", "log_uniform" })
+        math_benchmark<Scalar>(results, opt, n, input_case_named(name));
 }
 
-int main()
+template<typename Scalar>
+void suite(std::vector<bench::result>& results, const bench::options& opt)
+{
+    std::cout << "\t--------" << bench::scalar_name<Scalar>() << "--------\n";
+    for (int n : { 10, 20, 30, 40, 50, 100, 200 })
+        for (const input_case& in : input_cases())
+            benchmark<Scalar>(results, opt, n, n, in);
+}
+
+// Reports a bad command line with the usage line; returns main's exit status.
+int usage(const std::string& problem)
+{
+    std::cerr << "main: " << problem << "\n"
+              << "usage: main [--csv <file>] [--json <file>] [--error-maps <dir>] [--sweep <max>] [--sweep-gemm-seconds <s>]\n"
+                 "            [--count-ops <n>] [--profile-range <n>] [--error-budget <e>] [--solve <n>] [--math <n>]\n"
+                 "            [--counters on]\n";
+    return 2;
+}
+
+// Reads a whole argument as a positive number into out; false if it is not one.
+template<typename Number>
+bool parse_positive(const std::string& value, Number& out)
+{
+    std::size_t end{};
+    Number n{};
+    try {
+        if constexpr (std::is_integral_v<Number>) n = std::stoi(value, &end);
+        else n = std::stod(value, &end);
+    } catch (const std::exception&) {
+        return false;
+    }
+    if (end != value.size() || !(n > 0)) return false;
+    out = n;
+    return true;
+}
+
+int main(int argc, char** argv)
 {
     #ifdef EIGEN_VECTORIZE_SSE
         std::cout << "SSE enabled\n";
@@ -149,14 +673,130 @@ int main()
     #ifndef EIGEN_VECTORIZE
         std::cout << "No SIMD vectorization\n";
     #endif
+    std::cout << "Posit kernels: " << eigen_posit::active_kernels().name << "\n";
+
+    std::string csv_path{ "bench_results.csv" };
+    std::string json_path{ "bench_results.json" };
+    int sweep_size{};
+    int census_size{};
+    int range_size{};
+    int solve_size{};
+    int math_size{};
+    double error_budget{ 1e-3 };
+    for (int i{ 1 }; i < argc; i += 2)
+    {
+        std::string flag{ argv[i] };
+        if (i + 1 == argc) return usage("no value for " + flag);
+        std::string value{ argv[i + 1] };
+        bool valid{ true };
+        if (flag == "--csv") csv_path = value;
+        else if (flag == "--json") json_path = value;
+        else if (flag == "--error-maps") error_map_dir = value;
+        else if (flag == "--sweep") valid = parse_positive(value, sweep_size);
+        else if (flag == "--sweep-gemm-seconds") valid = parse_positive(value, sweep_gemm_seconds);
+        else if (flag == "--count-ops") valid = parse_positive(value, census_size);
+        else if (flag == "--profile-range") valid = parse_positive(value, range_size);
+        else if (flag == "--error-budget") valid = parse_positive(value, error_budget);
+        else if (flag == "--solve") valid = parse_positive(value, solve_size);
+        else if (flag == "--math") valid = parse_positive(value, math_size);
+        else if (flag == "--counters") valid = value == "on";
+        else return usage("unknown flag " + flag);
+        if (!valid) return usage("bad value " + value + " for " + flag);
+        if (flag == "--counters") perf_counters.reset(new bench::counters);
+    }
+    if (perf_counters)
+    {
+        if (!perf_counters->error().empty()) std::cout << "Hardware counters: " << perf_counters->error() << "\n";
+        if (!perf_counters->available()) perf_counters.reset();
+        // the counters follow the calling thread only
+        else set_threads(1);
+    }
+    set_threads(eigen_posit::num_threads());
+    std::cout << "Threads: " << eigen_posit::num_threads() << " posit pool, " << Eigen::nbThreads() << " Eigen products";
+    #ifndef EIGEN_HAS_OPENMP
+        std::cout << " (built without OpenMP)";
+    #endif
+    std::cout << "\n";
+
+    if (range_size)
+    {
+        range_census(range_size, error_budget);
+        return 0;
+    }
+    if (census_size)
+    {
+        op_census<posit32>(census_size);
+        op_census<posit16>(census_size);
+        return 0;
+    }
 
-    for(int i{ 10 }; i <= 50; i += 10)
+    std::vector<bench::result> results;
+    if (sweep_size)
     {
-        benchmark(i, i, 5, 1.0, 2.0);
-        benchmark(i, i, 5, 1.00001, 0.99999);
-        benchmark(i, i, 5, 1e-5, 2e-5);
-        benchmark(i, i, 5, 1e4, 1e4);
+        bench::roofline peak = bench::measure_roofline();
+        std::cout << "Roofline: float " << peak.float_gflops << " GFLOPS, double " << peak.double_gflops << " GFLOPS, "
+                  << peak.gbytes_per_s << " GB/s on " << peak.threads << " threads\n";
+
+        // large calls: a few samples, the first call warms up
+        bench::options opt;
+        opt.hardware = perf_counters.get();
+        opt.warmup = 0;
+        opt.min_samples = 3;
+        opt.budget = std::chrono::seconds(2);
+        size_sweep<posit8>(results, opt, peak, sweep_size);
+        size_sweep<posit16>(results, opt, peak, sweep_size);
+        size_sweep<posit32>(results, opt, peak, sweep_size);
+        size_sweep<float>(results, opt, peak, sweep_size);
+        size_sweep<double>(results, opt, peak, sweep_size);
+        size_sweep<Eigen::half>(results, opt, peak, sweep_size);
+        size_sweep<Eigen::bfloat16>(results, opt, peak, sweep_size);
     }
-      
+    else if (solve_size)
+    {
+        bench::options opt;
+        opt.hardware = perf_counters.get();
+        opt.warmup = 1;
+        opt.min_samples = 3;
+        opt.budget = std::chrono::seconds(1);
+        solve_suite<posit32>(results, opt, solve_size);
+        solve_suite<posit16>(results, opt, solve_size);
+        solve_suite<float>(results, opt, solve_size);
+        solve_suite<double>(results, opt, solve_size);
+    }
+    else if (math_size)
+    {
+        bench::options opt;
+        opt.hardware = perf_counters.get();
+        opt.budget = std::chrono::milliseconds(200);
+        math_suite<posit32>(results, opt, math_size);
+        math_suite<posit16>(results, opt, math_size);
+        math_suite<float>(results, opt, math_size);
+        math_suite<double>(results, opt, math_size);
+    }
+    else
+    {
+        bench::options opt;
+        opt.hardware = perf_counters.get();
+        opt.budget = std::chrono::milliseconds(100);
+        suite<posit32>(results, opt);
+        suite<posit16>(results, opt);
+        suite<eigen_posit::posit<32, 2>>(results, opt);
+        suite<eigen_posit::posit<16, 1>>(results, opt);
+        suite<float>(results, opt);
+        suite<double>(results, opt);
+
+        for (int n : { 32, 64, 128, 256 })
+        {
+            thread_sweep<posit32>(results, opt, n);
+            thread_sweep<posit16>(results, opt, n);
+        }
+    }
+
+    std::ofstream csv(csv_path);
+    bench::write_csv(csv, results);
+    std::ofstream json(json_path);
+    bench::write_json(json, results);
+    std::cout << "Wrote " << results.size() << " results to " << csv_path << " and " << json_path << "\n";
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "dispatch.h"
+#include "kernels.h"
+#include "packet_math.h"
+#include "parallel.h"
+#include <Eigen/Core>
+#include <cstddef>
+#include <cstdint>
+
+// Conversions between posit32 and float/double.
+//
+// Eigen 3.4 evaluates .cast<T>() one coefficient at a time: scalar_cast_op
+// has no packet path, and a packet of posit32 cannot be loaded as a packet
+// of double. Coefficient casts therefore go through cast_impl, specialized
+// here to the inline kernels of kernels.h instead of a libsoftposit call,
+// and whole-matrix casts
+//
+//     MatrixXd d = p.cast<double>();
+//     p = f.cast<posit32>();
+//
+// are caught at assignment: when source and destination are both laid out
+// contiguously in the same order, the conversion runs as one array pass
+// through the runtime-dispatched SIMD kernels (dispatch.h), split across the
+// posit thread pool. Anything else (strided blocks, +=, mixed orders) falls
+// back on Eigen's own loop with the scalar kernels. Every path is bit-exact
+// with SoftPosit: posit32 to double is exact, double to posit32 rounds once,
+// and float goes through double, which widens exactly and narrows once.
+namespace eigen_posit
+{
+namespace detail
+{
+    // About a float add per element on the SIMD kernels.
+    constexpr double convert_work = 1.0;
+    // a cache line of float or posit32
+    constexpr Eigen::Index convert_grain = 16;
+
+    // Element i of src in storage order is element i of dst.
+    template<typename Dst, typename Src>
+    bool same_layout(const Dst& dst, const Src& src)
+    {
+        auto contiguous = [](const auto& m) { return m.innerStride() == 1 && (m.outerSize() == 1 || m.outerStride() == m.innerSize()); };
+        bool vector = dst.rows() == 1 || dst.cols() == 1;
+        return contiguous(dst) && contiguous(src) && (vector || int(Dst::IsRowMajor) == int(Src::IsRowMajor));
+    }
+
+    template<typename In, typename Out>
+    void bulk_convert(const In* in, Out* out, Eigen::Index n, void (*kernel)(const In*, Out*, std::size_t))
+    {
+        parallel_slices(n, convert_grain, convert_work, [&](Eigen::Index begin, Eigen::Index end) {
+            kernel(in + begin, out + begin, std::size_t(end - begin));
+        });
+    }
+
+    template<typename From, typename To> struct bulk_cast;
+
+    template<> struct bulk_cast<posit32, double>
+    {
+        static void run(const posit32* in, double* out, Eigen::Index n)
+        {
+            bulk_convert(reinterpret_cast<const uint32_t*>(in), out, n, active_kernels().decode);
+        }
+    };
+
+    template<> struct bulk_cast<posit32, float>
+    {
+        static void run(const posit32* in, float* out, Eigen::Index n)
+        {
+            bulk_convert(reinterpret_cast<const uint32_t*>(in), out, n, active_kernels().decode_float);
+        }
+    };
+
+    template<> struct bulk_cast<double, posit32>
+    {
+        static void run(const double* in, posit32* out, Eigen::Index n)
+        {
+            bulk_convert(in, reinterpret_cast<uint32_t*>(out), n, active_kernels().encode);
+        }
+    };
+
+    template<> struct bulk_cast<float, posit32>
+    {
+        static void run(const float* in, posit32* out, Eigen::Index n)
+        {
+            bulk_convert(in, reinterpret_cast<uint32_t*>(out), n, active_kernels().encode_float);
+        }
+    };
+
+    // Shared body of the Assignment specializations below.
+    template<typename From, typename To>
+    struct cast_assignment
+    {
+        template<typename Dst, typename Src, typename Func>
+        static void run(Dst& dst, const Src& src, const Func& func)
+        {
+            using namespace Eigen::internal;
+            typedef typename remove_all<typename Src::XprTypeNested>::type Arg;
+            const Arg& arg = src.nestedExpression();
+            resize_if_allowed(dst, src, func);
+            if constexpr (bool(traits<Dst>::Flags & Eigen::DirectAccessBit) && bool(traits<Arg>::Flags & Eigen::DirectAccessBit)) {
+                if (same_layout(dst, arg)) {
+                    bulk_cast<From, To>::run(arg.data(), dst.data(), dst.size());
+                    return;
+                }
+            }
+            call_dense_assignment_loop(dst, src, func);
+        }
+    };
+}
+}
+
+namespace Eigen
+{
+namespace internal
+{
+    template<> struct cast_impl<posit32, double>
+    {
+        static inline double run(const posit32& x) { return eigen_posit::p32_to_double(x.value); }
+    };
+
+    template<> struct cast_impl<posit32, float>
+    {
+        static inline float run(const posit32& x) { return float(eigen_posit::p32_to_double(x.value)); }
+    };
+
+    template<> struct cast_impl<double, posit32>
+    {
+        static inline posit32 run(const double& x) { return eigen_posit::p32_from_bits(eigen_posit::p32_from_double(x)); }
+    };
+
+    template<> struct cast_impl<float, posit32>
+    {
+        static inline posit32 run(const float& x) { return eigen_posit::p32_from_bits(eigen_posit::p32_from_double(x)); }
+    };
+
+    template<typename DstXprType, typename Arg, typename Weak>
+    struct Assignment<DstXprType, CwiseUnaryOp<scalar_cast_op<posit32, double>, const Arg>, assign_op<double, double>, Dense2Dense, Weak>
+        : eigen_posit::detail::cast_assignment<posit32, double> {};
+
+    template<typename DstXprType, typename Arg, typename Weak>
+    struct Assignment<DstXprType, CwiseUnaryOp<scalar_cast_op<posit32, float>, const Arg>, assign_op<float, float>, Dense2Dense, Weak>
+        : eigen_posit::detail::cast_assignment<posit32, float> {};
+
+    template<typename DstXprType, typename Arg, typename Weak>
+    struct Assignment<DstXprType, CwiseUnaryOp<scalar_cast_op<double, posit32>, const Arg>, assign_op<posit32, posit32>, Dense2Dense, Weak>
+        : eigen_posit::detail::cast_assignment<double, posit32> {};
+
+    template<typename DstXprType, typename Arg, typename Weak>
+    struct Assignment<DstXprType, CwiseUnaryOp<scalar_cast_op<float, posit32>, const Arg>, assign_op<posit32, posit32>, Dense2Dense, Weak>
+        : eigen_posit::detail::cast_assignment<float, posit32> {};
+}
+}
@@ -0,0 +1,288 @@
+#pragma once
+
+#include "lu.h"
+#include "packet_math.h"
+#include "parallel.h"
+#include "quire.h"
+#include "redux.h"
+#include <Eigen/Cholesky>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Cholesky factorizations of posit32 matrices with quire inner products.
+//
+// Eigen's LLT and LDLT subtract the products of the columns already factored
+// from each new entry one rounded operation at a time, every one a SoftPosit
+// call. Here every entry of the factor is a single quire (quire.h): LLT's
+// L(i, k) is (A(i, k) - sum_j L(i, j) L(k, j)) / L(k, k) and its L(k, k) the
+// square root of A(k, k) - sum_j L(k, j)^2, each accumulated exactly and
+// rounded to posit32 once, division and square root included. LDLT keeps
+// Eigen's algorithm, pivoting on the largest remaining diagonal entry and
+// rounding the weights w(j) = D(j) L(k, j) as Eigen does, but D(k) and
+// L(i, k) are each rounded once.
+//
+// The factorization is left-looking in panels of cholesky_block columns: the
+// panel's own rows first, one after another, then every row below it on the
+// thread pool. Such a row keeps one quire per panel column and reads each of
+// its earlier entries once per panel. Solves go through the decoded
+// triangular solves of lu.h, and the L1 norm both compute() calls take for
+// rcond() through the quire sums of redux.h. LLT covers every posit32 matrix
+// and both triangles; LDLT covers Matrix<posit32, Dynamic, Dynamic>.
+namespace eigen_posit
+{
+namespace detail
+{
+    // Columns per panel; every row below a panel keeps a quire per column.
+    constexpr Eigen::Index cholesky_block = 32;
+
+    // A lower triangle as posit32 bits, row by row: row i holds columns 0 to i.
+    class packed_lower
+    {
+    public:
+        explicit packed_lower(Eigen::Index n) : bits(std::size_t(n * (n + 1) / 2)) {}
+
+        uint32_t* row(Eigen::Index i) { return bits.data() + i * (i + 1) / 2; }
+        const uint32_t* row(Eigen::Index i) const { return bits.data() + i * (i + 1) / 2; }
+
+        template<typename MatrixType>
+        void load(const MatrixType& m)
+        {
+            for (Eigen::Index i{}; i < m.rows(); ++i)
+                for (Eigen::Index j{}; j <= i; ++j) row(i)[j] = m.coeff(i, j).value;
+        }
+
+        template<typename MatrixType>
+        void store(MatrixType& m) const
+        {
+            for (Eigen::Index j{}; j < m.cols(); ++j)
+                for (Eigen::Index i = j; i < m.rows(); ++i) m.coeffRef(i, j) = p32_from_bits(row(i)[j]);
+        }
+
+    private:
+        std::vector<uint32_t> bits;
+    };
+
+    // The weights of one panel's rows, unpacked for the quires:
+    // w[j * cholesky_block + c] is W(k0 + c, j), with W = L for LLT and
+    // W(k, j) = D(j) L(k, j) for LDLT.
+    struct cholesky_panel
+    {
+        Eigen::Index k0{};
+        std::vector<p32_unpacked> w;
+        // any NaR among W(k0 + c, j), j < k0 + c
+        std::array<bool, cholesky_block> nar{};
+    };
+
+    inline bool ldlt_pivot_valid(uint32_t d) { return d != 0 && d != p32_nar; }
+
+    // Entries k0 to end of row a, end at most the row's own index: each
+    // A(i, k) less the row's products with W(k, .), divided by the divisor
+    // of column k, or for a zero LDLT pivot only rounded, as Eigen does.
+    template<bool LDLT>
+    void cholesky_row(uint32_t* a, Eigen::Index end, const cholesky_panel& panel, const uint32_t* divisor)
+    {
+        using Eigen::Index;
+        Index width = end - panel.k0;
+        std::array<p32_quire, cholesky_block> q;
+        bool row_nar{};
+        for (Index j{}; j < panel.k0; ++j) {
+            row_nar |= a[j] == p32_nar;
+            p32_unpacked l = p32_unpack(0u - a[j]);
+            const p32_unpacked* w = panel.w.data() + j * cholesky_block;
+            for (Index c{}; c < width; ++c) q[c].add_product(l, w[c]);
+        }
+        for (Index c{}; c < width; ++c) {
+            Index k = panel.k0 + c;
+            q[c].add(a[k]);
+            for (Index j = panel.k0; j < k; ++j) {
+                row_nar |= a[j] == p32_nar;
+                q[c].add_product(p32_unpack(0u - a[j]), panel.w[j * cholesky_block + c]);
+            }
+            q[c].nar |= row_nar || panel.nar[c];
+            a[k] = LDLT && !ldlt_pivot_valid(divisor[k]) ? q[c].to_posit() : q[c].to_posit_divided(p32_to_double(divisor[k]));
+        }
+    }
+
+    // Diagonal entry k of row a, whose entries before it are final: LLT's
+    // square root of A(k, k) - sum_j L(k, j)^2, or LDLT's
+    // D(k) = A(k, k) - sum_j L(k, j) w(j).
+    template<bool LDLT>
+    uint32_t cholesky_diagonal(const uint32_t* a, Eigen::Index k, const uint32_t* divisor)
+    {
+        p32_quire q;
+        q.add(a[k]);
+        for (Eigen::Index j{}; j < k; ++j) q.sub_product(a[j], LDLT ? p32_mul(divisor[j], a[j]) : a[j]);
+        return LDLT ? q.to_posit() : q.to_posit_sqrt();
+    }
+
+    // Factors the lower triangle of an n x n matrix in place; divisor gets
+    // the diagonal, L(k, k) or D(k). Returns the first column whose LLT
+    // pivot is not positive, or -1.
+    template<bool LDLT>
+    Eigen::Index quire_cholesky(packed_lower& l, Eigen::Index n, uint32_t* divisor)
+    {
+        using Eigen::Index;
+        cholesky_panel panel;
+        panel.w.resize(std::size_t(n * cholesky_block));
+        for (Index k0{}; k0 < n; k0 += cholesky_block) {
+            Index k1 = std::min(n, k0 + cholesky_block);
+            panel.k0 = k0;
+            panel.nar.fill(false);
+            for (Index k = k0; k < k1; ++k) {
+                uint32_t* row = l.row(k);
+                cholesky_row<LDLT>(row, k, panel, divisor);
+                row[k] = divisor[k] = cholesky_diagonal<LDLT>(row, k, divisor);
+                if (!LDLT && int32_t(row[k]) <= 0) return k;
+                Index c = k - k0;
+                for (Index j{}; j < k; ++j) {
+                    uint32_t w = LDLT ? p32_mul(divisor[j], row[j]) : row[j];
+                    panel.nar[c] |= w == p32_nar;
+                    panel.w[j * cholesky_block + c] = p32_unpack(w);
+                }
+            }
+            // a quire product is worth about four float adds
+            parallel_slices(n - k1, Index(1), 4.0 * double(k1) * double(k1 - k0), [&](Index begin, Index end) {
+                for (Index i = k1 + begin; i < k1 + end; ++i) cholesky_row<LDLT>(l.row(i), k1, panel, divisor);
+            });
+        }
+        return -1;
+    }
+
+    template<typename MatrixType>
+    Eigen::Index quire_llt(MatrixType& m)
+    {
+        Eigen::Index n = m.rows();
+        packed_lower l(n);
+        l.load(m);
+        std::vector<uint32_t> divisor(n);
+        Eigen::Index failed = quire_cholesky<false>(l, n, divisor.data());
+        l.store(m);
+        return failed;
+    }
+
+    // Eigen's symmetric swap of rows and columns k < p within the lower triangle.
+    inline void ldlt_swap(packed_lower& l, Eigen::Index n, Eigen::Index k, Eigen::Index p)
+    {
+        for (Eigen::Index j{}; j < k; ++j) std::swap(l.row(k)[j], l.row(p)[j]);
+        for (Eigen::Index i = p + 1; i < n; ++i) std::swap(l.row(i)[k], l.row(i)[p]);
+        std::swap(l.row(k)[k], l.row(p)[p]);
+        for (Eigen::Index i = k + 1; i < p; ++i) std::swap(l.row(i)[k], l.row(p)[i]);
+    }
+
+    // ldlt_inplace<Lower>::unblocked with quire entries. Eigen pivots on the
+    // diagonal entries not yet reached, which the factorization has not
+    // touched, so every swap is known, and made, before factoring.
+    template<typename MatrixType, typename TranspositionType>
+    bool quire_ldlt(MatrixType& mat, TranspositionType& transpositions, Eigen::internal::SignMatrix& sign)
+    {
+        using namespace Eigen::internal;
+        using Eigen::Index;
+        typedef typename TranspositionType::StorageIndex StorageIndex;
+        const Index n = mat.rows();
+        // Eigen's own size <= 1 case, with its scalar comparisons
+        if (n <= 1) {
+            typedef typename MatrixType::RealScalar RealScalar;
+            transpositions.setIdentity();
+            if (n == 0) sign = ZeroSign;
+            else if (Eigen::numext::real(mat.coeff(0, 0)) > static_cast<RealScalar>(0)) sign = PositiveSemiDef;
+            else if (Eigen::numext::real(mat.coeff(0, 0)) < static_cast<RealScalar>(0)) sign = NegativeSemiDef;
+            else sign = ZeroSign;
+            return true;
+        }
+
+        packed_lower l(n);
+        l.load(mat);
+        for (Index k{}; k < n; ++k) {
+            // posits order as integers; the first of equal magnitudes wins
+            Index p = k;
+            int32_t best{};
+            for (Index i = k; i < n; ++i) {
+                uint32_t bits = l.row(i)[i], s = uint32_t(int32_t(bits) >> 31);
+                int32_t magnitude = int32_t((bits ^ s) - s);
+                if (i == k || magnitude > best) best = magnitude, p = i;
+            }
+            transpositions.coeffRef(k) = StorageIndex(p);
+            if (p != k) ldlt_swap(l, n, k, p);
+            // an all-zero diagonal: nothing to factor
+            if (k == 0 && !ldlt_pivot_valid(l.row(0)[0])) {
+                sign = ZeroSign;
+                bool zero = true;
+                for (Index j{}; j < n; ++j) {
+                    transpositions.coeffRef(j) = StorageIndex(j);
+                    for (Index i = j + 1; i < n; ++i) zero = zero && l.row(i)[j] == 0;
+                }
+                l.store(mat);
+                return zero;
+            }
+        }
+
+        std::vector<uint32_t> divisor(n);
+        quire_cholesky<true>(l, n, divisor.data());
+        l.store(mat);
+
+        bool ret = true, found_zero_pivot = false;
+        for (Index k{}; k < n; ++k) {
+            int32_t d = int32_t(divisor[k]);
+            bool valid = ldlt_pivot_valid(divisor[k]);
+            if (!valid)
+                for (Index i = k + 1; i < n; ++i) ret = ret && l.row(i)[k] == 0;
+            if (found_zero_pivot && valid) ret = false;
+            else if (!valid) found_zero_pivot = true;
+
+            if (sign == PositiveSemiDef) {
+                if (d < 0) sign = Indefinite;
+            }
+            else if (sign == NegativeSemiDef) {
+                if (d > 0) sign = Indefinite;
+            }
+            else if (sign == ZeroSign) {
+                if (d > 0) sign = PositiveSemiDef;
+                else if (d < 0) sign = NegativeSemiDef;
+            }
+        }
+        return ret;
+    }
+}
+}
+
+namespace Eigen
+{
+namespace internal
+{
+    template<>
+    struct llt_inplace<posit32, Lower>
+    {
+        typedef posit32 RealScalar;
+
+        template<typename MatrixType>
+        static Index unblocked(MatrixType& mat) { return eigen_posit::detail::quire_llt(mat); }
+
+        template<typename MatrixType>
+        static Index blocked(MatrixType& m) { return eigen_posit::detail::quire_llt(m); }
+
+        template<typename MatrixType, typename VectorType>
+        static Index rankUpdate(MatrixType& mat, const VectorType& vec, const RealScalar& sigma)
+        {
+            return llt_rank_update_lower(mat, vec, sigma);
+        }
+    };
+
+    template<>
+    inline bool ldlt_inplace<Lower>::unblocked(Matrix<posit32, Dynamic, Dynamic>& mat, Transpositions<Dynamic, Dynamic>& transpositions,
+                                               Matrix<posit32, Dynamic, 1>& /*temp*/, SignMatrix& sign)
+    {
+        return eigen_posit::detail::quire_ldlt(mat, transpositions, sign);
+    }
+
+    // LDLT<..., Upper> factors the transpose's lower triangle
+    template<>
+    inline bool ldlt_inplace<Lower>::unblocked(Transpose<Matrix<posit32, Dynamic, Dynamic>>& mat, Transpositions<Dynamic, Dynamic>& transpositions,
+                                               Matrix<posit32, Dynamic, 1>& /*temp*/, SignMatrix& sign)
+    {
+        return eigen_posit::detail::quire_ldlt(mat, transpositions, sign);
+    }
+}
+}
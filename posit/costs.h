@@ -0,0 +1,39 @@
+#pragma once
+
+// Costs of the posit operations in Eigen's unit, one scalar float addition,
+// as used by NumTraits and the functor traits of the posit types.
+//
+// `make calibrate` measures them on the build host into build/posit_costs.h
+// and points EIGEN_POSIT_COSTS_HEADER at it. Without it the defaults below
+// apply, measured on an x86-64 VM: the table-driven posit8/posit16
+// arithmetic and posit<N, ES>. SoftPosit itself was not available there, so
+// posit32 borrows the figures of posit<32, 2>, the same operations done in
+// software, until it is calibrated.
+namespace eigen_posit
+{
+    struct op_costs
+    {
+        int add;
+        int mul;
+        int div;
+        int sqrt;
+        int convert;
+    };
+}
+
+#ifdef EIGEN_POSIT_COSTS_HEADER
+#include EIGEN_POSIT_COSTS_HEADER
+#else
+namespace eigen_posit
+{
+namespace costs
+{
+    constexpr op_costs softposit8{ 3, 3, 3, 11, 6 };
+    constexpr op_costs softposit16{ 16, 17, 16, 17, 8 };
+    constexpr op_costs header8{ 39, 30, 34, 103, 10 };
+    constexpr op_costs header16{ 51, 31, 40, 291, 12 };
+    constexpr op_costs header32{ 50, 31, 35, 256, 8 };
+    constexpr op_costs softposit32 = header32;
+}
+}
+#endif
@@ -0,0 +1,367 @@
+#pragma once
+
+#include "softposit_cpp.h"
+#include "num_traits.h"
+#include "posit.h"
+#include <Eigen/Core>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+// Operation-counting posit scalar for cost profiling.
+//
+// counted<Posit> holds the same bits as Posit and computes with it, but every
+// add or subtract, multiply, divide, square root and conversion to or from a
+// built-in type bumps a counter, and so does every result that had to round,
+// every NaR made from real operands and every result that saturated to
+// maxpos or minpos in magnitude. Exactness is judged against the operands in
+// double-double: sums and products of two posits are exact there, and a
+// quotient or root is exact when multiplying it back gives the operand.
+//
+// Counters are per thread, so products on the posit thread pool count
+// without contention; total_counts() merges every thread's, and count_scope
+// takes the difference around a stretch of code:
+//
+//     eigen_posit::count_scope scope;
+//     c.noalias() = a * b;    // Matrix<counted<posit32>, ...>
+//     std::cout << scope.counts() << "\n";
+//
+// NumTraits make counted<Posit> a drop-in Eigen scalar with Posit's costs.
+// It has no packet math and no quire product, so Eigen evaluates it one
+// scalar operation at a time: the counts are the posit work an expression
+// asks for (a * b is a multiply and an add per term), not what the quire
+// GEMM does for plain posit32.
+namespace eigen_posit
+{
+    struct op_counts
+    {
+        uint64_t adds{};
+        uint64_t muls{};
+        uint64_t divs{};
+        uint64_t sqrts{};
+        uint64_t conversions{};
+        // inexact results, saturations included
+        uint64_t roundings{};
+        uint64_t nars{};
+        uint64_t saturations{};
+
+        static constexpr int kinds = 8;
+        static constexpr uint64_t op_counts::* fields[kinds] = { &op_counts::adds, &op_counts::muls, &op_counts::divs,
+            &op_counts::sqrts, &op_counts::conversions, &op_counts::roundings, &op_counts::nars, &op_counts::saturations };
+        static constexpr const char* names[kinds] = { "adds", "muls", "divs", "sqrts", "conversions", "roundings", "nars", "saturations" };
+
+        op_counts& operator+=(const op_counts& o)
+        {
+            for (auto field : fields) this->*field += o.*field;
+            return *this;
+        }
+
+        friend op_counts operator-(op_counts a, const op_counts& b)
+        {
+            for (auto field : fields) a.*field -= b.*field;
+            return a;
+        }
+
+        friend std::ostream& operator<<(std::ostream& out, const op_counts& c)
+        {
+            for (int i{}; i < kinds; ++i) out << (i ? " " : "") << names[i] << " " << c.*fields[i];
+            return out;
+        }
+    };
+
+namespace detail
+{
+    template<typename> struct posit_format;
+    template<> struct posit_format<posit8> { static constexpr int bits = 8, es = 0; };
+    template<> struct posit_format<posit16> { static constexpr int bits = 16, es = 1; };
+    template<> struct posit_format<posit32> { static constexpr int bits = 32, es = 2; };
+    template<int N, int ES> struct posit_format<posit<N, ES>> { static constexpr int bits = N, es = ES; };
+
+    // One thread's counters. Only the owning thread writes them, so a
+    // relaxed load and store is an increment; other threads only read.
+    struct thread_counts
+    {
+        std::atomic<uint64_t> adds, muls, divs, sqrts, conversions, roundings, nars, saturations;
+
+        thread_counts();
+        ~thread_counts();
+
+        op_counts load() const
+        {
+            op_counts c;
+            const std::atomic<uint64_t>* from[] = { &adds, &muls, &divs, &sqrts, &conversions, &roundings, &nars, &saturations };
+            for (int i{}; i < op_counts::kinds; ++i) c.*op_counts::fields[i] = from[i]->load(std::memory_order_relaxed);
+            return c;
+        }
+
+        void clear()
+        {
+            for (std::atomic<uint64_t>* c : { &adds, &muls, &divs, &sqrts, &conversions, &roundings, &nars, &saturations })
+                c->store(0, std::memory_order_relaxed);
+        }
+    };
+
+    struct count_registry
+    {
+        std::mutex mutex;
+        std::vector<thread_counts*> live;
+        // counts of threads that have exited
+        op_counts retired;
+    };
+
+    // Never destroyed: pool threads may exit after static destructors run.
+    inline count_registry& registry()
+    {
+        static count_registry* r = new count_registry;
+        return *r;
+    }
+
+    inline thread_counts::thread_counts()
+        : adds(0), muls(0), divs(0), sqrts(0), conversions(0), roundings(0), nars(0), saturations(0)
+    {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        registry().live.push_back(this);
+    }
+
+    inline thread_counts::~thread_counts()
+    {
+        count_registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.retired += load();
+        r.live.erase(std::find(r.live.begin(), r.live.end(), this));
+    }
+
+    inline thread_counts& local_counts()
+    {
+        thread_local thread_counts counts;
+        return counts;
+    }
+
+    inline void bump(std::atomic<uint64_t>& c) { c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+    // hi + lo, exactly
+    struct exact_value
+    {
+        double hi;
+        double lo;
+    };
+
+    inline exact_value exact_sum(double a, double b)
+    {
+        double s = a + b;
+        double bb = s - a;
+        return { s, (a - (s - bb)) + (b - bb) };
+    }
+
+    inline exact_value exact_product(double a, double b)
+    {
+        double p = a * b;
+        return { p, std::fma(a, b, -p) };
+    }
+
+    // Counts what producing r from real operands took: NaR, or rounding and
+    // possibly saturation when r is not the exact value v. A quotient's v is
+    // only its nearest double, close enough to tell saturation.
+    template<typename Posit>
+    void tally(thread_counts& t, const Posit& r, bool exact, exact_value v)
+    {
+        if (r.isNaR()) {
+            bump(t.nars);
+            return;
+        }
+        if (exact) return;
+        bump(t.roundings);
+
+        static const double maxpos = Eigen::NumTraits<Posit>::highest().toDouble();
+        static const double minpos = with_bits<Posit>(1).toDouble();
+        double magnitude = std::fabs(r.toDouble());
+        double hi = std::fabs(v.hi), lo = v.hi < 0 ? -v.lo : v.lo;
+        if ((magnitude == maxpos && (hi > maxpos || (hi == maxpos && lo > 0)))
+            || (magnitude == minpos && (hi < minpos || (hi == minpos && lo < 0))))
+            bump(t.saturations);
+    }
+}
+
+    // Sum of every thread's counts, live and exited.
+    inline op_counts total_counts()
+    {
+        detail::count_registry& r = detail::registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        op_counts total = r.retired;
+        for (const detail::thread_counts* t : r.live) total += t->load();
+        return total;
+    }
+
+    // Not to be called while counted arithmetic runs on other threads.
+    inline void reset_counts()
+    {
+        detail::count_registry& r = detail::registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.retired = op_counts{};
+        for (detail::thread_counts* t : r.live) t->clear();
+    }
+
+    // Counts on every thread since construction.
+    class count_scope
+    {
+    public:
+        count_scope() : start(total_counts()) {}
+        op_counts counts() const { return total_counts() - start; }
+
+    private:
+        op_counts start;
+    };
+
+    template<typename Posit>
+    class counted
+    {
+    public:
+        decltype(Posit::value) value;
+
+        counted() = default;
+
+        counted(double x) : value(Posit(x).value)
+        {
+            detail::thread_counts& t = detail::local_counts();
+            detail::bump(t.conversions);
+            if (!std::isnan(x)) detail::tally(t, posit(), posit().toDouble() == x, { x, 0.0 });
+        }
+
+        template<typename I, std::enable_if_t<std::is_integral_v<I>, int> = 0>
+        counted(I x) : value(Posit(x).value)
+        {
+            detail::thread_counts& t = detail::local_counts();
+            detail::bump(t.conversions);
+            detail::tally(t, posit(), posit().toDouble() == double(x), { double(x), 0.0 });
+        }
+
+        // Wraps a Posit; not counted.
+        explicit counted(const Posit& p) : value(p.value) {}
+
+        Posit posit() const { return detail::with_bits<Posit>(value); }
+        bool isNaR() const { return posit().isNaR(); }
+        double toDouble() const { return posit().toDouble(); }
+
+        explicit operator double() const
+        {
+            detail::bump(detail::local_counts().conversions);
+            return toDouble();
+        }
+
+        explicit operator float() const
+        {
+            detail::thread_counts& t = detail::local_counts();
+            detail::bump(t.conversions);
+            double x = toDouble();
+            if (double(float(x)) != x && !std::isnan(x)) detail::bump(t.roundings);
+            return float(x);
+        }
+
+        friend counted operator+(counted a, counted b) { return sum(a, b, false); }
+        friend counted operator-(counted a, counted b) { return sum(a, b, true); }
+
+        friend counted operator*(counted a, counted b)
+        {
+            detail::thread_counts& t = detail::local_counts();
+            detail::bump(t.muls);
+            Posit r = a.posit() * b.posit();
+            if (!a.isNaR() && !b.isNaR()) {
+                detail::exact_value v = detail::exact_product(a.toDouble(), b.toDouble());
+                detail::tally(t, r, r.toDouble() == v.hi && v.lo == 0, v);
+            }
+            return counted(r);
+        }
+
+        friend counted operator/(counted a, counted b)
+        {
+            detail::thread_counts& t = detail::local_counts();
+            detail::bump(t.divs);
+            Posit r = a.posit() / b.posit();
+            if (!a.isNaR() && !b.isNaR()) {
+                double x = a.toDouble(), y = b.toDouble();
+                detail::exact_value back = detail::exact_product(r.toDouble(), y);
+                detail::tally(t, r, back.hi == x && back.lo == 0, { x / y, 0.0 });
+            }
+            return counted(r);
+        }
+
+        // Negation is exact and needs no arithmetic; not counted.
+        friend counted operator-(counted a) { return counted(-a.posit()); }
+        friend counted operator+(counted a) { return a; }
+
+        counted& operator+=(counted b) { return *this = *this + b; }
+        counted& operator-=(counted b) { return *this = *this - b; }
+        counted& operator*=(counted b) { return *this = *this * b; }
+        counted& operator/=(counted b) { return *this = *this / b; }
+
+        friend bool operator==(counted a, counted b) { return a.posit() == b.posit(); }
+        friend bool operator!=(counted a, counted b) { return a.posit() != b.posit(); }
+        friend bool operator<(counted a, counted b) { return a.posit() < b.posit(); }
+        friend bool operator<=(counted a, counted b) { return a.posit() <= b.posit(); }
+        friend bool operator>(counted a, counted b) { return a.posit() > b.posit(); }
+        friend bool operator>=(counted a, counted b) { return a.posit() >= b.posit(); }
+
+        friend counted abs(counted a) { return !a.isNaR() && a.toDouble() < 0 ? -a : a; }
+
+        friend counted sqrt(counted a)
+        {
+            using std::sqrt;
+            detail::thread_counts& t = detail::local_counts();
+            detail::bump(t.sqrts);
+            Posit r = sqrt(a.posit());
+            if (!a.isNaR()) {
+                double x = a.toDouble();
+                detail::exact_value back = detail::exact_product(r.toDouble(), r.toDouble());
+                detail::tally(t, r, back.hi == x && back.lo == 0, { std::sqrt(x), 0.0 });
+            }
+            return counted(r);
+        }
+
+        friend bool isnan(counted a) { return a.isNaR(); }
+        friend bool isinf(counted) { return false; }
+        friend bool isfinite(counted a) { return !a.isNaR(); }
+
+        friend std::ostream& operator<<(std::ostream& out, counted a) { return out << a.toDouble(); }
+
+    private:
+        static counted sum(counted a, counted b, bool subtract)
+        {
+            detail::thread_counts& t = detail::local_counts();
+            detail::bump(t.adds);
+            Posit r = subtract ? a.posit() - b.posit() : a.posit() + b.posit();
+            if (!a.isNaR() && !b.isNaR()) {
+                double y = b.toDouble();
+                detail::exact_value v = detail::exact_sum(a.toDouble(), subtract ? -y : y);
+                detail::tally(t, r, r.toDouble() == v.hi && v.lo == 0, v);
+            }
+            return counted(r);
+        }
+    };
+}
+
+namespace Eigen
+{
+    template<typename Posit>
+    struct NumTraits<eigen_posit::counted<Posit>>
+        : eigen_posit::detail::posit_num_traits<eigen_posit::counted<Posit>, eigen_posit::detail::posit_format<Posit>::bits,
+                                                eigen_posit::detail::posit_format<Posit>::es, NumTraits<Posit>::posit_costs> {};
+
+namespace internal
+{
+    template<typename Posit>
+    struct functor_traits<scalar_sqrt_op<eigen_posit::counted<Posit>>> : eigen_posit::detail::posit_sqrt_traits<eigen_posit::counted<Posit>> {};
+    template<typename Posit>
+    struct functor_traits<scalar_cast_op<eigen_posit::counted<Posit>, float>> : eigen_posit::detail::posit_cast_traits<eigen_posit::counted<Posit>> {};
+    template<typename Posit>
+    struct functor_traits<scalar_cast_op<eigen_posit::counted<Posit>, double>> : eigen_posit::detail::posit_cast_traits<eigen_posit::counted<Posit>> {};
+    template<typename Posit>
+    struct functor_traits<scalar_cast_op<float, eigen_posit::counted<Posit>>> : eigen_posit::detail::posit_cast_traits<eigen_posit::counted<Posit>> {};
+    template<typename Posit>
+    struct functor_traits<scalar_cast_op<double, eigen_posit::counted<Posit>>> : eigen_posit::detail::posit_cast_traits<eigen_posit::counted<Posit>> {};
+}
+}
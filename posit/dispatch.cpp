@@ -0,0 +1,82 @@
+#include "dispatch.h"
+#include "kernels.h"
+#include "lut.h"
+#include <atomic>
+
+namespace eigen_posit
+{
+namespace detail
+{
+    extern const kernel_set sse42_kernels;
+    extern const kernel_set avx2_kernels;
+    extern const kernel_set avx512_kernels;
+
+    template<typename T, T (*Op)(T, T)>
+    void scalar_binary(const T* a, const T* b, T* out, std::size_t n)
+    {
+        for (std::size_t i{}; i < n; ++i) out[i] = Op(a[i], b[i]);
+    }
+
+    constinit const kernel_set scalar_kernels{
+        isa::scalar, "scalar",
+        [](const uint32_t* in, double* out, std::size_t n) { for (std::size_t i{}; i < n; ++i) out[i] = p32_to_double(in[i]); },
+        [](const double* in, uint32_t* out, std::size_t n) { for (std::size_t i{}; i < n; ++i) out[i] = p32_from_double(in[i]); },
+        [](const uint32_t* in, float* out, std::size_t n) { for (std::size_t i{}; i < n; ++i) out[i] = float(p32_to_double(in[i])); },
+        [](const float* in, uint32_t* out, std::size_t n) { for (std::size_t i{}; i < n; ++i) out[i] = p32_from_double(in[i]); },
+        scalar_binary<uint32_t, p32_add>, scalar_binary<uint32_t, p32_sub>,
+        scalar_binary<uint32_t, p32_mul>, scalar_binary<uint32_t, p32_div>,
+        [](const uint32_t* a, uint32_t* out, std::size_t n) { for (std::size_t i{}; i < n; ++i) out[i] = p32_sqrt(a[i]); },
+        p32_gemm_micro, p32_decoded_update,
+        scalar_binary<uint16_t, p16_add>, scalar_binary<uint16_t, p16_sub>,
+        scalar_binary<uint16_t, p16_mul>, scalar_binary<uint16_t, p16_div>,
+        scalar_binary<uint8_t, p8_add>, scalar_binary<uint8_t, p8_sub>,
+        scalar_binary<uint8_t, p8_mul>, scalar_binary<uint8_t, p8_div>};
+
+    const kernel_set& kernels_for(isa target)
+    {
+        switch (target) {
+            case isa::avx512: return avx512_kernels;
+            case isa::avx2: return avx2_kernels;
+            case isa::sse42: return sse42_kernels;
+            default: return scalar_kernels;
+        }
+    }
+
+    const kernel_set* best_kernels()
+    {
+        for (isa target : {isa::avx512, isa::avx2, isa::sse42})
+            if (isa_supported(target)) return &kernels_for(target);
+        return &scalar_kernels;
+    }
+
+    std::atomic<const kernel_set*> active{nullptr};
+}
+
+    bool isa_supported(isa target)
+    {
+        __builtin_cpu_init();
+        switch (target) {
+            case isa::avx512: return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq");
+            case isa::avx2: return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+            case isa::sse42: return __builtin_cpu_supports("sse4.2");
+            default: return true;
+        }
+    }
+
+    const kernel_set& active_kernels()
+    {
+        const kernel_set* k = detail::active.load(std::memory_order_acquire);
+        if (!k) {
+            k = detail::best_kernels();
+            detail::active.store(k, std::memory_order_release);
+        }
+        return *k;
+    }
+
+    bool select_kernels(isa target)
+    {
+        if (!isa_supported(target)) return false;
+        detail::active.store(&detail::kernels_for(target), std::memory_order_release);
+        return true;
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Runtime-selected bulk posit32 kernels, and posit16/posit8 arithmetic.
+//
+// The kernels here are compiled once per instruction set (dispatch_sse42.cpp,
+// dispatch_avx2.cpp, dispatch_avx512.cpp, each with its own -m flags) and the
+// best one the host supports is bound on first use from cpuid, so a single
+// binary runs on every x86-64 machine and still uses the widest vectors
+// available. A build without -msse4.2 or -mavx2 routes Eigen's posit32 packet
+// arithmetic (packet_math.h) through them, and one without -mavx2 its posit16
+// and posit8 packet arithmetic (lut_packet_math.h); the decoded GEMM
+// micro-kernel (gemm.h) and the LU/QR column updates (lu.h) always go through
+// them. All kernel sets are bit-exact with each other and with the scalar
+// kernels in kernels.h and lut.h.
+namespace eigen_posit
+{
+    enum class isa { scalar, sse42, avx2, avx512 };
+
+    struct kernel_set
+    {
+        isa target;
+        const char* name;
+        void (*decode)(const uint32_t* in, double* out, std::size_t n);
+        void (*encode)(const double* in, uint32_t* out, std::size_t n);
+        void (*decode_float)(const uint32_t* in, float* out, std::size_t n);
+        void (*encode_float)(const float* in, uint32_t* out, std::size_t n);
+        void (*add)(const uint32_t* a, const uint32_t* b, uint32_t* out, std::size_t n);
+        void (*sub)(const uint32_t* a, const uint32_t* b, uint32_t* out, std::size_t n);
+        void (*mul)(const uint32_t* a, const uint32_t* b, uint32_t* out, std::size_t n);
+        void (*div)(const uint32_t* a, const uint32_t* b, uint32_t* out, std::size_t n);
+        void (*sqrt)(const uint32_t* a, uint32_t* out, std::size_t n);
+        // acc(p32_gemm_mr x p32_gemm_nr, column stride ld) += A panel * B panel,
+        // on decoded panels as gemm.h packs them
+        void (*gemm_micro)(const double* a, const double* b, double* acc, int ld, int kc);
+        // y[0, n) -= x[0, n) * u on decoded values, each operation rounded
+        void (*update)(double* y, const double* x, double u, std::size_t n);
+        // the table-driven posit16 and posit8 arithmetic of lut.h
+        void (*p16_add)(const uint16_t* a, const uint16_t* b, uint16_t* out, std::size_t n);
+        void (*p16_sub)(const uint16_t* a, const uint16_t* b, uint16_t* out, std::size_t n);
+        void (*p16_mul)(const uint16_t* a, const uint16_t* b, uint16_t* out, std::size_t n);
+        void (*p16_div)(const uint16_t* a, const uint16_t* b, uint16_t* out, std::size_t n);
+        void (*p8_add)(const uint8_t* a, const uint8_t* b, uint8_t* out, std::size_t n);
+        void (*p8_sub)(const uint8_t* a, const uint8_t* b, uint8_t* out, std::size_t n);
+        void (*p8_mul)(const uint8_t* a, const uint8_t* b, uint8_t* out, std::size_t n);
+        void (*p8_div)(const uint8_t* a, const uint8_t* b, uint8_t* out, std::size_t n);
+    };
+
+    // The kernel set in use; picked from cpuid on the first call. The sets
+    // are constinit, so this is safe from other static initializers too.
+    const kernel_set& active_kernels();
+
+    // Whether the host can run the given kernel set.
+    bool isa_supported(isa target);
+
+    // Rebinds the active kernels, e.g. to compare instruction sets on one host.
+    // Returns false, leaving the binding alone, if the host lacks target.
+    bool select_kernels(isa target);
+}
@@ -0,0 +1,11 @@
+// Build with -mavx2 -mfma.
+#define EIGEN_POSIT_TARGET avx2_target
+#include "dispatch_simd.h"
+
+namespace eigen_posit
+{
+namespace detail
+{
+    extern constinit const kernel_set avx2_kernels = simd_loops<simd::avx2>::make(isa::avx2, "avx2");
+}
+}
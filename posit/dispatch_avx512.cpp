@@ -0,0 +1,11 @@
+// Build with -mavx512f -mavx512dq -mavx2 -mfma.
+#define EIGEN_POSIT_TARGET avx512_target
+#include "dispatch_simd.h"
+
+namespace eigen_posit
+{
+namespace detail
+{
+    extern constinit const kernel_set avx512_kernels = simd_loops<simd::avx512>::make(isa::avx512, "avx512");
+}
+}
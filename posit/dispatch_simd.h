@@ -0,0 +1,130 @@
+#pragma once
+
+#include "dispatch.h"
+#include "kernels.h"
+#include "lut.h"
+#include <algorithm>
+#include <cstring>
+
+// Array loops over the simd:: kernels for one instruction set. Only the
+// dispatch_*.cpp files include this, each compiled for its own target.
+namespace eigen_posit
+{
+namespace detail
+{
+    template<typename Isa>
+    struct simd_loops
+    {
+        using ivec = typename Isa::ivec;
+        using dvec = typename Isa::dvec;
+        static constexpr int lanes = Isa::lanes;
+        static constexpr int half = lanes / 2;
+
+        static ivec load(const uint32_t* p) { ivec v; std::memcpy(&v, p, sizeof v); return v; }
+        static void store(uint32_t* p, ivec v) { std::memcpy(p, &v, sizeof v); }
+        static dvec dload(const double* p) { dvec v; std::memcpy(&v, p, sizeof v); return v; }
+        static void dstore(double* p, dvec v) { std::memcpy(p, &v, sizeof v); }
+
+        static void decode(const uint32_t* in, double* out, std::size_t n)
+        {
+            std::size_t i{};
+            for (; i + lanes <= n; i += lanes) {
+                dvec d0, d1;
+                simd::p32_decode<Isa>(load(in + i), d0, d1);
+                dstore(out + i, d0);
+                dstore(out + i + half, d1);
+            }
+            for (; i < n; ++i) out[i] = p32_to_double(in[i]);
+        }
+
+        static void encode(const double* in, uint32_t* out, std::size_t n)
+        {
+            const dvec zero{};
+            std::size_t i{};
+            for (; i + lanes <= n; i += lanes)
+                store(out + i, simd::p32_encode<Isa>(dload(in + i), dload(in + i + half), zero, zero));
+            for (; i < n; ++i) out[i] = p32_from_double(in[i]);
+        }
+
+        // float goes through double in L1-sized blocks: widening is exact and
+        // narrowing rounds once, from the exact value, as SoftPosit does
+        static constexpr std::size_t block = 512;
+
+        static void decode_float(const uint32_t* in, float* out, std::size_t n)
+        {
+            double buffer[block];
+            for (std::size_t i{}; i < n; i += block) {
+                std::size_t m = std::min(block, n - i);
+                decode(in + i, buffer, m);
+                for (std::size_t j{}; j < m; ++j) out[i + j] = float(buffer[j]);
+            }
+        }
+
+        static void encode_float(const float* in, uint32_t* out, std::size_t n)
+        {
+            double buffer[block];
+            for (std::size_t i{}; i < n; i += block) {
+                std::size_t m = std::min(block, n - i);
+                for (std::size_t j{}; j < m; ++j) buffer[j] = in[i + j];
+                encode(buffer, out + i, m);
+            }
+        }
+
+        template<ivec (*Op)(ivec, ivec), uint32_t (*Scalar)(uint32_t, uint32_t)>
+        static void binary(const uint32_t* a, const uint32_t* b, uint32_t* out, std::size_t n)
+        {
+            std::size_t i{};
+            for (; i + lanes <= n; i += lanes) store(out + i, Op(load(a + i), load(b + i)));
+            for (; i < n; ++i) out[i] = Scalar(a[i], b[i]);
+        }
+
+        template<ivec (*Op)(ivec), uint32_t (*Scalar)(uint32_t)>
+        static void unary(const uint32_t* a, uint32_t* out, std::size_t n)
+        {
+            std::size_t i{};
+            for (; i + lanes <= n; i += lanes) store(out + i, Op(load(a + i)));
+            for (; i < n; ++i) out[i] = Scalar(a[i]);
+        }
+
+        // posit16 and posit8 take 128-bit vectors of 8 and 16 lanes; the
+        // SSE4.2 set has no simd:: versions and runs the table lookups
+        template<typename T, T (*Scalar)(T, T), __m128i (*Op)(__m128i, __m128i) = nullptr>
+        static void small_binary(const T* a, const T* b, T* out, std::size_t n)
+        {
+            constexpr std::size_t width = sizeof(__m128i) / sizeof(T);
+            std::size_t i{};
+            if constexpr (Op != nullptr) {
+                for (; i + width <= n; i += width) {
+                    __m128i x, y;
+                    std::memcpy(&x, a + i, sizeof x);
+                    std::memcpy(&y, b + i, sizeof y);
+                    x = Op(x, y);
+                    std::memcpy(out + i, &x, sizeof x);
+                }
+            }
+            for (; i < n; ++i) out[i] = Scalar(a[i], b[i]);
+        }
+
+        static constexpr kernel_set make(isa target, const char* name)
+        {
+            return {target, name, decode, encode, decode_float, encode_float,
+                    binary<simd::p32_add<Isa>, p32_add>, binary<simd::p32_sub<Isa>, p32_sub>,
+                    binary<simd::p32_mul<Isa>, p32_mul>, binary<simd::p32_div<Isa>, p32_div>,
+                    unary<simd::p32_sqrt<Isa>, p32_sqrt>,
+#if defined(__AVX2__) && defined(__FMA__)
+                    simd::p32_gemm_micro, simd::p32_decoded_update,
+                    small_binary<uint16_t, p16_add, simd::p16_add>, small_binary<uint16_t, p16_sub, simd::p16_sub>,
+                    small_binary<uint16_t, p16_mul, simd::p16_mul>, small_binary<uint16_t, p16_div, simd::p16_div>,
+                    small_binary<uint8_t, p8_add, simd::p8_add>, small_binary<uint8_t, p8_sub, simd::p8_sub>,
+                    small_binary<uint8_t, p8_mul, simd::p8_mul>, small_binary<uint8_t, p8_div, simd::p8_div>};
+#else
+                    p32_gemm_micro, p32_decoded_update,
+                    small_binary<uint16_t, p16_add>, small_binary<uint16_t, p16_sub>,
+                    small_binary<uint16_t, p16_mul>, small_binary<uint16_t, p16_div>,
+                    small_binary<uint8_t, p8_add>, small_binary<uint8_t, p8_sub>,
+                    small_binary<uint8_t, p8_mul>, small_binary<uint8_t, p8_div>};
+#endif
+        }
+    };
+}
+}
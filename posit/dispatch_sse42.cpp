@@ -0,0 +1,11 @@
+// Build with -msse4.2.
+#define EIGEN_POSIT_TARGET sse42_target
+#include "dispatch_simd.h"
+
+namespace eigen_posit
+{
+namespace detail
+{
+    extern constinit const kernel_set sse42_kernels = simd_loops<simd::sse>::make(isa::sse42, "sse4.2");
+}
+}
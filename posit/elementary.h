@@ -0,0 +1,171 @@
+#pragma once
+
+#include "kernels.h"
+#include "lut.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+// Faithful, rarely misrounded exp, log and tanh of posit32 and posit16, and
+// sqrt of posit16 (posit32's is p32_sqrt in kernels.h).
+//
+// posit32 evaluates the function in double, whose result is within
+// elementary_tolerance of the exact value, and rounds it once. When every
+// value that close rounds to the same posit32 (all but about one argument in
+// 2^16), that posit is provably the correctly rounded result. Otherwise the
+// function is evaluated again in long double and rounded from there without
+// a further check: that is correct unless the exact value lies within the
+// long double error (a few units in 2^-64) of a rounding point, and one ulp
+// off at worst. The exact result is never itself a rounding point: exp, log
+// and tanh of a rational other than 0 (or 1 for log) are irrational. The
+// packet versions in packet_math.h run the same scheme on Eigen's double
+// packet functions and fall back on these kernels lane by lane.
+//
+// posit16 has few enough arguments to tabulate: each function is a 64K-entry
+// table, rounded from long double at first use, with the same caveat.
+//
+// Posits do not overflow or underflow: exp saturates at maxpos and minpos.
+// log of zero, of a negative number or of NaR is NaR; exp and tanh of NaR are NaR.
+namespace eigen_posit
+{
+    // Relative error allowed for the double evaluations, with a wide margin:
+    // libm and Eigen's packet exp and log are within a few ulps of double.
+    constexpr double elementary_tolerance = 0x1p-44;
+    // exp reaches maxpos = 2^120 and minpos = 2^-120 by |x| = 84
+    constexpr double p32_exp_limit = 100.0;
+    // tanh rounds to 1 from x = 10
+    constexpr double p32_tanh_limit = 20.0;
+
+    // Rounds y to posit32 if every value within elementary_tolerance of it
+    // rounds the same way.
+    inline bool p32_round_within(double y, uint32_t& out)
+    {
+        double margin = std::fabs(y) * elementary_tolerance;
+        out = p32_from_double(y - margin);
+        return out == p32_from_double(y + margin);
+    }
+
+    inline uint32_t p32_from_long_double(long double y)
+    {
+        double hi = double(y);
+        return p32_from_double(hi, double(y - hi));
+    }
+
+namespace detail
+{
+    // Correctly rounded when the double result settles it; otherwise rounded
+    // from long double, which is faithful but not proven correctly rounded.
+    template<typename F>
+    uint32_t p32_elementary(double x, F f)
+    {
+        uint32_t r;
+        if (p32_round_within(f(x), r)) return r;
+        return p32_from_long_double(f(static_cast<long double>(x)));
+    }
+}
+
+    inline uint32_t p32_exp(uint32_t a)
+    {
+        if (a == p32_nar) return p32_nar;
+        double x = std::clamp(p32_to_double(a), -p32_exp_limit, p32_exp_limit);
+        return detail::p32_elementary(x, [](auto t) { return std::exp(t); });
+    }
+
+    inline uint32_t p32_log(uint32_t a)
+    {
+        if (int32_t(a) <= 0) return p32_nar;
+        return detail::p32_elementary(p32_to_double(a), [](auto t) { return std::log(t); });
+    }
+
+    inline uint32_t p32_tanh(uint32_t a)
+    {
+        if (a == p32_nar) return p32_nar;
+        double x = std::clamp(p32_to_double(a), -p32_tanh_limit, p32_tanh_limit);
+        return detail::p32_elementary(x, [](auto t) { return std::tanh(t); });
+    }
+
+    // f of every posit16, indexed by the argument's bits. The padding lets a
+    // 32-bit gather read the last entry.
+    struct p16_function_table
+    {
+        uint16_t value[1 << 16];
+        uint16_t padding[2]{};
+
+        template<typename F>
+        explicit p16_function_table(F f)
+        {
+            const auto& t = p16_tables();
+            for (uint32_t bits{}; bits < (1u << 16); ++bits) {
+                // NaR decodes to NaN, and NaN and infinities round to NaR
+                long double y = f(static_cast<long double>(t.decode[bits]));
+                float x = float(y);
+                value[bits] = uint16_t(t.round(x, float(y - x)));
+            }
+        }
+    };
+
+    // exp reaches maxpos = 2^28 and minpos = 2^-28 by |x| = 20
+    inline const p16_function_table& p16_exp_table()
+    {
+        static const p16_function_table table([](long double x) { return std::exp(std::clamp(x, -40.0L, 40.0L)); });
+        return table;
+    }
+
+    inline const p16_function_table& p16_log_table()
+    {
+        static const p16_function_table table([](long double x) { return std::log(x); });
+        return table;
+    }
+
+    inline const p16_function_table& p16_tanh_table()
+    {
+        static const p16_function_table table([](long double x) { return std::tanh(x); });
+        return table;
+    }
+
+    inline const p16_function_table& p16_sqrt_table()
+    {
+        static const p16_function_table table([](long double x) { return std::sqrt(x); });
+        return table;
+    }
+
+    inline uint16_t p16_exp(uint16_t a) { return p16_exp_table().value[a]; }
+    inline uint16_t p16_log(uint16_t a) { return p16_log_table().value[a]; }
+    inline uint16_t p16_tanh(uint16_t a) { return p16_tanh_table().value[a]; }
+    inline uint16_t p16_sqrt(uint16_t a) { return p16_sqrt_table().value[a]; }
+
+    // sqrt(a^2 + b^2). The squares are exact in double and so, unless one
+    // is negligible next to the other, is their sum; the root's residual
+    // then breaks ties as in p32_sqrt.
+    inline uint16_t p16_hypot(uint16_t a, uint16_t b)
+    {
+        double x = p16_to_float(a), y = p16_to_float(b);
+        double s = x * x + y * y;
+        double r = std::sqrt(s);
+        float hi = float(r);
+        double rest = r - double(hi);
+        return p16_from_float(hi, rest != 0.0 ? float(rest) : float(std::fma(-r, r, s)));
+    }
+
+#if defined(__AVX2__) && defined(__FMA__)
+namespace simd
+{
+    // Eight posit16 lookups in a p16_function_table.
+    inline __m128i p16_lookup(const p16_function_table& table, __m128i a)
+    {
+        __m256i r = _mm256_i32gather_epi32(reinterpret_cast<const int*>(table.value), _mm256_cvtepu16_epi32(a), 2);
+        r = _mm256_and_si256(r, _mm256_set1_epi32(0xFFFF));
+        return _mm_packus_epi32(_mm256_castsi256_si128(r), _mm256_extracti128_si256(r, 1));
+    }
+
+    inline __m128i p16_exp(__m128i a) { return p16_lookup(p16_exp_table(), a); }
+    inline __m128i p16_log(__m128i a) { return p16_lookup(p16_log_table(), a); }
+    inline __m128i p16_tanh(__m128i a) { return p16_lookup(p16_tanh_table(), a); }
+    inline __m128i p16_sqrt(__m128i a) { return p16_lookup(p16_sqrt_table(), a); }
+}
+#endif
+}
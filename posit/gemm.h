@@ -0,0 +1,380 @@
+#pragma once
+
+#include "dispatch.h"
+#include "packet_math.h"
+#include "parallel.h"
+#include "quire.h"
+#include <algorithm>
+#include <vector>
+
+// Decode-once matrix product for posit32.
+//
+// Eigen's GEBP kernel works on packed posit32 panels, so every multiply-add
+// decodes both operands again: each element of A and B is decoded once per
+// use, O(n) times per element. Here the packing stage decodes each element
+// once into a double panel (sign, scale and significand of the posit in one
+// IEEE word) and the micro-kernel runs on those decoded values. Accumulators
+// stay decoded too, snapped back onto the posit32 grid after every multiply
+// and every add with p32_round, so the result is exactly what the per-op
+// rounded posit dot product gives, summed in k order. Only the outputs are
+// encoded again.
+// Unless EIGEN_POSIT_GEMM_NO_QUIRE is defined, posit32 products accumulate
+// every dot product exactly in a quire and round once per output instead
+// (p32_quire_gemm below), matrix-vector products included (p32_quire_gemv).
+namespace eigen_posit
+{
+namespace detail
+{
+    // micro-tile: gemm_mr rows by gemm_nr columns of independent accumulators,
+    // run by the dispatched gemm_micro kernel (dispatch.h)
+    constexpr int gemm_mr = p32_gemm_mr;
+    constexpr int gemm_nr = p32_gemm_nr;
+    constexpr int gemm_mc = 64;
+    constexpr int gemm_nc = 64;
+    constexpr int gemm_kc = 256;
+
+    // Decodes A(i0:i0+mc, k0:k0+kc) into row panels of gemm_mr, k-major, zero padded.
+    template<int StorageOrder, typename Index>
+    void p32_pack_lhs(double* dst, const posit32* lhs, Index stride, Index i0, Index k0, int mc, int kc)
+    {
+        for (int p{}; p < mc; p += gemm_mr) {
+            for (int k{}; k < kc; ++k) {
+                for (int r{}; r < gemm_mr; ++r) {
+                    Index i = i0 + p + r, kk = k0 + k;
+                    const posit32& v = StorageOrder == Eigen::ColMajor ? lhs[i + kk * stride] : lhs[i * stride + kk];
+                    *dst++ = p + r < mc ? p32_to_double(v.value) : 0.0;
+                }
+            }
+        }
+    }
+
+    // Decodes B(k0:k0+kc, j0:j0+nc) into column panels of gemm_nr, k-major, zero padded.
+    template<int StorageOrder, typename Index>
+    void p32_pack_rhs(double* dst, const posit32* rhs, Index stride, Index k0, Index j0, int kc, int nc)
+    {
+        for (int q{}; q < nc; q += gemm_nr) {
+            for (int k{}; k < kc; ++k) {
+                for (int c{}; c < gemm_nr; ++c) {
+                    Index kk = k0 + k, j = j0 + q + c;
+                    const posit32& v = StorageOrder == Eigen::ColMajor ? rhs[kk + j * stride] : rhs[kk * stride + j];
+                    *dst++ = q + c < nc ? p32_to_double(v.value) : 0.0;
+                }
+            }
+        }
+    }
+
+    constexpr int quire_mr = 4;
+    constexpr int quire_nr = 4;
+    constexpr int quire_mc = 32;
+    constexpr int quire_nc = 32;
+    constexpr int quire_kc = 256;
+
+    // How a storage type enters and leaves the posit32 quire: widen() gives
+    // the exact posit32 bits of a value, store() rounds a posit32 or a quire
+    // into the storage type once. posit8 and posit16 specialize it in
+    // lut_gemm.h, so their products can compute in posit32.
+    template<typename Scalar>
+    struct quire_storage;
+
+    template<>
+    struct quire_storage<posit32>
+    {
+        static uint32_t widen(const posit32& v) { return v.value; }
+        static void store(posit32& r, uint32_t bits) { r.value = bits; }
+        static void store(posit32& r, const p32_quire& q) { r.value = q.to_posit(); }
+    };
+
+    // Same panel layout as p32_pack_lhs, holding unpacked integer operands.
+    // negate flips the sign of every element (alpha = -1); nar collects rows holding NaR.
+    template<int StorageOrder, typename Scalar, typename Index>
+    void p32_unpack_lhs(p32_unpacked* dst, bool* nar, const Scalar* lhs, Index stride, Index i0, Index k0, int mc, int kc, bool negate)
+    {
+        for (int p{}; p < mc; p += quire_mr) {
+            for (int k{}; k < kc; ++k) {
+                for (int r{}; r < quire_mr; ++r) {
+                    Index i = i0 + p + r, kk = k0 + k;
+                    uint32_t v = p + r < mc ? quire_storage<Scalar>::widen(StorageOrder == Eigen::ColMajor ? lhs[i + kk * stride] : lhs[i * stride + kk]) : 0u;
+                    if (v == p32_nar) nar[p + r] = true;
+                    *dst++ = p32_unpack(negate ? 0u - v : v);
+                }
+            }
+        }
+    }
+
+    template<int StorageOrder, typename Scalar, typename Index>
+    void p32_unpack_rhs(p32_unpacked* dst, bool* nar, const Scalar* rhs, Index stride, Index k0, Index j0, int kc, int nc)
+    {
+        for (int q{}; q < nc; q += quire_nr) {
+            for (int k{}; k < kc; ++k) {
+                for (int c{}; c < quire_nr; ++c) {
+                    Index kk = k0 + k, j = j0 + q + c;
+                    uint32_t v = q + c < nc ? quire_storage<Scalar>::widen(StorageOrder == Eigen::ColMajor ? rhs[kk + j * stride] : rhs[kk * stride + j]) : 0u;
+                    if (v == p32_nar) nar[q + c] = true;
+                    *dst++ = p32_unpack(v);
+                }
+            }
+        }
+    }
+
+    // quires(quire_mr x quire_nr, column stride ld) += A panel * B panel, exactly
+    inline void p32_quire_micro_kernel(const p32_unpacked* a, const p32_unpacked* b, p32_quire* q, int ld, int kc)
+    {
+        for (int k{}; k < kc; ++k)
+            for (int j{}; j < quire_nr; ++j)
+                for (int i{}; i < quire_mr; ++i)
+                    q[j * ld + i].add_product(a[k * quire_mr + i], b[k * quire_nr + j]);
+    }
+}
+
+    // res += alpha * lhs * rhs for column-major res, with posit32 rounding after
+    // every operation.
+    template<int LhsStorageOrder, int RhsStorageOrder, typename Index>
+    void p32_gemm(Index rows, Index cols, Index depth,
+                  const posit32* lhs, Index lhsStride, const posit32* rhs, Index rhsStride,
+                  posit32* res, Index resIncr, Index resStride, posit32 alpha)
+    {
+        using namespace detail;
+        constexpr int panel_a = gemm_mc * gemm_kc;
+        constexpr int panel_b = gemm_nc * gemm_kc;
+        constexpr int tile = gemm_mc * gemm_nc;
+        std::vector<double, Eigen::aligned_allocator<double>> buffer(panel_a + panel_b + tile);
+        double* block_a = buffer.data();
+        double* block_b = block_a + panel_a;
+        double* acc = block_b + panel_b;
+        const auto micro = active_kernels().gemm_micro;
+
+        for (Index j0{}; j0 < cols; j0 += gemm_nc) {
+            int nc = int(std::min<Index>(gemm_nc, cols - j0));
+            int ncp = (nc + gemm_nr - 1) / gemm_nr * gemm_nr;
+            for (Index i0{}; i0 < rows; i0 += gemm_mc) {
+                int mc = int(std::min<Index>(gemm_mc, rows - i0));
+                int mcp = (mc + gemm_mr - 1) / gemm_mr * gemm_mr;
+                std::fill(acc, acc + mcp * ncp, 0.0);
+
+                for (Index k0{}; k0 < depth; k0 += gemm_kc) {
+                    int kc = int(std::min<Index>(gemm_kc, depth - k0));
+                    p32_pack_lhs<LhsStorageOrder>(block_a, lhs, lhsStride, i0, k0, mc, kc);
+                    p32_pack_rhs<RhsStorageOrder>(block_b, rhs, rhsStride, k0, j0, kc, nc);
+                    for (int q{}; q < ncp; q += gemm_nr)
+                        for (int p{}; p < mcp; p += gemm_mr)
+                            micro(block_a + p * kc, block_b + q * kc, acc + q * mcp + p, mcp, kc);
+                }
+
+                for (int j{}; j < nc; ++j) {
+                    for (int i{}; i < mc; ++i) {
+                        posit32& r = res[(i0 + i) * resIncr + (j0 + j) * resStride];
+                        uint32_t product = p32_from_double(acc[j * mcp + i]);
+                        if (alpha.value != 0x40000000u) product = p32_mul(alpha.value, product);
+                        r.value = p32_add(r.value, product);
+                    }
+                }
+            }
+        }
+    }
+
+    // res += alpha * lhs * rhs for column-major res, each output a fused dot
+    // product rounded once. With alpha = 1 or -1 (Eigen's =, += and -=) the
+    // existing res value joins the quire too, so the update is rounded once.
+    // Scalar may be any type with a quire_storage, e.g. posit16 operands are
+    // widened while unpacked and results rounded straight to posit16.
+    template<int LhsStorageOrder, int RhsStorageOrder, typename Scalar, typename Index>
+    void p32_quire_gemm(Index rows, Index cols, Index depth,
+                        const Scalar* lhs, Index lhsStride, const Scalar* rhs, Index rhsStride,
+                        Scalar* res, Index resIncr, Index resStride, Scalar alpha)
+    {
+        using namespace detail;
+        typedef quire_storage<Scalar> storage;
+        uint32_t alpha_bits = storage::widen(alpha);
+        bool negate = alpha_bits == 0xC0000000u;
+        bool fused = negate || alpha_bits == 0x40000000u;
+        std::vector<p32_unpacked> block_a(quire_mc * quire_kc), block_b(quire_nc * quire_kc);
+        std::vector<p32_quire> quires(quire_mc * quire_nc);
+        bool nar_rows[quire_mc], nar_cols[quire_nc];
+
+        for (Index j0{}; j0 < cols; j0 += quire_nc) {
+            int nc = int(std::min<Index>(quire_nc, cols - j0));
+            int ncp = (nc + quire_nr - 1) / quire_nr * quire_nr;
+            for (Index i0{}; i0 < rows; i0 += quire_mc) {
+                int mc = int(std::min<Index>(quire_mc, rows - i0));
+                int mcp = (mc + quire_mr - 1) / quire_mr * quire_mr;
+                std::fill(nar_rows, nar_rows + quire_mc, false);
+                std::fill(nar_cols, nar_cols + quire_nc, false);
+                for (int j{}; j < ncp; ++j) {
+                    for (int i{}; i < mcp; ++i) {
+                        p32_quire& q = quires[j * mcp + i];
+                        q.clear();
+                        if (fused && i < mc && j < nc) q.add(storage::widen(res[(i0 + i) * resIncr + (j0 + j) * resStride]));
+                    }
+                }
+
+                for (Index k0{}; k0 < depth; k0 += quire_kc) {
+                    int kc = int(std::min<Index>(quire_kc, depth - k0));
+                    p32_unpack_lhs<LhsStorageOrder>(block_a.data(), nar_rows, lhs, lhsStride, i0, k0, mc, kc, negate);
+                    p32_unpack_rhs<RhsStorageOrder>(block_b.data(), nar_cols, rhs, rhsStride, k0, j0, kc, nc);
+                    for (int q{}; q < ncp; q += quire_nr)
+                        for (int p{}; p < mcp; p += quire_mr)
+                            p32_quire_micro_kernel(block_a.data() + p * kc, block_b.data() + q * kc, quires.data() + q * mcp + p, mcp, kc);
+                    if ((k0 / quire_kc + 1) % p32_quire::normalize_interval(quire_kc) == 0)
+                        for (p32_quire& q : quires) q.normalize();
+                }
+
+                for (int j{}; j < nc; ++j) {
+                    for (int i{}; i < mc; ++i) {
+                        Scalar& r = res[(i0 + i) * resIncr + (j0 + j) * resStride];
+                        const p32_quire& q = quires[j * mcp + i];
+                        if (nar_rows[i] || nar_cols[j]) storage::store(r, p32_nar);
+                        else if (fused) storage::store(r, q);
+                        else storage::store(r, p32_add(storage::widen(r), p32_mul(alpha_bits, q.to_posit())));
+                    }
+                }
+            }
+        }
+    }
+
+    // res += alpha * lhs * rhs for a vector rhs: one quire per row, with alpha
+    // and res folded in as p32_quire_gemm does, so every row is rounded as the
+    // matching column of a matrix product would be. The mappers are Eigen's
+    // GEMV ones; rhs is read as rhs(k, 0) and unpacked once.
+    template<int LhsStorageOrder, typename Scalar, typename Index, typename LhsMapper, typename RhsMapper>
+    void p32_quire_gemv(Index rows, Index cols, const LhsMapper& lhs, const RhsMapper& rhs,
+                        Scalar* res, Index resIncr, Scalar alpha)
+    {
+        using namespace detail;
+        typedef quire_storage<Scalar> storage;
+        uint32_t alpha_bits = storage::widen(alpha);
+        bool negate = alpha_bits == 0xC0000000u;
+        bool fused = negate || alpha_bits == 0x40000000u;
+        std::vector<p32_unpacked> x(cols);
+        bool nar_x{};
+        for (Index k{}; k < cols; ++k) {
+            uint32_t v = storage::widen(rhs(k, 0));
+            if (v == p32_nar) nar_x = true;
+            x[k] = p32_unpack(negate ? 0u - v : v);
+        }
+        const long interval = p32_quire::normalize_interval(1);
+        p32_quire quires[quire_mc];
+        bool nar_rows[quire_mc];
+
+        for (Index i0{}; i0 < rows; i0 += quire_mc) {
+            int mc = int(std::min<Index>(quire_mc, rows - i0));
+            for (int i{}; i < mc; ++i) {
+                quires[i].clear();
+                nar_rows[i] = nar_x;
+                if (fused) quires[i].add(storage::widen(res[(i0 + i) * resIncr]));
+            }
+            auto add = [&](int i, Index k) {
+                uint32_t a = storage::widen(lhs(i0 + i, k));
+                if (a == p32_nar) nar_rows[i] = true;
+                quires[i].add_product(p32_unpack(a), x[k]);
+            };
+            // walk lhs in storage order
+            if (LhsStorageOrder == Eigen::ColMajor) {
+                for (Index k{}; k < cols; ++k) {
+                    for (int i{}; i < mc; ++i) add(i, k);
+                    if ((k + 1) % interval == 0)
+                        for (int i{}; i < mc; ++i) quires[i].normalize();
+                }
+            } else {
+                for (int i{}; i < mc; ++i) {
+                    for (Index k{}; k < cols; ++k) {
+                        add(i, k);
+                        if ((k + 1) % interval == 0) quires[i].normalize();
+                    }
+                }
+            }
+
+            for (int i{}; i < mc; ++i) {
+                Scalar& r = res[(i0 + i) * resIncr];
+                if (nar_rows[i]) storage::store(r, p32_nar);
+                else if (fused) storage::store(r, quires[i]);
+                else storage::store(r, p32_add(storage::widen(r), p32_mul(alpha_bits, quires[i].to_posit())));
+            }
+        }
+    }
+}
+
+namespace Eigen
+{
+namespace internal
+{
+    // Column-major destinations; Eigen's row-major specialization transposes
+    // into this one, so every posit32 GEMM ends up here.
+    template<typename Index, int LhsStorageOrder, bool ConjugateLhs, int RhsStorageOrder, bool ConjugateRhs, int ResInnerStride>
+    struct general_matrix_matrix_product<Index, posit32, LhsStorageOrder, ConjugateLhs, posit32, RhsStorageOrder, ConjugateRhs, ColMajor, ResInnerStride>
+    {
+        typedef gebp_traits<posit32, posit32> Traits;
+        typedef posit32 ResScalar;
+
+        static void run(Index rows, Index cols, Index depth,
+                        const posit32* lhs, Index lhsStride,
+                        const posit32* rhs, Index rhsStride,
+                        posit32* res, Index resIncr, Index resStride,
+                        posit32 alpha,
+                        level3_blocking<posit32, posit32>& /*blocking*/,
+                        GemmParallelInfo<Index>* info = 0)
+        {
+            // With info set Eigen's OpenMP driver has already split the product.
+            if (info) {
+                kernel(rows, cols, depth, lhs, lhsStride, rhs, rhsStride, res, resIncr, resStride, alpha);
+                return;
+            }
+            // Slice the longer side of the result so every slice repacks the
+            // smaller share of the operands.
+            if (rows > cols) {
+                eigen_posit::parallel_slices(rows, Index(8), double(cols) * double(depth), [&](Index i0, Index i1) {
+                    kernel(i1 - i0, cols, depth, lhs + (LhsStorageOrder == ColMajor ? i0 : i0 * lhsStride), lhsStride,
+                           rhs, rhsStride, res + i0 * resIncr, resIncr, resStride, alpha);
+                });
+            } else {
+                eigen_posit::parallel_slices(cols, Index(8), double(rows) * double(depth), [&](Index j0, Index j1) {
+                    kernel(rows, j1 - j0, depth, lhs, lhsStride,
+                           rhs + (RhsStorageOrder == ColMajor ? j0 * rhsStride : j0), rhsStride,
+                           res + j0 * resStride, resIncr, resStride, alpha);
+                });
+            }
+        }
+
+        static void kernel(Index rows, Index cols, Index depth,
+                           const posit32* lhs, Index lhsStride,
+                           const posit32* rhs, Index rhsStride,
+                           posit32* res, Index resIncr, Index resStride,
+                           posit32 alpha)
+        {
+#ifdef EIGEN_POSIT_GEMM_NO_QUIRE
+            eigen_posit::p32_gemm<LhsStorageOrder, RhsStorageOrder>(rows, cols, depth, lhs, lhsStride, rhs, rhsStride,
+                                                                   res, resIncr, resStride, alpha);
+#else
+            eigen_posit::p32_quire_gemm<LhsStorageOrder, RhsStorageOrder>(rows, cols, depth, lhs, lhsStride, rhs, rhsStride,
+                                                                         res, resIncr, resStride, alpha);
+#endif
+        }
+    };
+
+#ifndef EIGEN_POSIT_GEMM_NO_QUIRE
+    // Matrix-vector products, and products whose rhs has one column at run
+    // time, come here instead of the GEMM above; they accumulate in the quire
+    // too, so a product's rounding does not depend on its column count.
+    template<typename Index, typename LhsMapper, int LhsStorageOrder, typename RhsMapper>
+    struct posit32_gemv
+    {
+        typedef posit32 ResScalar;
+
+        static void run(Index rows, Index cols, const LhsMapper& lhs, const RhsMapper& rhs,
+                        posit32* res, Index resIncr, posit32 alpha)
+        {
+            eigen_posit::parallel_slices(rows, Index(eigen_posit::detail::quire_mc), double(cols), [&](Index i0, Index i1) {
+                eigen_posit::p32_quire_gemv<LhsStorageOrder>(i1 - i0, cols, lhs.getSubMapper(i0, 0), rhs, res + i0 * resIncr, resIncr, alpha);
+            });
+        }
+    };
+
+    template<typename Index, typename LhsMapper, bool ConjugateLhs, typename RhsMapper, bool ConjugateRhs, int Version>
+    struct general_matrix_vector_product<Index, posit32, LhsMapper, ColMajor, ConjugateLhs, posit32, RhsMapper, ConjugateRhs, Version>
+        : posit32_gemv<Index, LhsMapper, ColMajor, RhsMapper> {};
+
+    template<typename Index, typename LhsMapper, bool ConjugateLhs, typename RhsMapper, bool ConjugateRhs, int Version>
+    struct general_matrix_vector_product<Index, posit32, LhsMapper, RowMajor, ConjugateLhs, posit32, RhsMapper, ConjugateRhs, Version>
+        : posit32_gemv<Index, LhsMapper, RowMajor, RhsMapper> {};
+#endif
+}
+}
@@ -0,0 +1,598 @@
+#pragma once
+
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#if defined(__SSE4_2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Bit-exact posit32 (es = 2) arithmetic on top of IEEE double.
+//
+// Every posit32 is exactly representable as a double, and so is every
+// midpoint between two neighbouring posit32 values. An operation is therefore
+// evaluated by decoding both operands exactly, computing the rounded double
+// result x together with its exact error err (true result = x + err) using
+// error-free transformations, and rounding x to posit32. Rounding x can only
+// disagree with rounding the true result when x lands exactly on a midpoint,
+// and in that case the sign of err tells which side the true result is on.
+// That keeps these kernels bit-exact with SoftPosit's p32_add/sub/mul/div.
+//
+// The translation units that build these kernels for one instruction set
+// (dispatch.h) define EIGEN_POSIT_TARGET, which moves their copies of the
+// inline functions below into an inline namespace of their own so they
+// cannot be merged with copies built for the baseline target.
+#ifndef EIGEN_POSIT_TARGET
+#define EIGEN_POSIT_TARGET baseline
+#endif
+
+namespace eigen_posit
+{
+inline namespace EIGEN_POSIT_TARGET
+{
+    constexpr uint32_t p32_nar = 0x80000000u;
+    constexpr uint32_t p32_maxpos = 0x7FFFFFFFu;
+    constexpr uint32_t p32_minpos = 0x00000001u;
+    constexpr uint32_t p32_one = 0x40000000u;
+
+    inline double p32_to_double(uint32_t bits)
+    {
+        if (bits == 0) return 0.0;
+        if (bits == p32_nar) return std::numeric_limits<double>::quiet_NaN();
+
+        uint32_t sign = bits >> 31;
+        uint32_t body = (sign ? 0u - bits : bits) << 1;
+        uint32_t inv = uint32_t(int32_t(body) >> 31);
+        int lz = std::countl_zero(body ^ inv);
+        int k = inv ? lz - 1 : -lz;
+        uint32_t rest = lz + 1 < 32 ? body << (lz + 1) : 0u;
+        int scale = 4 * k + int(rest >> 30);
+        uint64_t frac = uint64_t(rest << 2);
+
+        return std::bit_cast<double>(uint64_t(sign) << 63 | uint64_t(scale + 1023) << 52 | frac << 20);
+    }
+
+    // Rounds x to the nearest posit32. err only contributes its sign: it is
+    // the exact residual of the computation that produced x, or 0 when x is
+    // exact.
+    inline uint32_t p32_from_double(double x, double err = 0.0)
+    {
+        if (x == 0.0) return 0;
+        if (!std::isfinite(x)) return p32_nar;
+
+        uint64_t bits = std::bit_cast<uint64_t>(x);
+        bool negative = bits >> 63;
+        int scale = int((bits >> 52) & 0x7FF) - 1023;
+        uint64_t mant = bits & ((uint64_t(1) << 52) - 1);
+
+        uint32_t body;
+        if (scale >= 120) body = p32_maxpos;
+        else if (scale < -120) body = p32_minpos;
+        else {
+            int k = scale >> 2;
+            int r = k >= 0 ? k + 2 : 1 - k;
+            uint64_t tail = uint64_t(scale & 3) << 62 | mant << 10;
+            uint64_t regime = k >= 0 ? ~uint64_t(0) << (63 - k) : uint64_t(1) << (63 + k);
+            uint64_t full = regime | tail >> r;
+            bool sticky = (full & 0xFFFFFFFFu) != 0 || (tail << (64 - r)) != 0;
+            bool round = (full >> 32) & 1;
+            body = uint32_t(full >> 33);
+
+            int dir = err == 0.0 ? 0 : ((err > 0.0) != negative ? 1 : -1);
+            if (round && (sticky || dir > 0 || (dir == 0 && (body & 1)))) ++body;
+        }
+        return negative ? 0u - body : body;
+    }
+
+    // Same rounding as p32_from_double, but the result stays decoded. Inside
+    // |x| in [2^-108, 2^108) a posit32 keeps at least one fraction bit, so the
+    // rounding is a plain round-to-nearest-even on the double's mantissa.
+    inline double p32_round(double x, double err = 0.0)
+    {
+        uint64_t bits = std::bit_cast<uint64_t>(x);
+        int k = int((((bits >> 52) & 0x7FF) + 1) >> 2) - 256;
+        if (k < -27 || k > 26) return x == 0.0 ? 0.0 : p32_to_double(p32_from_double(x, err));
+
+        int drop = k >= 0 ? 25 + k : 24 - k;
+        uint64_t unit = uint64_t(1) << drop;
+        uint64_t low = bits & (unit - 1);
+        bits -= low;
+        int dir = err == 0.0 ? 0 : ((err > 0.0) != (x < 0.0) ? 1 : -1);
+        if (low > unit / 2 || (low == unit / 2 && (dir > 0 || (dir == 0 && (bits & unit))))) bits += unit;
+        return std::bit_cast<double>(bits);
+    }
+
+    inline double two_sum_err(double a, double b, double s)
+    {
+        double bb = s - a;
+        return (a - (s - bb)) + (b - bb);
+    }
+
+    inline uint32_t p32_add(uint32_t a, uint32_t b)
+    {
+        double x = p32_to_double(a), y = p32_to_double(b);
+        double s = x + y;
+        return p32_from_double(s, two_sum_err(x, y, s));
+    }
+
+    inline uint32_t p32_sub(uint32_t a, uint32_t b)
+    {
+        return p32_add(a, 0u - b);
+    }
+
+    inline uint32_t p32_mul(uint32_t a, uint32_t b)
+    {
+        double x = p32_to_double(a), y = p32_to_double(b);
+        double p = x * y;
+        return p32_from_double(p, std::fma(x, y, -p));
+    }
+
+    inline uint32_t p32_div(uint32_t a, uint32_t b)
+    {
+        double x = p32_to_double(a), y = p32_to_double(b);
+        double q = x / y;
+        double r = std::fma(-q, y, x);
+        return p32_from_double(q, y < 0.0 ? -r : r);
+    }
+
+    // The double square root is correctly rounded to 53 bits, so no posit32
+    // midpoint lies strictly between it and the exact root.
+    inline uint32_t p32_sqrt(uint32_t a)
+    {
+        if (int32_t(a) < 0) return p32_nar;
+        double x = p32_to_double(a);
+        double r = std::sqrt(x);
+        return p32_from_double(r, std::fma(-r, r, x));
+    }
+
+    // Decoded kernels: posit32 values held as doubles, every product and sum
+    // snapped back onto the posit32 grid with p32_round. gemm.h and lu.h call
+    // them through dispatch.h.
+    constexpr int p32_gemm_mr = 8;
+    constexpr int p32_gemm_nr = 4;
+
+    inline double p32_fma_step(double acc, double a, double b)
+    {
+        double p = a * b;
+        p = p32_round(p, std::fma(a, b, -p));
+        double s = acc + p;
+        return p32_round(s, two_sum_err(acc, p, s));
+    }
+
+    // acc(p32_gemm_mr x p32_gemm_nr, column stride ld) += A panel * B panel over kc steps
+    inline void p32_gemm_micro(const double* a, const double* b, double* acc, int ld, int kc)
+    {
+        for (int k{}; k < kc; ++k)
+            for (int j{}; j < p32_gemm_nr; ++j)
+                for (int i{}; i < p32_gemm_mr; ++i)
+                    acc[j * ld + i] = p32_fma_step(acc[j * ld + i], a[k * p32_gemm_mr + i], b[k * p32_gemm_nr + j]);
+    }
+
+    // y[0, n) -= x[0, n) * u, product and difference each rounded
+    inline void p32_decoded_update(double* y, const double* x, double u, std::size_t n)
+    {
+        for (std::size_t i{}; i < n; ++i) {
+            double p = x[i] * u;
+            p = p32_round(p, std::fma(x[i], u, -p));
+            double s = y[i] - p;
+            y[i] = p32_round(s, two_sum_err(y[i], -p, s));
+        }
+    }
+
+    // The SIMD kernels below run the same algorithm lane-wise. Decoding and
+    // encoding happen on 32-bit lanes (one posit per lane); the arithmetic
+    // runs on two double vectors holding the low and high halves of the lanes.
+    // Each instruction set provides the handful of primitives the algorithm
+    // needs, so the algorithm itself is written once.
+    namespace simd
+    {
+#if defined(__SSE4_2__)
+        struct sse
+        {
+            using ivec = __m128i;
+            using dvec = __m128d;
+            static constexpr int lanes = 4;
+
+            static ivec set1(int32_t v) { return _mm_set1_epi32(v); }
+            static ivec add(ivec a, ivec b) { return _mm_add_epi32(a, b); }
+            static ivec sub(ivec a, ivec b) { return _mm_sub_epi32(a, b); }
+            static ivec and_(ivec a, ivec b) { return _mm_and_si128(a, b); }
+            static ivec or_(ivec a, ivec b) { return _mm_or_si128(a, b); }
+            static ivec xor_(ivec a, ivec b) { return _mm_xor_si128(a, b); }
+            static ivec andnot(ivec mask, ivec a) { return _mm_andnot_si128(mask, a); }
+            template<int N> static ivec slli(ivec a) { return _mm_slli_epi32(a, N); }
+            template<int N> static ivec srli(ivec a) { return _mm_srli_epi32(a, N); }
+            template<int N> static ivec srai(ivec a) { return _mm_srai_epi32(a, N); }
+            static ivec cmpeq(ivec a, ivec b) { return _mm_cmpeq_epi32(a, b); }
+            static ivec cmpgt(ivec a, ivec b) { return _mm_cmpgt_epi32(a, b); }
+            static ivec select(ivec mask, ivec a, ivec b) { return _mm_blendv_epi8(b, a, mask); }
+
+            // 2^n for n in [0, 31], built through the float exponent field.
+            static ivec pow2(ivec n)
+            {
+                return _mm_cvttps_epi32(_mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23)));
+            }
+            // Per-lane shifts; counts outside [0, 31] yield 0 like AVX2.
+            static ivec sllv(ivec a, ivec n)
+            {
+                ivec out_of_range = _mm_or_si128(_mm_cmpgt_epi32(n, _mm_set1_epi32(31)), _mm_cmplt_epi32(n, _mm_setzero_si128()));
+                return _mm_andnot_si128(out_of_range, _mm_mullo_epi32(a, pow2(n)));
+            }
+            // Right shift as the high half of a * 2^(32 - n), valid for n in [1, 31].
+            static ivec srlv(ivec a, ivec n)
+            {
+                ivec m = pow2(_mm_sub_epi32(_mm_set1_epi32(32), n));
+                ivec even = _mm_srli_epi64(_mm_mul_epu32(a, m), 32);
+                ivec odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(m, 32));
+                return _mm_blend_epi16(even, odd, 0xCC);
+            }
+            // floor(log2(a)) for a in [1, 2^31).
+            static ivec log2(ivec a)
+            {
+                ivec top = _mm_andnot_si128(_mm_srli_epi32(a, 1), a);
+                ivec f = _mm_castps_si128(_mm_cvtepi32_ps(top));
+                return _mm_sub_epi32(_mm_srli_epi32(f, 23), _mm_set1_epi32(127));
+            }
+
+            static dvec dadd(dvec a, dvec b) { return _mm_add_pd(a, b); }
+            static dvec dsub(dvec a, dvec b) { return _mm_sub_pd(a, b); }
+            static dvec dmul(dvec a, dvec b) { return _mm_mul_pd(a, b); }
+            static dvec ddiv(dvec a, dvec b) { return _mm_div_pd(a, b); }
+            static dvec dsqrt(dvec a) { return _mm_sqrt_pd(a); }
+            static dvec dneg_if(dvec a, dvec sign_of) { return _mm_xor_pd(a, _mm_and_pd(sign_of, _mm_set1_pd(-0.0))); }
+            // Exact a * b - p for p = fl(a * b).
+            static dvec dmul_err(dvec a, dvec b, dvec p)
+            {
+#if defined(__FMA__)
+                return _mm_fmsub_pd(a, b, p);
+#else
+                const dvec split = _mm_set1_pd(134217729.0);
+                dvec ta = _mm_mul_pd(a, split), tb = _mm_mul_pd(b, split);
+                dvec ah = _mm_sub_pd(ta, _mm_sub_pd(ta, a)), al = _mm_sub_pd(a, ah);
+                dvec bh = _mm_sub_pd(tb, _mm_sub_pd(tb, b)), bl = _mm_sub_pd(b, bh);
+                dvec e = _mm_sub_pd(_mm_mul_pd(ah, bh), p);
+                e = _mm_add_pd(e, _mm_mul_pd(ah, bl));
+                e = _mm_add_pd(e, _mm_mul_pd(al, bh));
+                return _mm_add_pd(e, _mm_mul_pd(al, bl));
+#endif
+            }
+
+            // Interleave 32-bit high/low words into doubles and back.
+            static void join(ivec hi, ivec lo, dvec& d0, dvec& d1)
+            {
+                d0 = _mm_castsi128_pd(_mm_unpacklo_epi32(lo, hi));
+                d1 = _mm_castsi128_pd(_mm_unpackhi_epi32(lo, hi));
+            }
+            static void split(dvec d0, dvec d1, ivec& hi, ivec& lo)
+            {
+                __m128 a = _mm_castpd_ps(d0), b = _mm_castpd_ps(d1);
+                hi = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+                lo = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            }
+        };
+#endif
+
+#if defined(__AVX2__) && defined(__FMA__)
+        struct avx2
+        {
+            using ivec = __m256i;
+            using dvec = __m256d;
+            static constexpr int lanes = 8;
+
+            static ivec set1(int32_t v) { return _mm256_set1_epi32(v); }
+            static ivec add(ivec a, ivec b) { return _mm256_add_epi32(a, b); }
+            static ivec sub(ivec a, ivec b) { return _mm256_sub_epi32(a, b); }
+            static ivec and_(ivec a, ivec b) { return _mm256_and_si256(a, b); }
+            static ivec or_(ivec a, ivec b) { return _mm256_or_si256(a, b); }
+            static ivec xor_(ivec a, ivec b) { return _mm256_xor_si256(a, b); }
+            static ivec andnot(ivec mask, ivec a) { return _mm256_andnot_si256(mask, a); }
+            template<int N> static ivec slli(ivec a) { return _mm256_slli_epi32(a, N); }
+            template<int N> static ivec srli(ivec a) { return _mm256_srli_epi32(a, N); }
+            template<int N> static ivec srai(ivec a) { return _mm256_srai_epi32(a, N); }
+            static ivec cmpeq(ivec a, ivec b) { return _mm256_cmpeq_epi32(a, b); }
+            static ivec cmpgt(ivec a, ivec b) { return _mm256_cmpgt_epi32(a, b); }
+            static ivec select(ivec mask, ivec a, ivec b) { return _mm256_blendv_epi8(b, a, mask); }
+            static ivec sllv(ivec a, ivec n) { return _mm256_sllv_epi32(a, n); }
+            static ivec srlv(ivec a, ivec n) { return _mm256_srlv_epi32(a, n); }
+            static ivec log2(ivec a)
+            {
+                ivec top = _mm256_andnot_si256(_mm256_srli_epi32(a, 1), a);
+                ivec f = _mm256_castps_si256(_mm256_cvtepi32_ps(top));
+                return _mm256_sub_epi32(_mm256_srli_epi32(f, 23), _mm256_set1_epi32(127));
+            }
+
+            static dvec dadd(dvec a, dvec b) { return _mm256_add_pd(a, b); }
+            static dvec dsub(dvec a, dvec b) { return _mm256_sub_pd(a, b); }
+            static dvec dmul(dvec a, dvec b) { return _mm256_mul_pd(a, b); }
+            static dvec ddiv(dvec a, dvec b) { return _mm256_div_pd(a, b); }
+            static dvec dsqrt(dvec a) { return _mm256_sqrt_pd(a); }
+            static dvec dneg_if(dvec a, dvec sign_of) { return _mm256_xor_pd(a, _mm256_and_pd(sign_of, _mm256_set1_pd(-0.0))); }
+            static dvec dmul_err(dvec a, dvec b, dvec p) { return _mm256_fmsub_pd(a, b, p); }
+
+            static void join(ivec hi, ivec lo, dvec& d0, dvec& d1)
+            {
+                ivec a = _mm256_unpacklo_epi32(lo, hi);
+                ivec b = _mm256_unpackhi_epi32(lo, hi);
+                d0 = _mm256_castsi256_pd(_mm256_permute2x128_si256(a, b, 0x20));
+                d1 = _mm256_castsi256_pd(_mm256_permute2x128_si256(a, b, 0x31));
+            }
+            static void split(dvec d0, dvec d1, ivec& hi, ivec& lo)
+            {
+                __m256 a = _mm256_castpd_ps(_mm256_permute2f128_pd(d0, d1, 0x20));
+                __m256 b = _mm256_castpd_ps(_mm256_permute2f128_pd(d0, d1, 0x31));
+                hi = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+                lo = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            }
+        };
+#endif
+
+#if defined(__AVX512F__) && defined(__AVX512DQ__)
+        struct avx512
+        {
+            using ivec = __m512i;
+            using dvec = __m512d;
+            static constexpr int lanes = 16;
+
+            static ivec set1(int32_t v) { return _mm512_set1_epi32(v); }
+            static ivec add(ivec a, ivec b) { return _mm512_add_epi32(a, b); }
+            static ivec sub(ivec a, ivec b) { return _mm512_sub_epi32(a, b); }
+            static ivec and_(ivec a, ivec b) { return _mm512_and_si512(a, b); }
+            static ivec or_(ivec a, ivec b) { return _mm512_or_si512(a, b); }
+            static ivec xor_(ivec a, ivec b) { return _mm512_xor_si512(a, b); }
+            static ivec andnot(ivec mask, ivec a) { return _mm512_andnot_si512(mask, a); }
+            template<int N> static ivec slli(ivec a) { return _mm512_slli_epi32(a, N); }
+            template<int N> static ivec srli(ivec a) { return _mm512_srli_epi32(a, N); }
+            template<int N> static ivec srai(ivec a) { return _mm512_srai_epi32(a, N); }
+            // comparisons return full-width lane masks like the other instruction sets
+            static ivec cmpeq(ivec a, ivec b) { return _mm512_movm_epi32(_mm512_cmpeq_epi32_mask(a, b)); }
+            static ivec cmpgt(ivec a, ivec b) { return _mm512_movm_epi32(_mm512_cmpgt_epi32_mask(a, b)); }
+            static ivec select(ivec mask, ivec a, ivec b) { return _mm512_mask_blend_epi32(_mm512_movepi32_mask(mask), b, a); }
+            static ivec sllv(ivec a, ivec n) { return _mm512_sllv_epi32(a, n); }
+            static ivec srlv(ivec a, ivec n) { return _mm512_srlv_epi32(a, n); }
+            static ivec log2(ivec a)
+            {
+                ivec top = _mm512_andnot_si512(_mm512_srli_epi32(a, 1), a);
+                ivec f = _mm512_castps_si512(_mm512_cvtepi32_ps(top));
+                return _mm512_sub_epi32(_mm512_srli_epi32(f, 23), _mm512_set1_epi32(127));
+            }
+
+            static dvec dadd(dvec a, dvec b) { return _mm512_add_pd(a, b); }
+            static dvec dsub(dvec a, dvec b) { return _mm512_sub_pd(a, b); }
+            static dvec dmul(dvec a, dvec b) { return _mm512_mul_pd(a, b); }
+            static dvec ddiv(dvec a, dvec b) { return _mm512_div_pd(a, b); }
+            static dvec dsqrt(dvec a) { return _mm512_sqrt_pd(a); }
+            static dvec dneg_if(dvec a, dvec sign_of) { return _mm512_xor_pd(a, _mm512_and_pd(sign_of, _mm512_set1_pd(-0.0))); }
+            static dvec dmul_err(dvec a, dvec b, dvec p) { return _mm512_fmsub_pd(a, b, p); }
+
+            static void join(ivec hi, ivec lo, dvec& d0, dvec& d1)
+            {
+                d0 = _mm512_castsi512_pd(_mm512_permutex2var_epi32(lo, _mm512_setr_epi32(0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23), hi));
+                d1 = _mm512_castsi512_pd(_mm512_permutex2var_epi32(lo, _mm512_setr_epi32(8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31), hi));
+            }
+            static void split(dvec d0, dvec d1, ivec& hi, ivec& lo)
+            {
+                __m512i a = _mm512_castpd_si512(d0), b = _mm512_castpd_si512(d1);
+                hi = _mm512_permutex2var_epi32(a, _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31), b);
+                lo = _mm512_permutex2var_epi32(a, _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30), b);
+            }
+        };
+#endif
+
+        template<typename Isa>
+        inline void p32_decode(typename Isa::ivec x, typename Isa::dvec& d0, typename Isa::dvec& d1)
+        {
+            using I = Isa;
+            auto sign = I::template srai<31>(x);
+            auto body = I::template slli<1>(I::sub(I::xor_(x, sign), sign));
+            auto inv = I::template srai<31>(body);
+            auto lz = I::sub(I::set1(31), I::log2(I::xor_(body, inv)));
+            auto k = I::xor_(I::sub(I::set1(0), lz), inv);
+            auto rest = I::sllv(body, I::add(lz, I::set1(1)));
+            auto frac = I::template slli<2>(rest);
+            auto biased = I::add(I::add(I::template slli<2>(k), I::template srli<30>(rest)), I::set1(1023));
+
+            auto hi = I::or_(I::or_(I::and_(sign, I::set1(int32_t(0x80000000u))), I::template slli<20>(biased)),
+                             I::template srli<12>(frac));
+            auto lo = I::template slli<20>(frac);
+
+            // zero and NaR both have an empty body; NaR becomes a quiet NaN
+            auto special = I::cmpeq(body, I::set1(0));
+            hi = I::select(special, I::and_(sign, I::set1(0x7FF80000)), hi);
+            lo = I::andnot(special, lo);
+            I::join(hi, lo, d0, d1);
+        }
+
+        template<typename Isa>
+        inline typename Isa::ivec p32_encode(typename Isa::dvec x0, typename Isa::dvec x1,
+                                             typename Isa::dvec err0, typename Isa::dvec err1)
+        {
+            using I = Isa;
+            typename I::ivec hi, lo, ehi, elo;
+            I::split(x0, x1, hi, lo);
+            I::split(err0, err1, ehi, elo);
+
+            auto zero = I::set1(0);
+            auto sign = I::template srai<31>(hi);
+            auto biased = I::and_(I::template srli<20>(hi), I::set1(0x7FF));
+            auto k = I::sub(I::template srli<2>(I::add(biased, I::set1(1))), I::set1(256));
+            auto e = I::and_(I::add(biased, I::set1(1)), I::set1(3));
+            auto mant = I::or_(I::template slli<10>(I::and_(hi, I::set1(0xFFFFF))), I::template srli<22>(lo));
+            auto tail = I::or_(I::template slli<30>(e), mant);
+
+            auto kneg = I::cmpgt(zero, k);
+            auto r = I::select(kneg, I::sub(I::set1(1), k), I::add(k, I::set1(2)));
+            auto regime = I::select(kneg, I::sllv(I::set1(1), I::add(k, I::set1(31))),
+                                    I::sllv(I::set1(-1), I::sub(I::set1(31), k)));
+            auto full = I::or_(regime, I::srlv(tail, r));
+
+            auto exact = I::and_(I::cmpeq(I::and_(lo, I::set1(0x3FFFFF)), zero),
+                                 I::cmpeq(I::sllv(tail, I::sub(I::set1(32), r)), zero));
+            auto err_nonzero = I::xor_(I::cmpeq(I::or_(I::template slli<1>(ehi), elo), zero), I::set1(-1));
+            auto err_opposite = I::template srai<31>(I::xor_(ehi, hi));
+            auto body = I::template srli<1>(full);
+            auto round = I::cmpeq(I::and_(full, I::set1(1)), I::set1(1));
+            auto odd = I::cmpeq(I::and_(body, I::set1(1)), I::set1(1));
+            auto up = I::and_(round, I::or_(I::or_(I::xor_(exact, I::set1(-1)), I::andnot(err_opposite, err_nonzero)),
+                                            I::andnot(err_nonzero, odd)));
+            body = I::sub(body, up);
+
+            body = I::select(I::cmpgt(k, I::set1(29)), I::set1(int32_t(p32_maxpos)), body);
+            body = I::select(I::cmpgt(I::set1(-30), k), I::set1(int32_t(p32_minpos)), body);
+            auto result = I::sub(I::xor_(body, sign), sign);
+
+            result = I::andnot(I::cmpeq(I::or_(I::template slli<1>(hi), lo), zero), result);
+            return I::select(I::cmpeq(biased, I::set1(0x7FF)), I::set1(int32_t(p32_nar)), result);
+        }
+
+        template<typename Isa>
+        inline typename Isa::dvec two_sum_err(typename Isa::dvec a, typename Isa::dvec b, typename Isa::dvec s)
+        {
+            using I = Isa;
+            auto bb = I::dsub(s, a);
+            return I::dadd(I::dsub(a, I::dsub(s, bb)), I::dsub(b, bb));
+        }
+
+        template<typename Isa>
+        inline typename Isa::ivec p32_add(typename Isa::ivec a, typename Isa::ivec b)
+        {
+            using I = Isa;
+            typename I::dvec a0, a1, b0, b1;
+            p32_decode<I>(a, a0, a1);
+            p32_decode<I>(b, b0, b1);
+            auto s0 = I::dadd(a0, b0), s1 = I::dadd(a1, b1);
+            return p32_encode<I>(s0, s1, two_sum_err<I>(a0, b0, s0), two_sum_err<I>(a1, b1, s1));
+        }
+
+        template<typename Isa>
+        inline typename Isa::ivec p32_sub(typename Isa::ivec a, typename Isa::ivec b)
+        {
+            return p32_add<Isa>(a, Isa::sub(Isa::set1(0), b));
+        }
+
+        template<typename Isa>
+        inline typename Isa::ivec p32_mul(typename Isa::ivec a, typename Isa::ivec b)
+        {
+            using I = Isa;
+            typename I::dvec a0, a1, b0, b1;
+            p32_decode<I>(a, a0, a1);
+            p32_decode<I>(b, b0, b1);
+            auto p0 = I::dmul(a0, b0), p1 = I::dmul(a1, b1);
+            return p32_encode<I>(p0, p1, I::dmul_err(a0, b0, p0), I::dmul_err(a1, b1, p1));
+        }
+
+        template<typename Isa>
+        inline typename Isa::ivec p32_div(typename Isa::ivec a, typename Isa::ivec b)
+        {
+            using I = Isa;
+            typename I::dvec a0, a1, b0, b1;
+            p32_decode<I>(a, a0, a1);
+            p32_decode<I>(b, b0, b1);
+            auto q0 = I::ddiv(a0, b0), q1 = I::ddiv(a1, b1);
+            // a - q * b is exact; its sign relative to b says which side of q the quotient is
+            auto r0 = I::dneg_if(I::dsub(I::dsub(a0, I::dmul(q0, b0)), I::dmul_err(q0, b0, I::dmul(q0, b0))), b0);
+            auto r1 = I::dneg_if(I::dsub(I::dsub(a1, I::dmul(q1, b1)), I::dmul_err(q1, b1, I::dmul(q1, b1))), b1);
+            return p32_encode<I>(q0, q1, r0, r1);
+        }
+
+        // The double root is correctly rounded and x - r^2 is exact, so its
+        // sign tells which side of r the root is on, as in p32_sqrt.
+        template<typename Isa>
+        inline typename Isa::ivec p32_sqrt(typename Isa::ivec a)
+        {
+            using I = Isa;
+            typename I::dvec x0, x1, zero{};
+            p32_decode<I>(a, x0, x1);
+            auto r0 = I::dsqrt(x0), r1 = I::dsqrt(x1);
+            return p32_encode<I>(r0, r1, I::dsub(zero, I::dmul_err(r0, r0, x0)), I::dsub(zero, I::dmul_err(r1, r1, x1)));
+        }
+
+#if defined(__AVX2__) && defined(__FMA__)
+        // Four-lane p32_round on 64-bit lanes; lanes outside the fast range
+        // (or NaN) take the scalar path, which is rare in practice.
+        inline __m256d p32_round(__m256d x, __m256d err)
+        {
+            const __m256i one = _mm256_set1_epi64x(1);
+            __m256i bits = _mm256_castpd_si256(x);
+            __m256i biased = _mm256_and_si256(_mm256_srli_epi64(bits, 52), _mm256_set1_epi64x(0x7FF));
+            __m256i k = _mm256_sub_epi64(_mm256_srli_epi64(_mm256_add_epi64(biased, one), 2), _mm256_set1_epi64x(256));
+            __m256i kneg = _mm256_cmpgt_epi64(_mm256_setzero_si256(), k);
+            __m256i drop = _mm256_blendv_epi8(_mm256_add_epi64(k, _mm256_set1_epi64x(25)),
+                                              _mm256_sub_epi64(_mm256_set1_epi64x(24), k), kneg);
+            __m256i unit = _mm256_sllv_epi64(one, drop);
+            __m256i low = _mm256_and_si256(bits, _mm256_sub_epi64(unit, one));
+            __m256i half = _mm256_srli_epi64(unit, 1);
+            __m256i trunc = _mm256_sub_epi64(bits, low);
+
+            __m256i err_nonzero = _mm256_castpd_si256(_mm256_cmp_pd(err, _mm256_setzero_pd(), _CMP_NEQ_OQ));
+            __m256i err_opposite = _mm256_cmpgt_epi64(_mm256_setzero_si256(),
+                                                      _mm256_xor_si256(_mm256_castpd_si256(err), bits));
+            __m256i odd = _mm256_cmpeq_epi64(_mm256_and_si256(trunc, unit), unit);
+            __m256i tie_up = _mm256_or_si256(_mm256_andnot_si256(err_opposite, err_nonzero),
+                                             _mm256_andnot_si256(err_nonzero, odd));
+            __m256i up = _mm256_or_si256(_mm256_cmpgt_epi64(low, half),
+                                         _mm256_and_si256(_mm256_cmpeq_epi64(low, half), tie_up));
+            __m256d rounded = _mm256_castsi256_pd(_mm256_add_epi64(trunc, _mm256_and_si256(up, unit)));
+
+            __m256i fast = _mm256_and_si256(_mm256_cmpgt_epi64(k, _mm256_set1_epi64x(-28)),
+                                            _mm256_cmpgt_epi64(_mm256_set1_epi64x(27), k));
+            fast = _mm256_or_si256(fast, _mm256_castpd_si256(_mm256_cmp_pd(x, _mm256_setzero_pd(), _CMP_EQ_OQ)));
+            if (_mm256_movemask_pd(_mm256_castsi256_pd(fast)) != 0xF) {
+                alignas(32) double xs[4], es[4], rs[4];
+                _mm256_store_pd(xs, x);
+                _mm256_store_pd(es, err);
+                _mm256_store_pd(rs, rounded);
+                for (int i{}; i < 4; ++i) rs[i] = eigen_posit::p32_round(xs[i], es[i]);
+                rounded = _mm256_load_pd(rs);
+            }
+            return rounded;
+        }
+
+        // p32_gemm_micro with the accumulator tile held in registers
+        inline void p32_gemm_micro(const double* a, const double* b, double* acc, int ld, int kc)
+        {
+            __m256d c[2][p32_gemm_nr];
+            for (int j{}; j < p32_gemm_nr; ++j) {
+                c[0][j] = _mm256_loadu_pd(acc + j * ld);
+                c[1][j] = _mm256_loadu_pd(acc + j * ld + 4);
+            }
+            for (int k{}; k < kc; ++k) {
+                __m256d a0 = _mm256_loadu_pd(a + k * p32_gemm_mr);
+                __m256d a1 = _mm256_loadu_pd(a + k * p32_gemm_mr + 4);
+                for (int j{}; j < p32_gemm_nr; ++j) {
+                    __m256d bj = _mm256_broadcast_sd(b + k * p32_gemm_nr + j);
+                    for (int h{}; h < 2; ++h) {
+                        __m256d ah = h ? a1 : a0;
+                        __m256d p = _mm256_mul_pd(ah, bj);
+                        p = p32_round(p, _mm256_fmsub_pd(ah, bj, p));
+                        __m256d s = _mm256_add_pd(c[h][j], p);
+                        c[h][j] = p32_round(s, two_sum_err<avx2>(c[h][j], p, s));
+                    }
+                }
+            }
+            for (int j{}; j < p32_gemm_nr; ++j) {
+                _mm256_storeu_pd(acc + j * ld, c[0][j]);
+                _mm256_storeu_pd(acc + j * ld + 4, c[1][j]);
+            }
+        }
+
+        inline void p32_decoded_update(double* y, const double* x, double u, std::size_t n)
+        {
+            const __m256d uv = _mm256_set1_pd(u);
+            std::size_t i{};
+            for (; i + 4 <= n; i += 4) {
+                __m256d xv = _mm256_loadu_pd(x + i), yv = _mm256_loadu_pd(y + i);
+                __m256d p = _mm256_mul_pd(xv, uv);
+                p = p32_round(p, _mm256_fmsub_pd(xv, uv, p));
+                __m256d s = _mm256_sub_pd(yv, p);
+                __m256d np = _mm256_sub_pd(_mm256_setzero_pd(), p);
+                _mm256_storeu_pd(y + i, p32_round(s, two_sum_err<avx2>(yv, np, s)));
+            }
+            eigen_posit::p32_decoded_update(y + i, x + i, u, n - i);
+        }
+#endif
+    }
+}
+}
@@ -0,0 +1,437 @@
+#pragma once
+
+#include "dispatch.h"
+#include "lut_gemm.h"
+#include "parallel.h"
+#include <Eigen/LU>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// LU factorizations of posit32 and posit16 matrices.
+//
+// Eigen's PartialPivLU and FullPivLU run on posit matrices as they are, but
+// the pivot columns, rank-one updates and triangular solves go through
+// Eigen's generic paths: every coefficient off a packet boundary is a
+// SoftPosit call and every packet operation decodes its operands again. Here
+// the columns being eliminated are held decoded in double, as gemm.h does
+// for products. Every posit32 and posit16 value is exactly a double, and each
+// division, product and difference is rounded back onto the posit grid with
+// the sign of its exact error, so every step rounds as the posit operation
+// would. Pivots are compared as integers on the raw bits: the decoded value's
+// bits with the sign cleared, NaR below zero as in the posit order.
+//
+// PartialPivLU is blocked and right-looking. A panel of lu_block columns is
+// factored decoded, its row swaps are applied to the rest of the matrix, the
+// block row is solved against the panel's unit lower triangle, and the
+// trailing matrix takes a single product update, A22 -= A21 * A12, through
+// the posit GEMM (gemm.h, lut_gemm.h) and its threads. With the quire that
+// update rounds once per element per panel rather than once per operation,
+// so the factors are at least as accurate as, but not bit-identical to,
+// Eigen's generic ones. FullPivLU needs the whole trailing matrix before
+// every pivot and cannot be blocked; it keeps the matrix decoded throughout
+// and gives exactly the factors of Eigen's generic algorithm. Triangular
+// solves on the left with a posit triangle, which is what solve() runs for
+// these and the Cholesky decompositions, substitute decoded in the same way,
+// one right-hand side per thread.
+namespace eigen_posit
+{
+namespace detail
+{
+    // Columns per PartialPivLU panel. Wider panels move work from the quire
+    // product into the decoded panel; past 128 the two break even.
+    constexpr Eigen::Index lu_block = 128;
+
+    // A posit format's values as the doubles they are.
+    template<typename Scalar>
+    struct lu_format;
+
+    template<>
+    struct lu_format<posit32>
+    {
+        static double decode(const posit32& x) { return p32_to_double(x.value); }
+        static posit32 encode(double x, double err = 0.0) { return p32_from_bits(p32_from_double(x, err)); }
+        static double round(double x, double err) { return p32_round(x, err); }
+    };
+
+    template<>
+    struct lu_format<posit16>
+    {
+        static double decode(const posit16& x) { return p16_to_float(x.value); }
+
+        static posit16 encode(double x, double err = 0.0)
+        {
+            posit16 r;
+            small_store(r, x, err);
+            return r;
+        }
+
+        static double round(double x, double err)
+        {
+            posit16 r;
+            small_store(r, x, err);
+            return decode(r);
+        }
+    };
+
+    // Pivot order: magnitude as an integer, NaR (decoded NaN) below zero.
+    inline int64_t lu_magnitude(double x)
+    {
+        int64_t bits = int64_t(std::bit_cast<uint64_t>(x) & 0x7FFFFFFFFFFFFFFFu);
+        return bits > 0x7FF0000000000000 ? -1 : bits;
+    }
+
+    // x[0, n) /= d, each quotient rounded
+    template<typename Scalar>
+    void lu_scale(double* x, double d, Eigen::Index n)
+    {
+        for (Eigen::Index i{}; i < n; ++i) {
+            double q = x[i] / d;
+            double r = std::fma(-q, d, x[i]);
+            x[i] = lu_format<Scalar>::round(q, d < 0.0 ? -r : r);
+        }
+    }
+
+    // y[0, n) -= x[0, n) * u, product and difference each rounded
+    template<typename Scalar>
+    void lu_update(double* y, const double* x, double u, Eigen::Index n)
+    {
+        Eigen::Index i{};
+        // posit32 columns go through the dispatched kernels; single
+        // coefficients stay inline
+        if constexpr (std::is_same_v<Scalar, posit32>) {
+            if (n >= 4) {
+                active_kernels().update(y, x, u, std::size_t(n));
+                return;
+            }
+        }
+#if defined(__AVX2__) && defined(__FMA__)
+        if constexpr (std::is_same_v<Scalar, posit16>) {
+            // posit16 values are floats, and so are the errors of their
+            // float products and sums: eight lanes in float
+            const __m256 uv = _mm256_set1_ps(float(u));
+            for (; i + 8 <= n; i += 8) {
+                __m256 xv = _mm256_setr_m128(_mm256_cvtpd_ps(_mm256_loadu_pd(x + i)), _mm256_cvtpd_ps(_mm256_loadu_pd(x + i + 4)));
+                __m256 yv = _mm256_setr_m128(_mm256_cvtpd_ps(_mm256_loadu_pd(y + i)), _mm256_cvtpd_ps(_mm256_loadu_pd(y + i + 4)));
+                __m256 p = _mm256_mul_ps(xv, uv);
+                p = simd::p16_decode(simd::p16_encode(p, _mm256_fmsub_ps(xv, uv, p)));
+                __m256 s = _mm256_sub_ps(yv, p);
+                __m256 t = _mm256_sub_ps(s, yv);
+                __m256 err = _mm256_sub_ps(_mm256_sub_ps(yv, _mm256_sub_ps(s, t)), _mm256_add_ps(p, t));
+                s = simd::p16_decode(simd::p16_encode(s, err));
+                _mm256_storeu_pd(y + i, _mm256_cvtps_pd(_mm256_castps256_ps128(s)));
+                _mm256_storeu_pd(y + i + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(s, 1)));
+            }
+        }
+#endif
+        for (; i < n; ++i) {
+            double p = x[i] * u;
+            p = lu_format<Scalar>::round(p, std::fma(x[i], u, -p));
+            double s = y[i] - p;
+            y[i] = lu_format<Scalar>::round(s, two_sum_err(y[i], -p, s));
+        }
+    }
+
+    // Unblocked partial-pivoting LU of the decoded m x n column-major panel
+    // a, m >= n. piv[c] is the row swapped with row c, both in the panel.
+    // Returns the first column with a zero pivot, or -1.
+    template<typename Scalar, typename PivIndex>
+    Eigen::Index lu_panel(double* a, Eigen::Index m, Eigen::Index n, PivIndex* piv, PivIndex& swaps)
+    {
+        Eigen::Index first_zero = -1;
+        for (Eigen::Index c{}; c < n; ++c) {
+            double* col = a + c * m;
+            Eigen::Index p = c;
+            int64_t best = lu_magnitude(col[c]);
+            for (Eigen::Index i = c + 1; i < m; ++i) {
+                int64_t key = lu_magnitude(col[i]);
+                if (key > best) best = key, p = i;
+            }
+            piv[c] = PivIndex(p);
+            if (best != 0) {
+                if (p != c) {
+                    for (Eigen::Index j{}; j < n; ++j) std::swap(a[j * m + c], a[j * m + p]);
+                    ++swaps;
+                }
+                lu_scale<Scalar>(col + c + 1, col[c], m - c - 1);
+            }
+            else if (first_zero < 0) first_zero = c;
+            for (Eigen::Index j = c + 1; j < n; ++j) lu_update<Scalar>(a + j * m + c + 1, col + c + 1, a[j * m + c], m - c - 1);
+        }
+        return first_zero;
+    }
+
+    // Eigen's partial_lu_impl::blocked_lu contract: factors the rows x cols
+    // column-major matrix at data in place, rows >= cols, with absolute row
+    // transpositions; returns the first zero pivot, or -1.
+    template<typename Scalar, typename PivIndex>
+    Eigen::Index partial_lu(Eigen::Index rows, Eigen::Index cols, Scalar* data, Eigen::Index stride,
+                            PivIndex* transpositions, PivIndex& nb_transpositions, Eigen::Index max_block)
+    {
+        using Eigen::Index;
+        typedef lu_format<Scalar> F;
+        typedef Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic> Matrix;
+        Eigen::Map<Matrix, 0, Eigen::OuterStride<>> lu(data, rows, cols, Eigen::OuterStride<>(stride));
+
+        const Index size = std::min(rows, cols);
+        const Index block = std::max<Index>(1, std::min(max_block, lu_block));
+        std::vector<double> panel;
+        nb_transpositions = 0;
+        Index first_zero = -1;
+        for (Index k{}; k < size; k += block) {
+            Index bs = std::min(block, size - k);
+            Index m = rows - k;
+            Index trailing = cols - k - bs;
+
+            panel.resize(std::size_t(m * bs));
+            for (Index j{}; j < bs; ++j)
+                for (Index i{}; i < m; ++i) panel[j * m + i] = F::decode(lu(k + i, k + j));
+            PivIndex swaps{};
+            Index zero = lu_panel<Scalar>(panel.data(), m, bs, transpositions + k, swaps);
+            if (zero >= 0 && first_zero < 0) first_zero = k + zero;
+            nb_transpositions += swaps;
+            for (Index j{}; j < bs; ++j)
+                for (Index i{}; i < m; ++i) lu(k + i, k + j) = F::encode(panel[j * m + i]);
+
+            // the panel's swaps, on the columns either side of it
+            for (Index i = k; i < k + bs; ++i) {
+                Index p = (transpositions[i] += PivIndex(k));
+                if (p == i) continue;
+                lu.row(i).head(k).swap(lu.row(p).head(k));
+                lu.row(i).tail(trailing).swap(lu.row(p).tail(trailing));
+            }
+            if (trailing == 0) continue;
+
+            // A12 = L11^-1 A12, a column at a time
+            parallel_slices(trailing, Index(8), 4.0 * double(bs) * double(bs), [&](Index begin, Index end) {
+                std::vector<double> x(bs);
+                for (Index j = k + bs + begin; j < k + bs + end; ++j) {
+                    for (Index i{}; i < bs; ++i) x[i] = F::decode(lu(k + i, j));
+                    for (Index c{}; c + 1 < bs; ++c) lu_update<Scalar>(x.data() + c + 1, panel.data() + c * m + c + 1, x[c], bs - c - 1);
+                    for (Index i{}; i < bs; ++i) lu(k + i, j) = F::encode(x[i]);
+                }
+            });
+
+            if (m > bs) lu.bottomRightCorner(m - bs, trailing).noalias() -= lu.block(k + bs, k, m - bs, bs) * lu.block(k, k + bs, bs, trailing);
+        }
+        return first_zero;
+    }
+
+    // Solves tri x = b in place for cols right-hand sides at rhs. A column-major
+    // triangle substitutes column by column, decoded a column at a time; a
+    // row-major one (a transposed triangle, as in the second half of a
+    // Cholesky solve) row by row, each row's products subtracted in turn.
+    template<typename Scalar, int Mode, int TriStorageOrder>
+    void triangular_solve(Eigen::Index size, const Scalar* tri, Eigen::Index tri_stride, Scalar* rhs, Eigen::Index rhs_stride,
+                          Eigen::Index cols)
+    {
+        using Eigen::Index;
+        typedef lu_format<Scalar> F;
+        constexpr bool lower = (Mode & Eigen::Lower) == Eigen::Lower;
+        constexpr bool unit = (Mode & Eigen::UnitDiag) != 0;
+        parallel_slices(cols, Index(1), 2.0 * double(size) * double(size), [&](Index begin, Index end) {
+            std::vector<double> x(size), column(size);
+            for (Index j = begin; j < end; ++j) {
+                Scalar* b = rhs + j * rhs_stride;
+                for (Index i{}; i < size; ++i) x[i] = F::decode(b[i]);
+                for (Index n{}; n < size; ++n) {
+                    Index c = lower ? n : size - 1 - n;
+                    const Scalar* t = tri + c * tri_stride;
+                    // Eigen leaves zeros undivided, so 0 / 0 stays 0
+                    if constexpr (TriStorageOrder == Eigen::RowMajor) {
+                        Index first = lower ? 0 : c + 1, last = lower ? c : size;
+                        for (Index i = first; i < last; ++i) {
+                            double coefficient = F::decode(t[i]);
+                            lu_update<Scalar>(&x[c], &coefficient, x[i], 1);
+                        }
+                        if (!unit && x[c] != 0.0) lu_scale<Scalar>(&x[c], F::decode(t[c]), 1);
+                    }
+                    else {
+                        if (!unit && x[c] != 0.0) lu_scale<Scalar>(&x[c], F::decode(t[c]), 1);
+                        Index first = lower ? c + 1 : 0, last = lower ? size : c;
+                        for (Index i = first; i < last; ++i) column[i] = F::decode(t[i]);
+                        lu_update<Scalar>(x.data() + first, column.data() + first, x[c], last - first);
+                    }
+                }
+                for (Index i{}; i < size; ++i) b[i] = F::encode(x[i]);
+            }
+        });
+    }
+
+    // FullPivLU::computeInPlace on the decoded matrix, step for step.
+    template<typename Scalar, typename RowTranspositions, typename ColTranspositions, typename PermutationP, typename PermutationQ>
+    void full_pivot_lu(Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>& lu, RowTranspositions& row_transpositions,
+                       ColTranspositions& col_transpositions, PermutationP& p, PermutationQ& q, Scalar& l1_norm,
+                       Scalar& max_pivot, Eigen::Index& nonzero_pivots, signed char& det_pq)
+    {
+        using Eigen::Index;
+        typedef lu_format<Scalar> F;
+        typedef typename RowTranspositions::Scalar StorageIndex;
+
+        l1_norm = lu.cwiseAbs().colwise().sum().maxCoeff();
+
+        const Index rows = lu.rows(), cols = lu.cols(), size = std::min(rows, cols);
+        row_transpositions.resize(rows);
+        col_transpositions.resize(cols);
+        std::vector<double> a(std::size_t(rows * cols));
+        for (Index i{}; i < rows * cols; ++i) a[i] = F::decode(lu.data()[i]);
+
+        Index swaps{};
+        double biggest_pivot{};
+        nonzero_pivots = size;
+        for (Index k{}; k < size; ++k) {
+            // Eigen's maxCoeff order: down each column, first of equals wins
+            Index pr = k, pc = k;
+            int64_t best = lu_magnitude(a[k * rows + k]);
+            for (Index j = k; j < cols; ++j) {
+                for (Index i = k; i < rows; ++i) {
+                    int64_t key = lu_magnitude(a[j * rows + i]);
+                    if (key > best) best = key, pr = i, pc = j;
+                }
+            }
+            if (best == 0) {
+                nonzero_pivots = k;
+                for (Index i = k; i < size; ++i) {
+                    row_transpositions.coeffRef(i) = StorageIndex(i);
+                    col_transpositions.coeffRef(i) = StorageIndex(i);
+                }
+                break;
+            }
+
+            double pivot = std::fabs(a[pc * rows + pr]);
+            if (pivot > biggest_pivot) biggest_pivot = pivot;
+            row_transpositions.coeffRef(k) = StorageIndex(pr);
+            col_transpositions.coeffRef(k) = StorageIndex(pc);
+            if (pr != k) {
+                for (Index j{}; j < cols; ++j) std::swap(a[j * rows + k], a[j * rows + pr]);
+                ++swaps;
+            }
+            if (pc != k) {
+                std::swap_ranges(a.begin() + k * rows, a.begin() + (k + 1) * rows, a.begin() + pc * rows);
+                ++swaps;
+            }
+
+            double* col = a.data() + k * rows;
+            if (k < rows - 1) lu_scale<Scalar>(col + k + 1, col[k], rows - k - 1);
+            if (k < size - 1) {
+                parallel_slices(cols - k - 1, Index(8), 4.0 * double(rows - k - 1), [&](Index begin, Index end) {
+                    for (Index j = k + 1 + begin; j < k + 1 + end; ++j)
+                        lu_update<Scalar>(a.data() + j * rows + k + 1, col + k + 1, a[j * rows + k], rows - k - 1);
+                });
+            }
+        }
+
+        for (Index i{}; i < rows * cols; ++i) lu.data()[i] = F::encode(a[i]);
+        max_pivot = F::encode(biggest_pivot);
+
+        p.setIdentity(rows);
+        for (Index k = size - 1; k >= 0; --k) p.applyTranspositionOnTheRight(k, row_transpositions.coeff(k));
+        q.setIdentity(cols);
+        for (Index k{}; k < size; ++k) q.applyTranspositionOnTheRight(k, col_transpositions.coeff(k));
+        det_pq = (swaps % 2) ? -1 : 1;
+    }
+}
+}
+
+namespace Eigen
+{
+namespace internal
+{
+    // Dynamic-size column-major posit matrices; fixed sizes keep Eigen's path.
+    template<typename PivIndex>
+    struct partial_lu_impl<posit32, ColMajor, PivIndex, Dynamic>
+    {
+        static Index blocked_lu(Index rows, Index cols, posit32* lu_data, Index luStride, PivIndex* row_transpositions,
+                                PivIndex& nb_transpositions, Index maxBlockSize = 256)
+        {
+            return eigen_posit::detail::partial_lu(rows, cols, lu_data, luStride, row_transpositions, nb_transpositions, maxBlockSize);
+        }
+    };
+
+    template<typename PivIndex>
+    struct partial_lu_impl<posit16, ColMajor, PivIndex, Dynamic>
+    {
+        static Index blocked_lu(Index rows, Index cols, posit16* lu_data, Index luStride, PivIndex* row_transpositions,
+                                PivIndex& nb_transpositions, Index maxBlockSize = 256)
+        {
+            return eigen_posit::detail::partial_lu(rows, cols, lu_data, luStride, row_transpositions, nb_transpositions, maxBlockSize);
+        }
+    };
+
+    // Triangles solved on the left, as the decompositions' solve() does.
+    template<typename Index, int Mode, bool Conjugate>
+    struct triangular_solve_vector<posit32, posit32, Index, OnTheLeft, Mode, Conjugate, ColMajor>
+    {
+        static void run(Index size, const posit32* lhs, Index lhsStride, posit32* rhs)
+        {
+            eigen_posit::detail::triangular_solve<posit32, Mode, ColMajor>(size, lhs, lhsStride, rhs, size, 1);
+        }
+    };
+
+    template<typename Index, int Mode, bool Conjugate>
+    struct triangular_solve_vector<posit32, posit32, Index, OnTheLeft, Mode, Conjugate, RowMajor>
+    {
+        static void run(Index size, const posit32* lhs, Index lhsStride, posit32* rhs)
+        {
+            eigen_posit::detail::triangular_solve<posit32, Mode, RowMajor>(size, lhs, lhsStride, rhs, size, 1);
+        }
+    };
+
+    template<typename Index, int Mode, bool Conjugate>
+    struct triangular_solve_vector<posit16, posit16, Index, OnTheLeft, Mode, Conjugate, ColMajor>
+    {
+        static void run(Index size, const posit16* lhs, Index lhsStride, posit16* rhs)
+        {
+            eigen_posit::detail::triangular_solve<posit16, Mode, ColMajor>(size, lhs, lhsStride, rhs, size, 1);
+        }
+    };
+
+    template<typename Index, int Mode, bool Conjugate>
+    struct triangular_solve_vector<posit16, posit16, Index, OnTheLeft, Mode, Conjugate, RowMajor>
+    {
+        static void run(Index size, const posit16* lhs, Index lhsStride, posit16* rhs)
+        {
+            eigen_posit::detail::triangular_solve<posit16, Mode, RowMajor>(size, lhs, lhsStride, rhs, size, 1);
+        }
+    };
+
+    template<typename Index, int Mode, bool Conjugate, int TriStorageOrder>
+    struct triangular_solve_matrix<posit32, Index, OnTheLeft, Mode, Conjugate, TriStorageOrder, ColMajor, 1>
+    {
+        static void run(Index size, Index cols, const posit32* tri, Index triStride, posit32* other, Index /*otherIncr*/,
+                        Index otherStride, level3_blocking<posit32, posit32>& /*blocking*/)
+        {
+            eigen_posit::detail::triangular_solve<posit32, Mode, TriStorageOrder>(size, tri, triStride, other, otherStride, cols);
+        }
+    };
+
+    template<typename Index, int Mode, bool Conjugate, int TriStorageOrder>
+    struct triangular_solve_matrix<posit16, Index, OnTheLeft, Mode, Conjugate, TriStorageOrder, ColMajor, 1>
+    {
+        static void run(Index size, Index cols, const posit16* tri, Index triStride, posit16* other, Index /*otherIncr*/,
+                        Index otherStride, level3_blocking<posit16, posit16>& /*blocking*/)
+        {
+            eigen_posit::detail::triangular_solve<posit16, Mode, TriStorageOrder>(size, tri, triStride, other, otherStride, cols);
+        }
+    };
+}
+
+    template<>
+    inline void FullPivLU<Matrix<posit32, Dynamic, Dynamic>>::computeInPlace()
+    {
+        eigen_posit::detail::full_pivot_lu(m_lu, m_rowsTranspositions, m_colsTranspositions, m_p, m_q, m_l1_norm, m_maxpivot,
+                                           m_nonzero_pivots, m_det_pq);
+        m_isInitialized = true;
+    }
+
+    template<>
+    inline void FullPivLU<Matrix<posit16, Dynamic, Dynamic>>::computeInPlace()
+    {
+        eigen_posit::detail::full_pivot_lu(m_lu, m_rowsTranspositions, m_colsTranspositions, m_p, m_q, m_l1_norm, m_maxpivot,
+                                           m_nonzero_pivots, m_det_pq);
+        m_isInitialized = true;
+    }
+}
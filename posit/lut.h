@@ -0,0 +1,310 @@
+#pragma once
+
+#include "kernels.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+// Table-driven posit8 (es = 0) and posit16 (es = 1) arithmetic.
+//
+// Both formats fit in float with room to spare: every value, and every
+// rounding point between two neighbouring values, is exactly a float. So, as
+// kernels.h does for posit32 with double, an operation decodes its operands
+// through a table, computes in float together with the sign of the exact
+// error, and rounds with that sign breaking ties. Rounding is table-driven
+// too: the regime and exponent bits of a posit depend only on the binade of
+// the value, so a 256-entry table indexed by the float exponent gives them
+// along with the number of bits to round off. posit8 goes one step further
+// and tabulates add, mul and div outright, 64K entries each. Results are
+// bit-exact with SoftPosit.
+//
+// Like kernels.h, everything here lives in the inline namespace
+// EIGEN_POSIT_TARGET, so the dispatch_*.cpp translation units, which build
+// the posit16 and posit8 array kernels for their own instruction sets, keep
+// copies (tables included) that cannot be merged with the baseline ones.
+namespace eigen_posit
+{
+inline namespace EIGEN_POSIT_TARGET
+{
+    template<int N, int ES>
+    struct small_posit_tables
+    {
+        static constexpr uint32_t nar = 1u << (N - 1);
+        static constexpr uint32_t maxpos = nar - 1;
+        static constexpr uint32_t mask = (1u << N) - 1;
+        // width of the fraction field kept for rounding: the top 14 float
+        // fraction bits and a sticky bit for the other 9
+        static constexpr int frac_bits = 15;
+
+        float decode[1 << N];
+        // by float biased exponent: regime and exponent bits above the
+        // fraction field, and how many low bits rounding drops
+        uint32_t head[256];
+        uint32_t shift[256];
+
+        small_posit_tables()
+        {
+            for (uint32_t bits{}; bits <= mask; ++bits) decode[bits] = decode_slow(bits);
+            for (int e{}; e < 256; ++e) {
+                int scale = e - 127;
+                int k = scale >= 0 ? scale >> ES : -((-scale + (1 << ES) - 1) >> ES);
+                if (e == 0 || k < -(N - 2)) {
+                    // below minpos, rounds up to minpos
+                    head[e] = 0;
+                    shift[e] = 31;
+                }
+                else if (k > N - 3) {
+                    // maxpos and beyond, clamped after rounding
+                    head[e] = maxpos << frac_bits;
+                    shift[e] = frac_bits;
+                }
+                else {
+                    int regime_bits = k >= 0 ? k + 2 : 1 - k;
+                    uint32_t regime = k >= 0 ? ((1u << (k + 1)) - 1) << 1 : 1u;
+                    head[e] = ((regime << ES) | uint32_t(scale - k * (1 << ES))) << frac_bits;
+                    shift[e] = uint32_t(regime_bits + ES + frac_bits - (N - 1));
+                }
+            }
+        }
+
+        static float decode_slow(uint32_t bits)
+        {
+            if (bits == 0) return 0.0f;
+            if (bits == nar) return std::numeric_limits<float>::quiet_NaN();
+
+            bool negative = bits >> (N - 1);
+            uint32_t body = negative ? (0u - bits) & mask : bits;
+            int i = N - 2;
+            uint32_t first = (body >> i) & 1;
+            int run{};
+            while (i >= 0 && ((body >> i) & 1) == first) {
+                ++run;
+                --i;
+            }
+            --i;
+            int k = first ? run - 1 : -run;
+            int e{};
+            for (int j{}; j < ES; ++j) {
+                e <<= 1;
+                if (i >= 0) e |= (body >> i--) & 1;
+            }
+            float frac = 1.0f, weight = 0.5f;
+            for (; i >= 0; --i, weight *= 0.5f)
+                if ((body >> i) & 1) frac += weight;
+            float magnitude = std::ldexp(frac, k * (1 << ES) + e);
+            return negative ? -magnitude : magnitude;
+        }
+
+        // Rounds x to the posit grid; the exact value is x + err.
+        uint32_t round(float x, float err) const
+        {
+            uint32_t b = std::bit_cast<uint32_t>(x);
+            uint32_t e = (b >> 23) & 0xFF;
+            if (e == 0xFF) return nar;
+            if ((b << 1) == 0) return 0;
+
+            uint32_t m = b & 0x7FFFFF;
+            uint32_t str = head[e] | (m >> 9 << 1) | uint32_t((m & 0x1FF) != 0);
+            uint32_t s = shift[e];
+            uint32_t keep = str >> s;
+            uint32_t rem = str & ((1u << s) - 1);
+            uint32_t half = 1u << (s - 1);
+            bool negative = b >> 31;
+            bool above = negative ? err < 0 : err > 0;
+            bool below = negative ? err > 0 : err < 0;
+            if (rem > half || (rem == half && (above || (!below && (keep & 1))))) ++keep;
+            keep = std::min(std::max(keep, 1u), maxpos);
+            return negative ? (0u - keep) & mask : keep;
+        }
+
+        uint32_t add(uint32_t a, uint32_t b) const
+        {
+            float x = decode[a], y = decode[b];
+            float s = x + y;
+            float t = s - x;
+            return round(s, (x - (s - t)) + (y - t));
+        }
+
+        uint32_t sub(uint32_t a, uint32_t b) const { return add(a, (0u - b) & mask); }
+
+        uint32_t mul(uint32_t a, uint32_t b) const
+        {
+            // float significands are 24 bits, so the product is exact in double
+            double p = double(decode[a]) * decode[b];
+            float x = float(p);
+            return round(x, float(p - x));
+        }
+
+        uint32_t div(uint32_t a, uint32_t b) const
+        {
+            float x = decode[a], y = decode[b];
+            float q = x / y;
+            double rem = double(x) - double(q) * y;
+            return round(q, y < 0 ? float(-rem) : float(rem));
+        }
+    };
+
+    inline const small_posit_tables<16, 1>& p16_tables()
+    {
+        static const small_posit_tables<16, 1> tables;
+        return tables;
+    }
+
+    inline const small_posit_tables<8, 0>& p8_tables()
+    {
+        static const small_posit_tables<8, 0> tables;
+        return tables;
+    }
+
+    inline float p16_to_float(uint16_t bits) { return p16_tables().decode[bits]; }
+    inline uint16_t p16_from_float(float x, float err = 0) { return uint16_t(p16_tables().round(x, err)); }
+    inline uint16_t p16_add(uint16_t a, uint16_t b) { return uint16_t(p16_tables().add(a, b)); }
+    inline uint16_t p16_sub(uint16_t a, uint16_t b) { return uint16_t(p16_tables().sub(a, b)); }
+    inline uint16_t p16_mul(uint16_t a, uint16_t b) { return uint16_t(p16_tables().mul(a, b)); }
+    inline uint16_t p16_div(uint16_t a, uint16_t b) { return uint16_t(p16_tables().div(a, b)); }
+
+    // Complete posit8 operation tables, indexed by a << 8 | b. The padding
+    // lets a 32-bit gather read the last byte of the last table.
+    struct p8_op_tables
+    {
+        uint8_t add[1 << 16];
+        uint8_t mul[1 << 16];
+        uint8_t div[1 << 16];
+        uint8_t padding[4]{};
+
+        p8_op_tables()
+        {
+            const auto& t = p8_tables();
+            for (uint32_t a{}; a < 256; ++a) {
+                for (uint32_t b{}; b < 256; ++b) {
+                    add[a << 8 | b] = uint8_t(t.add(a, b));
+                    mul[a << 8 | b] = uint8_t(t.mul(a, b));
+                    div[a << 8 | b] = uint8_t(t.div(a, b));
+                }
+            }
+        }
+    };
+
+    inline const p8_op_tables& p8_ops()
+    {
+        static const p8_op_tables tables;
+        return tables;
+    }
+
+    inline float p8_to_float(uint8_t bits) { return p8_tables().decode[bits]; }
+    inline uint8_t p8_from_float(float x, float err = 0) { return uint8_t(p8_tables().round(x, err)); }
+    inline uint8_t p8_add(uint8_t a, uint8_t b) { return p8_ops().add[a << 8 | b]; }
+    inline uint8_t p8_sub(uint8_t a, uint8_t b) { return p8_ops().add[a << 8 | uint8_t(0u - b)]; }
+    inline uint8_t p8_mul(uint8_t a, uint8_t b) { return p8_ops().mul[a << 8 | b]; }
+    inline uint8_t p8_div(uint8_t a, uint8_t b) { return p8_ops().div[a << 8 | b]; }
+
+#if defined(__AVX2__) && defined(__FMA__)
+namespace simd
+{
+    // Eight lanes of small_posit_tables::round(), results in 32-bit lanes.
+    template<int N, int ES>
+    inline __m256i small_round(__m256 x, __m256 err)
+    {
+        using tables = small_posit_tables<N, ES>;
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i one = _mm256_set1_epi32(1);
+        __m256i b = _mm256_castps_si256(x);
+        __m256i e = _mm256_and_si256(_mm256_srli_epi32(b, 23), _mm256_set1_epi32(0xFF));
+        __m256i m = _mm256_and_si256(b, _mm256_set1_epi32(0x7FFFFF));
+        __m256i sticky = _mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_and_si256(m, _mm256_set1_epi32(0x1FF)), zero), one);
+        // head and shift as in the tables, computed in registers: cheaper than two gathers
+        __m256i scale = _mm256_sub_epi32(e, _mm256_set1_epi32(127));
+        __m256i k = _mm256_srai_epi32(scale, ES);
+        __m256i negative_k = _mm256_srai_epi32(k, 31);
+        __m256i regime_bits = _mm256_blendv_epi8(_mm256_add_epi32(k, _mm256_set1_epi32(2)), _mm256_sub_epi32(one, k), negative_k);
+        __m256i regime = _mm256_slli_epi32(_mm256_sub_epi32(_mm256_sllv_epi32(one, _mm256_add_epi32(k, one)), one), 1);
+        regime = _mm256_blendv_epi8(regime, one, negative_k);
+        __m256i exponent = _mm256_and_si256(scale, _mm256_set1_epi32((1 << ES) - 1));
+        __m256i head = _mm256_slli_epi32(_mm256_or_si256(_mm256_slli_epi32(regime, ES), exponent), tables::frac_bits);
+        __m256i s = _mm256_add_epi32(regime_bits, _mm256_set1_epi32(ES + tables::frac_bits - (N - 1)));
+        __m256i tiny = _mm256_or_si256(_mm256_cmpeq_epi32(e, zero), _mm256_cmpgt_epi32(_mm256_set1_epi32(-(N - 2)), k));
+        __m256i huge = _mm256_cmpgt_epi32(k, _mm256_set1_epi32(N - 3));
+        head = _mm256_andnot_si256(tiny, _mm256_blendv_epi8(head, _mm256_set1_epi32(int(tables::maxpos << tables::frac_bits)), huge));
+        s = _mm256_blendv_epi8(_mm256_blendv_epi8(s, _mm256_set1_epi32(tables::frac_bits), huge), _mm256_set1_epi32(31), tiny);
+        __m256i str = _mm256_or_si256(head, _mm256_or_si256(_mm256_slli_epi32(_mm256_srli_epi32(m, 9), 1), sticky));
+
+        __m256i keep = _mm256_srlv_epi32(str, s);
+        __m256i half = _mm256_sllv_epi32(one, _mm256_sub_epi32(s, one));
+        __m256i rem = _mm256_and_si256(str, _mm256_sub_epi32(_mm256_add_epi32(half, half), one));
+        __m256 toward = _mm256_xor_ps(err, _mm256_and_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(int(0x80000000u)))));
+        __m256i above = _mm256_castps_si256(_mm256_cmp_ps(toward, _mm256_setzero_ps(), _CMP_GT_OQ));
+        __m256i below = _mm256_castps_si256(_mm256_cmp_ps(toward, _mm256_setzero_ps(), _CMP_LT_OQ));
+        __m256i odd = _mm256_cmpeq_epi32(_mm256_and_si256(keep, one), one);
+        __m256i tie = _mm256_and_si256(_mm256_cmpeq_epi32(rem, half), _mm256_or_si256(above, _mm256_andnot_si256(below, odd)));
+        __m256i up = _mm256_or_si256(_mm256_cmpgt_epi32(rem, half), tie);
+        keep = _mm256_sub_epi32(keep, up);
+        keep = _mm256_min_epi32(_mm256_max_epi32(keep, one), _mm256_set1_epi32(int(tables::maxpos)));
+
+        __m256i negative = _mm256_srai_epi32(b, 31);
+        keep = _mm256_sub_epi32(_mm256_xor_si256(keep, negative), negative);
+        keep = _mm256_and_si256(keep, _mm256_set1_epi32(int(tables::mask)));
+        keep = _mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_slli_epi32(b, 1), zero), keep);
+        return _mm256_blendv_epi8(keep, _mm256_set1_epi32(int(tables::nar)), _mm256_cmpeq_epi32(e, _mm256_set1_epi32(0xFF)));
+    }
+
+    inline __m256 p16_decode(__m128i a) { return _mm256_i32gather_ps(p16_tables().decode, _mm256_cvtepu16_epi32(a), 4); }
+
+    inline __m128i p16_encode(__m256 x, __m256 err)
+    {
+        __m256i r = small_round<16, 1>(x, err);
+        return _mm_packus_epi32(_mm256_castsi256_si128(r), _mm256_extracti128_si256(r, 1));
+    }
+
+    inline __m128i p16_add(__m128i a, __m128i b)
+    {
+        __m256 x = p16_decode(a), y = p16_decode(b);
+        __m256 s = _mm256_add_ps(x, y);
+        __m256 t = _mm256_sub_ps(s, x);
+        return p16_encode(s, _mm256_add_ps(_mm256_sub_ps(x, _mm256_sub_ps(s, t)), _mm256_sub_ps(y, t)));
+    }
+
+    inline __m128i p16_sub(__m128i a, __m128i b) { return p16_add(a, _mm_sub_epi16(_mm_setzero_si128(), b)); }
+
+    inline __m128i p16_mul(__m128i a, __m128i b)
+    {
+        __m256 x = p16_decode(a), y = p16_decode(b);
+        __m256 p = _mm256_mul_ps(x, y);
+        return p16_encode(p, _mm256_fmsub_ps(x, y, p));
+    }
+
+    inline __m128i p16_div(__m128i a, __m128i b)
+    {
+        __m256 x = p16_decode(a), y = p16_decode(b);
+        __m256 q = _mm256_div_ps(x, y);
+        __m256 rem = _mm256_fnmadd_ps(q, y, x);
+        return p16_encode(q, _mm256_xor_ps(rem, _mm256_and_ps(y, _mm256_castsi256_ps(_mm256_set1_epi32(int(0x80000000u))))));
+    }
+
+    // Sixteen posit8 lookups in one of the p8_op_tables.
+    inline __m128i p8_lookup(const uint8_t* table, __m128i a, __m128i b)
+    {
+        const int* base = reinterpret_cast<const int*>(table);
+        const __m256i byte = _mm256_set1_epi32(0xFF);
+        __m256i lo = _mm256_or_si256(_mm256_slli_epi32(_mm256_cvtepu8_epi32(a), 8), _mm256_cvtepu8_epi32(b));
+        __m256i hi = _mm256_or_si256(_mm256_slli_epi32(_mm256_cvtepu8_epi32(_mm_srli_si128(a, 8)), 8),
+                                     _mm256_cvtepu8_epi32(_mm_srli_si128(b, 8)));
+        lo = _mm256_and_si256(_mm256_i32gather_epi32(base, lo, 1), byte);
+        hi = _mm256_and_si256(_mm256_i32gather_epi32(base, hi, 1), byte);
+        __m256i words = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8);
+        return _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+    }
+
+    inline __m128i p8_add(__m128i a, __m128i b) { return p8_lookup(p8_ops().add, a, b); }
+    inline __m128i p8_sub(__m128i a, __m128i b) { return p8_lookup(p8_ops().add, a, _mm_sub_epi8(_mm_setzero_si128(), b)); }
+    inline __m128i p8_mul(__m128i a, __m128i b) { return p8_lookup(p8_ops().mul, a, b); }
+    inline __m128i p8_div(__m128i a, __m128i b) { return p8_lookup(p8_ops().div, a, b); }
+}
+#endif
+}
+}
@@ -0,0 +1,353 @@
+#pragma once
+
+#include "gemm.h"
+#include "lut_packet_math.h"
+#include "parallel.h"
+#include <type_traits>
+
+// posit8 and posit16 matrix products.
+//
+// A posit16 matrix moves half the bytes of a posit32 one, so the small
+// formats are kept for storage and products compute in a wider type: the
+// operands widen to it while they are packed, and each result is rounded
+// back to the storage type once, when it is written. The compute type is
+// chosen with EIGEN_POSIT_SMALL_COMPUTE:
+//
+//   posit32 (default)     exact dot products in the posit32 quire (quire.h)
+//   float                 Eigen's float GEMM on widened panels; fastest
+//   native                Eigen's GEBP kernel on the table-driven packets,
+//                         rounding to the storage type after every operation
+//
+// Matrix-vector products take the same compute type, so a result does not
+// depend on how many columns the rhs has. Whatever the compute type, large
+// enough products are cut into slices of the result and run on the posit
+// thread pool (parallel.h) rather than waiting for Eigen's float-tuned
+// OpenMP threshold.
+#ifndef EIGEN_POSIT_SMALL_COMPUTE
+#define EIGEN_POSIT_SMALL_COMPUTE posit32
+#endif
+
+namespace eigen_posit
+{
+    // EIGEN_POSIT_SMALL_COMPUTE=native: no widening
+    struct native {};
+
+    typedef EIGEN_POSIT_SMALL_COMPUTE small_compute;
+
+namespace detail
+{
+    inline const small_posit_tables<16, 1>& tables_of(const posit16&) { return p16_tables(); }
+    inline const small_posit_tables<8, 0>& tables_of(const posit8&) { return p8_tables(); }
+
+    // Rounds x + err, err a sign at most a few ulps of x, to a small posit.
+    template<typename Scalar>
+    void small_store(Scalar& r, double x, double err)
+    {
+        const auto& tables = tables_of(r);
+        if (x != x) {
+            r.value = tables.nar;
+            return;
+        }
+        // outside float range the result is minpos or maxpos regardless
+        double magnitude = std::fabs(x);
+        if (magnitude > 0x1p64 || (magnitude < 0x1p-64 && magnitude != 0.0)) {
+            x = std::copysign(magnitude > 1.0 ? 0x1p64 : 0x1p-64, x);
+            err = 0.0;
+        }
+        float f = float(x);
+        double rest = x - double(f);
+        r.value = tables.round(f, float(rest != 0.0 ? rest : err));
+    }
+
+    template<typename Scalar>
+    struct small_quire_storage
+    {
+        static uint32_t widen(const Scalar& v)
+        {
+            float f = tables_of(v).decode[v.value];
+            return f != f ? p32_nar : p32_from_double(f);
+        }
+
+        static void store(Scalar& r, uint32_t bits) { small_store(r, bits == p32_nar ? std::nan("") : p32_to_double(bits), 0.0); }
+
+        static void store(Scalar& r, const p32_quire& q)
+        {
+            double err;
+            double sum = q.to_double(err);
+            small_store(r, q.nar ? std::nan("") : sum, err);
+        }
+    };
+
+    template<> struct quire_storage<posit16> : small_quire_storage<posit16> {};
+    template<> struct quire_storage<posit8> : small_quire_storage<posit8> {};
+
+    constexpr int float_tile = 256;
+
+    // res += alpha * lhs * rhs with float compute: tiles of the operands are
+    // decoded into float, multiplied with Eigen's float GEMM into a float
+    // accumulator tile, and rounded into res once all of depth is summed.
+    template<typename Scalar, int LhsStorageOrder, int RhsStorageOrder, typename Index>
+    void small_float_gemm(Index rows, Index cols, Index depth,
+                          const Scalar* lhs, Index lhsStride, const Scalar* rhs, Index rhsStride,
+                          Scalar* res, Index resIncr, Index resStride, Scalar alpha)
+    {
+        using namespace Eigen;
+        using namespace Eigen::internal;
+        typedef general_matrix_matrix_product<Index, float, ColMajor, false, float, ColMajor, false, ColMajor, 1> float_gemm;
+        const float* decode = tables_of(alpha).decode;
+        // tiles no larger than the product, so a matrix-vector product allocates a column
+        Index tm = std::min<Index>(float_tile, rows), tn = std::min<Index>(float_tile, cols), tk = std::min<Index>(float_tile, depth);
+        std::vector<float, aligned_allocator<float>> buffer(tm * tk + tk * tn + tm * tn);
+        float* block_a = buffer.data();
+        float* block_b = block_a + tm * tk;
+        float* acc = block_b + tk * tn;
+        gemm_blocking_space<ColMajor, float, float, Dynamic, Dynamic, Dynamic> blocking(tm, tn, tk, 1, true);
+
+        for (Index j0{}; j0 < cols; j0 += float_tile) {
+            Index nc = std::min<Index>(float_tile, cols - j0);
+            for (Index i0{}; i0 < rows; i0 += float_tile) {
+                Index mc = std::min<Index>(float_tile, rows - i0);
+                std::fill(acc, acc + mc * nc, 0.0f);
+                for (Index k0{}; k0 < depth; k0 += float_tile) {
+                    Index kc = std::min<Index>(float_tile, depth - k0);
+                    for (Index k{}; k < kc; ++k)
+                        for (Index i{}; i < mc; ++i)
+                            block_a[i + k * mc] = decode[(LhsStorageOrder == ColMajor ? lhs[(i0 + i) + (k0 + k) * lhsStride] : lhs[(i0 + i) * lhsStride + k0 + k]).value];
+                    for (Index j{}; j < nc; ++j)
+                        for (Index k{}; k < kc; ++k)
+                            block_b[k + j * kc] = decode[(RhsStorageOrder == ColMajor ? rhs[(k0 + k) + (j0 + j) * rhsStride] : rhs[(k0 + k) * rhsStride + j0 + j]).value];
+                    float_gemm::run(mc, nc, kc, block_a, mc, block_b, kc, acc, 1, mc, 1.0f, blocking);
+                }
+                for (Index j{}; j < nc; ++j) {
+                    for (Index i{}; i < mc; ++i) {
+                        Scalar& r = res[(i0 + i) * resIncr + (j0 + j) * resStride];
+                        small_store(r, double(decode[r.value]) + double(decode[alpha.value]) * acc[i + j * mc], 0.0);
+                    }
+                }
+            }
+        }
+    }
+
+    // Native compute: Eigen's sequential Goto loop over the storage type,
+    // with blocking buffers of its own so slices can run concurrently.
+    template<typename Scalar, int LhsStorageOrder, bool ConjugateLhs, int RhsStorageOrder, bool ConjugateRhs, int ResInnerStride, typename Index>
+    void gebp_gemm(Index rows, Index cols, Index depth,
+                   const Scalar* _lhs, Index lhsStride, const Scalar* _rhs, Index rhsStride,
+                   Scalar* _res, Index resIncr, Index resStride, Scalar alpha)
+    {
+        using namespace Eigen;
+        using namespace Eigen::internal;
+        typedef gebp_traits<Scalar, Scalar> Traits;
+        typedef const_blas_data_mapper<Scalar, Index, LhsStorageOrder> LhsMapper;
+        typedef const_blas_data_mapper<Scalar, Index, RhsStorageOrder> RhsMapper;
+        typedef blas_data_mapper<Scalar, Index, ColMajor, Unaligned, ResInnerStride> ResMapper;
+        LhsMapper lhs(_lhs, lhsStride);
+        RhsMapper rhs(_rhs, rhsStride);
+        ResMapper res(_res, resStride, resIncr);
+
+        gemm_blocking_space<ColMajor, Scalar, Scalar, Dynamic, Dynamic, Dynamic> blocking(rows, cols, depth, 1, true);
+        Index kc = blocking.kc();
+        Index mc = (std::min)(rows, blocking.mc());
+        Index nc = (std::min)(cols, blocking.nc());
+        blocking.allocateAll();
+
+        gemm_pack_lhs<Scalar, Index, LhsMapper, Traits::mr, Traits::LhsProgress, typename Traits::LhsPacket4Packing, LhsStorageOrder> pack_lhs;
+        gemm_pack_rhs<Scalar, Index, RhsMapper, Traits::nr, RhsStorageOrder> pack_rhs;
+        gebp_kernel<Scalar, Scalar, Index, ResMapper, Traits::mr, Traits::nr, ConjugateLhs, ConjugateRhs> gebp;
+
+        const bool pack_rhs_once = mc != rows && kc == depth && nc == cols;
+        for (Index i2{}; i2 < rows; i2 += mc) {
+            const Index actual_mc = (std::min)(i2 + mc, rows) - i2;
+            for (Index k2{}; k2 < depth; k2 += kc) {
+                const Index actual_kc = (std::min)(k2 + kc, depth) - k2;
+                pack_lhs(blocking.blockA(), lhs.getSubMapper(i2, k2), actual_kc, actual_mc);
+                for (Index j2{}; j2 < cols; j2 += nc) {
+                    const Index actual_nc = (std::min)(j2 + nc, cols) - j2;
+                    if (!pack_rhs_once || i2 == 0)
+                        pack_rhs(blocking.blockB(), rhs.getSubMapper(k2, j2), actual_kc, actual_nc);
+                    gebp(res.getSubMapper(i2, j2), blocking.blockA(), blocking.blockB(), actual_mc, actual_kc, actual_nc, alpha);
+                }
+            }
+        }
+    }
+
+    template<typename Index, typename Scalar, int LhsStorageOrder, bool ConjugateLhs, int RhsStorageOrder, bool ConjugateRhs, int ResInnerStride>
+    struct small_posit_gemm
+    {
+        typedef Eigen::internal::gebp_traits<Scalar, Scalar> Traits;
+        typedef Scalar ResScalar;
+
+        static void run(Index rows, Index cols, Index depth,
+                        const Scalar* lhs, Index lhsStride,
+                        const Scalar* rhs, Index rhsStride,
+                        Scalar* res, Index resIncr, Index resStride,
+                        Scalar alpha,
+                        Eigen::internal::level3_blocking<Scalar, Scalar>& /*blocking*/,
+                        Eigen::internal::GemmParallelInfo<Index>* info = 0)
+        {
+            constexpr auto kernel = std::is_same_v<small_compute, posit32> ? p32_quire_gemm<LhsStorageOrder, RhsStorageOrder, Scalar, Index>
+                                  : std::is_same_v<small_compute, float> ? small_float_gemm<Scalar, LhsStorageOrder, RhsStorageOrder, Index>
+                                  : gebp_gemm<Scalar, LhsStorageOrder, ConjugateLhs, RhsStorageOrder, ConjugateRhs, ResInnerStride, Index>;
+            if (info) {
+                kernel(rows, cols, depth, lhs, lhsStride, rhs, rhsStride, res, resIncr, resStride, alpha);
+                return;
+            }
+            if (rows > cols) {
+                parallel_slices(rows, Index(Traits::mr), double(cols) * double(depth), [&](Index i0, Index i1) {
+                    kernel(i1 - i0, cols, depth, lhs + (LhsStorageOrder == Eigen::ColMajor ? i0 : i0 * lhsStride), lhsStride,
+                           rhs, rhsStride, res + i0 * resIncr, resIncr, resStride, alpha);
+                });
+            } else {
+                parallel_slices(cols, Index(Traits::nr), double(rows) * double(depth), [&](Index j0, Index j1) {
+                    kernel(rows, j1 - j0, depth, lhs, lhsStride,
+                           rhs + (RhsStorageOrder == Eigen::ColMajor ? j0 * rhsStride : j0), rhsStride,
+                           res + j0 * resStride, resIncr, resStride, alpha);
+                });
+            }
+        }
+    };
+
+    template<typename XprType>
+    struct is_product_sum : std::false_type {};
+
+    template<typename Scalar, typename Lhs, typename Rhs>
+    struct is_product_sum<Eigen::CwiseBinaryOp<Eigen::internal::scalar_product_op<Scalar, Scalar>, Lhs, Rhs>> : std::true_type {};
+
+    template<typename Scalar, typename Lhs, typename Rhs>
+    struct is_product_sum<Eigen::CwiseBinaryOp<Eigen::internal::scalar_conj_product_op<Scalar, Scalar>, Lhs, Rhs>> : std::true_type {};
+
+    // sum() of posit8 and posit16 expressions. Sums of coefficient-wise
+    // products, which are dot() and the coefficients Eigen computes one at a
+    // time for products too small for its GEMM, take the compute type too
+    // and round once. Other sums, and all sums with native compute, round
+    // after every operation as Eigen's do.
+    struct small_redux
+    {
+        template<typename Evaluator, typename Func, typename XprType>
+        static typename XprType::Scalar run(const Evaluator& eval, const Func&, const XprType& xpr)
+        {
+            typedef typename XprType::Scalar Scalar;
+            Scalar r;
+            if constexpr (is_product_sum<XprType>::value && std::is_same_v<small_compute, posit32>) {
+                Eigen::internal::evaluator<std::decay_t<decltype(xpr.lhs())>> lhs(xpr.lhs());
+                Eigen::internal::evaluator<std::decay_t<decltype(xpr.rhs())>> rhs(xpr.rhs());
+                const long interval = p32_quire::normalize_interval(1);
+                p32_quire q;
+                long n{};
+                for (Eigen::Index j{}; j < xpr.cols(); ++j) {
+                    for (Eigen::Index i{}; i < xpr.rows(); ++i) {
+                        q.add_product(quire_storage<Scalar>::widen(lhs.coeff(i, j)), quire_storage<Scalar>::widen(rhs.coeff(i, j)));
+                        if (++n % interval == 0) q.normalize();
+                    }
+                }
+                quire_storage<Scalar>::store(r, q);
+            } else if constexpr (is_product_sum<XprType>::value && std::is_same_v<small_compute, float>) {
+                Eigen::internal::evaluator<std::decay_t<decltype(xpr.lhs())>> lhs(xpr.lhs());
+                Eigen::internal::evaluator<std::decay_t<decltype(xpr.rhs())>> rhs(xpr.rhs());
+                const float* decode = tables_of(r).decode;
+                float acc{};
+                for (Eigen::Index j{}; j < xpr.cols(); ++j)
+                    for (Eigen::Index i{}; i < xpr.rows(); ++i)
+                        acc = std::fma(decode[lhs.coeff(i, j).value], decode[rhs.coeff(i, j).value], acc);
+                small_store(r, acc, 0.0);
+            } else {
+                r = eval.coeff(0, 0);
+                for (Eigen::Index j{}; j < xpr.cols(); ++j)
+                    for (Eigen::Index i{ j == 0 }; i < xpr.rows(); ++i)
+                        r = r + eval.coeff(i, j);
+            }
+            return r;
+        }
+    };
+
+    // Matrix-vector products, and products whose rhs has one column at run
+    // time, in the same compute type as small_posit_gemm, so A * x rounds as
+    // a column of A * B does. The float and native kernels take the rhs,
+    // copied out of Eigen's mapper, as a one-column matrix.
+    template<typename Index, typename Scalar, typename LhsMapper, int LhsStorageOrder, typename RhsMapper>
+    struct small_posit_gemv
+    {
+        typedef Eigen::internal::gebp_traits<Scalar, Scalar> Traits;
+        typedef Scalar ResScalar;
+
+        static void run(Index rows, Index cols, const LhsMapper& lhs, const RhsMapper& rhs,
+                        Scalar* res, Index resIncr, Scalar alpha)
+        {
+            if constexpr (std::is_same_v<small_compute, posit32>) {
+                parallel_slices(rows, Index(quire_mc), double(cols), [&](Index i0, Index i1) {
+                    p32_quire_gemv<LhsStorageOrder>(i1 - i0, cols, lhs.getSubMapper(i0, 0), rhs, res + i0 * resIncr, resIncr, alpha);
+                });
+            } else {
+                constexpr auto kernel = std::is_same_v<small_compute, float> ? small_float_gemm<Scalar, LhsStorageOrder, Eigen::ColMajor, Index>
+                                      : gebp_gemm<Scalar, LhsStorageOrder, false, Eigen::ColMajor, false, Eigen::Dynamic, Index>;
+                std::vector<Scalar> x(cols);
+                for (Index k{}; k < cols; ++k) x[k] = rhs(k, 0);
+                parallel_slices(rows, Index(Traits::mr), double(cols), [&](Index i0, Index i1) {
+                    kernel(i1 - i0, Index(1), cols, &lhs(i0, 0), lhs.stride(), x.data(), cols,
+                           res + i0 * resIncr, resIncr, (i1 - i0) * resIncr, alpha);
+                });
+            }
+        }
+    };
+}
+}
+
+namespace Eigen
+{
+namespace internal
+{
+    template<typename Index, int LhsStorageOrder, bool ConjugateLhs, int RhsStorageOrder, bool ConjugateRhs, int ResInnerStride>
+    struct general_matrix_matrix_product<Index, posit16, LhsStorageOrder, ConjugateLhs, posit16, RhsStorageOrder, ConjugateRhs, ColMajor, ResInnerStride>
+        : eigen_posit::detail::small_posit_gemm<Index, posit16, LhsStorageOrder, ConjugateLhs, RhsStorageOrder, ConjugateRhs, ResInnerStride> {};
+
+    template<typename Index, int LhsStorageOrder, bool ConjugateLhs, int RhsStorageOrder, bool ConjugateRhs, int ResInnerStride>
+    struct general_matrix_matrix_product<Index, posit8, LhsStorageOrder, ConjugateLhs, posit8, RhsStorageOrder, ConjugateRhs, ColMajor, ResInnerStride>
+        : eigen_posit::detail::small_posit_gemm<Index, posit8, LhsStorageOrder, ConjugateLhs, RhsStorageOrder, ConjugateRhs, ResInnerStride> {};
+
+    template<typename Evaluator>
+    struct redux_impl<scalar_sum_op<posit16, posit16>, Evaluator, DefaultTraversal, NoUnrolling> : eigen_posit::detail::small_redux {};
+
+    template<typename Evaluator>
+    struct redux_impl<scalar_sum_op<posit16, posit16>, Evaluator, DefaultTraversal, CompleteUnrolling> : eigen_posit::detail::small_redux {};
+
+    template<typename Evaluator>
+    struct redux_impl<scalar_sum_op<posit16, posit16>, Evaluator, LinearVectorizedTraversal, NoUnrolling> : eigen_posit::detail::small_redux {};
+
+    template<typename Evaluator>
+    struct redux_impl<scalar_sum_op<posit16, posit16>, Evaluator, LinearVectorizedTraversal, CompleteUnrolling> : eigen_posit::detail::small_redux {};
+
+    template<typename Evaluator, int Unrolling>
+    struct redux_impl<scalar_sum_op<posit16, posit16>, Evaluator, SliceVectorizedTraversal, Unrolling> : eigen_posit::detail::small_redux {};
+
+    template<typename Evaluator>
+    struct redux_impl<scalar_sum_op<posit8, posit8>, Evaluator, DefaultTraversal, NoUnrolling> : eigen_posit::detail::small_redux {};
+
+    template<typename Evaluator>
+    struct redux_impl<scalar_sum_op<posit8, posit8>, Evaluator, DefaultTraversal, CompleteUnrolling> : eigen_posit::detail::small_redux {};
+
+    template<typename Evaluator>
+    struct redux_impl<scalar_sum_op<posit8, posit8>, Evaluator, LinearVectorizedTraversal, NoUnrolling> : eigen_posit::detail::small_redux {};
+
+    template<typename Evaluator>
+    struct redux_impl<scalar_sum_op<posit8, posit8>, Evaluator, LinearVectorizedTraversal, CompleteUnrolling> : eigen_posit::detail::small_redux {};
+
+    template<typename Evaluator, int Unrolling>
+    struct redux_impl<scalar_sum_op<posit8, posit8>, Evaluator, SliceVectorizedTraversal, Unrolling> : eigen_posit::detail::small_redux {};
+
+    template<typename Index, typename LhsMapper, bool ConjugateLhs, typename RhsMapper, bool ConjugateRhs, int Version>
+    struct general_matrix_vector_product<Index, posit16, LhsMapper, ColMajor, ConjugateLhs, posit16, RhsMapper, ConjugateRhs, Version>
+        : eigen_posit::detail::small_posit_gemv<Index, posit16, LhsMapper, ColMajor, RhsMapper> {};
+
+    template<typename Index, typename LhsMapper, bool ConjugateLhs, typename RhsMapper, bool ConjugateRhs, int Version>
+    struct general_matrix_vector_product<Index, posit16, LhsMapper, RowMajor, ConjugateLhs, posit16, RhsMapper, ConjugateRhs, Version>
+        : eigen_posit::detail::small_posit_gemv<Index, posit16, LhsMapper, RowMajor, RhsMapper> {};
+
+    template<typename Index, typename LhsMapper, bool ConjugateLhs, typename RhsMapper, bool ConjugateRhs, int Version>
+    struct general_matrix_vector_product<Index, posit8, LhsMapper, ColMajor, ConjugateLhs, posit8, RhsMapper, ConjugateRhs, Version>
+        : eigen_posit::detail::small_posit_gemv<Index, posit8, LhsMapper, ColMajor, RhsMapper> {};
+
+    template<typename Index, typename LhsMapper, bool ConjugateLhs, typename RhsMapper, bool ConjugateRhs, int Version>
+    struct general_matrix_vector_product<Index, posit8, LhsMapper, RowMajor, ConjugateLhs, posit8, RhsMapper, ConjugateRhs, Version>
+        : eigen_posit::detail::small_posit_gemv<Index, posit8, LhsMapper, RowMajor, RhsMapper> {};
+}
+}
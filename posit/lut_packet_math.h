@@ -0,0 +1,554 @@
+#pragma once
+
+#include "packet_math.h"
+#include "lut.h"
+#include <cstring>
+
+// Eigen glue for the table-driven posit8 and posit16 arithmetic in lut.h.
+// The scalar functors Eigen applies per coefficient, and the scalar packet
+// ops its product kernels fall back to, go through the tables instead of
+// SoftPosit. With AVX2 and FMA, posit16 additionally gets 8-lane packets
+// (decoded to float through a gather) and posit8 16-lane packets (gathers
+// straight from the operation tables). Any other x86-64 build gets 16-lane
+// packets of both whose arithmetic calls the kernel set picked from cpuid
+// (dispatch.h), so the baseline binary still runs the AVX2 loops where the
+// host has them. posit16's sqrt, exp, log and tanh are the tables of
+// elementary.h, scalar and packet alike.
+namespace eigen_posit
+{
+    inline posit16 p16_from_bits(uint16_t bits)
+    {
+        posit16 r;
+        r.value = bits;
+        return r;
+    }
+
+    inline posit8 p8_from_bits(uint8_t bits)
+    {
+        posit8 r;
+        r.value = bits;
+        return r;
+    }
+}
+
+#if defined(EIGEN_VECTORIZE_SSE2) && !defined(EIGEN_POSIT_VECTORIZE_AVX2)
+#define EIGEN_POSIT_SMALL_VECTORIZE_DISPATCH
+#endif
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wignored-attributes"
+
+namespace Eigen
+{
+namespace internal
+{
+    template<> EIGEN_STRONG_INLINE posit16 scalar_sum_op<posit16, posit16>::operator()(const posit16& a, const posit16& b) const { return eigen_posit::p16_from_bits(eigen_posit::p16_add(a.value, b.value)); }
+    template<> EIGEN_STRONG_INLINE const posit16 scalar_difference_op<posit16, posit16>::operator()(const posit16& a, const posit16& b) const { return eigen_posit::p16_from_bits(eigen_posit::p16_sub(a.value, b.value)); }
+    template<> EIGEN_STRONG_INLINE posit16 scalar_product_op<posit16, posit16>::operator()(const posit16& a, const posit16& b) const { return eigen_posit::p16_from_bits(eigen_posit::p16_mul(a.value, b.value)); }
+    template<> EIGEN_STRONG_INLINE const posit16 scalar_quotient_op<posit16, posit16>::operator()(const posit16& a, const posit16& b) const { return eigen_posit::p16_from_bits(eigen_posit::p16_div(a.value, b.value)); }
+
+    template<> EIGEN_STRONG_INLINE posit16 padd<posit16>(const posit16& a, const posit16& b) { return eigen_posit::p16_from_bits(eigen_posit::p16_add(a.value, b.value)); }
+    template<> EIGEN_STRONG_INLINE posit16 psub<posit16>(const posit16& a, const posit16& b) { return eigen_posit::p16_from_bits(eigen_posit::p16_sub(a.value, b.value)); }
+    template<> EIGEN_STRONG_INLINE posit16 pmul<posit16>(const posit16& a, const posit16& b) { return eigen_posit::p16_from_bits(eigen_posit::p16_mul(a.value, b.value)); }
+    template<> EIGEN_STRONG_INLINE posit16 pdiv<posit16>(const posit16& a, const posit16& b) { return eigen_posit::p16_from_bits(eigen_posit::p16_div(a.value, b.value)); }
+
+    template<> EIGEN_STRONG_INLINE posit8 scalar_sum_op<posit8, posit8>::operator()(const posit8& a, const posit8& b) const { return eigen_posit::p8_from_bits(eigen_posit::p8_add(a.value, b.value)); }
+    template<> EIGEN_STRONG_INLINE const posit8 scalar_difference_op<posit8, posit8>::operator()(const posit8& a, const posit8& b) const { return eigen_posit::p8_from_bits(eigen_posit::p8_sub(a.value, b.value)); }
+    template<> EIGEN_STRONG_INLINE posit8 scalar_product_op<posit8, posit8>::operator()(const posit8& a, const posit8& b) const { return eigen_posit::p8_from_bits(eigen_posit::p8_mul(a.value, b.value)); }
+    template<> EIGEN_STRONG_INLINE const posit8 scalar_quotient_op<posit8, posit8>::operator()(const posit8& a, const posit8& b) const { return eigen_posit::p8_from_bits(eigen_posit::p8_div(a.value, b.value)); }
+
+    template<> EIGEN_STRONG_INLINE posit8 padd<posit8>(const posit8& a, const posit8& b) { return eigen_posit::p8_from_bits(eigen_posit::p8_add(a.value, b.value)); }
+    template<> EIGEN_STRONG_INLINE posit8 psub<posit8>(const posit8& a, const posit8& b) { return eigen_posit::p8_from_bits(eigen_posit::p8_sub(a.value, b.value)); }
+    template<> EIGEN_STRONG_INLINE posit8 pmul<posit8>(const posit8& a, const posit8& b) { return eigen_posit::p8_from_bits(eigen_posit::p8_mul(a.value, b.value)); }
+    template<> EIGEN_STRONG_INLINE posit8 pdiv<posit8>(const posit8& a, const posit8& b) { return eigen_posit::p8_from_bits(eigen_posit::p8_div(a.value, b.value)); }
+
+    // ordering on the bits, as for posit32 in packet_math.h
+    template<> EIGEN_STRONG_INLINE posit16 pmin<posit16>(const posit16& a, const posit16& b) { return int16_t(b.value) < int16_t(a.value) ? b : a; }
+    template<> EIGEN_STRONG_INLINE posit16 pmax<posit16>(const posit16& a, const posit16& b) { return int16_t(a.value) < int16_t(b.value) ? b : a; }
+    template<> EIGEN_STRONG_INLINE posit8 pmin<posit8>(const posit8& a, const posit8& b) { return int8_t(b.value) < int8_t(a.value) ? b : a; }
+    template<> EIGEN_STRONG_INLINE posit8 pmax<posit8>(const posit8& a, const posit8& b) { return int8_t(a.value) < int8_t(b.value) ? b : a; }
+
+#if defined(EIGEN_POSIT_VECTORIZE_AVX2) || defined(EIGEN_POSIT_SMALL_VECTORIZE_DISPATCH)
+    struct small_posit_packet_traits : default_packet_traits {
+        enum {
+            Vectorizable = 1,
+            AlignedOnScalar = 1,
+            HasHalfPacket = 0,
+
+            HasAdd = 1,
+            HasSub = 1,
+            HasMul = 1,
+            HasDiv = 1,
+            HasNegate = 1,
+            HasConj = 1,
+            HasAbs = 1,
+            HasAbs2 = 1,
+            HasMin = 1,
+            HasMax = 1,
+            HasSetLinear = 0,
+            HasBlend = 0,
+            HasCmp = 0
+        };
+    };
+#endif
+
+#ifdef EIGEN_POSIT_VECTORIZE_AVX2
+    typedef eigen_packet_wrapper<__m128i, 18> Packet8p16;
+    typedef eigen_packet_wrapper<__m128i, 19> Packet16p8;
+    template<> struct is_arithmetic<Packet8p16> { enum { value = true }; };
+    template<> struct is_arithmetic<Packet16p8> { enum { value = true }; };
+
+    template<>
+    struct packet_traits<posit16> : small_posit_packet_traits {
+        typedef Packet8p16 type;
+        typedef Packet8p16 half;
+        enum { size = 8, HasSqrt = 1, HasExp = 1, HasLog = 1, HasTanh = 1 };
+    };
+
+    template<>
+    struct packet_traits<posit8> : small_posit_packet_traits {
+        typedef Packet16p8 type;
+        typedef Packet16p8 half;
+        enum { size = 16 };
+    };
+
+    template<> struct unpacket_traits<Packet8p16> {
+        typedef posit16 type;
+        typedef Packet8p16 half;
+        enum { size = 8, alignment = Aligned16, vectorizable = true, masked_load_available = false, masked_store_available = false };
+    };
+
+    template<> struct unpacket_traits<Packet16p8> {
+        typedef posit8 type;
+        typedef Packet16p8 half;
+        enum { size = 16, alignment = Aligned16, vectorizable = true, masked_load_available = false, masked_store_available = false };
+    };
+
+    template<> EIGEN_STRONG_INLINE Packet8p16 pset1<Packet8p16>(const posit16& from) { return _mm_set1_epi16(short(from.value)); }
+    template<> EIGEN_STRONG_INLINE posit16 pfirst<Packet8p16>(const Packet8p16& a) { return eigen_posit::p16_from_bits(uint16_t(_mm_extract_epi16(a, 0))); }
+
+    template<> EIGEN_STRONG_INLINE Packet8p16 pload<Packet8p16>(const posit16* from) { EIGEN_DEBUG_ALIGNED_LOAD return _mm_load_si128(reinterpret_cast<const __m128i*>(from)); }
+    template<> EIGEN_STRONG_INLINE Packet8p16 ploadu<Packet8p16>(const posit16* from) { EIGEN_DEBUG_UNALIGNED_LOAD return _mm_loadu_si128(reinterpret_cast<const __m128i*>(from)); }
+    template<> EIGEN_STRONG_INLINE void pstore<posit16>(posit16* to, const Packet8p16& from) { EIGEN_DEBUG_ALIGNED_STORE _mm_store_si128(reinterpret_cast<__m128i*>(to), from); }
+    template<> EIGEN_STRONG_INLINE void pstoreu<posit16>(posit16* to, const Packet8p16& from) { EIGEN_DEBUG_UNALIGNED_STORE _mm_storeu_si128(reinterpret_cast<__m128i*>(to), from); }
+
+    template<> EIGEN_STRONG_INLINE Packet8p16 ploaddup<Packet8p16>(const posit16* from)
+    {
+        __m128i lo = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(from));
+        return _mm_unpacklo_epi16(lo, lo);
+    }
+    template<> EIGEN_STRONG_INLINE Packet8p16 ploadquad<Packet8p16>(const posit16* from)
+    {
+        __m128i lo = _mm_cvtsi32_si128(int(from[0].value | uint32_t(from[1].value) << 16));
+        lo = _mm_unpacklo_epi16(lo, lo);
+        return _mm_unpacklo_epi32(lo, lo);
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet8p16 pgather<posit16, Packet8p16>(const posit16* from, Index stride)
+    {
+        return _mm_setr_epi16(short(from[0].value), short(from[stride].value), short(from[2 * stride].value), short(from[3 * stride].value),
+                              short(from[4 * stride].value), short(from[5 * stride].value), short(from[6 * stride].value), short(from[7 * stride].value));
+    }
+    template<> EIGEN_STRONG_INLINE void pscatter<posit16, Packet8p16>(posit16* to, const Packet8p16& from, Index stride)
+    {
+        EIGEN_ALIGN16 uint16_t lanes[8];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), from);
+        for (int i{}; i < 8; ++i) to[i * stride].value = lanes[i];
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet8p16 padd<Packet8p16>(const Packet8p16& a, const Packet8p16& b) { return eigen_posit::simd::p16_add(a, b); }
+    template<> EIGEN_STRONG_INLINE Packet8p16 psub<Packet8p16>(const Packet8p16& a, const Packet8p16& b) { return eigen_posit::simd::p16_sub(a, b); }
+    template<> EIGEN_STRONG_INLINE Packet8p16 pmul<Packet8p16>(const Packet8p16& a, const Packet8p16& b) { return eigen_posit::simd::p16_mul(a, b); }
+    template<> EIGEN_STRONG_INLINE Packet8p16 pdiv<Packet8p16>(const Packet8p16& a, const Packet8p16& b) { return eigen_posit::simd::p16_div(a, b); }
+    template<> EIGEN_STRONG_INLINE Packet8p16 pnegate(const Packet8p16& a) { return _mm_sub_epi16(_mm_setzero_si128(), a); }
+    template<> EIGEN_STRONG_INLINE Packet8p16 pconj(const Packet8p16& a) { return a; }
+    template<> EIGEN_STRONG_INLINE Packet8p16 pabs(const Packet8p16& a) { return _mm_abs_epi16(a); }
+    template<> EIGEN_STRONG_INLINE Packet8p16 pmin<Packet8p16>(const Packet8p16& a, const Packet8p16& b) { return _mm_min_epi16(a, b); }
+    template<> EIGEN_STRONG_INLINE Packet8p16 pmax<Packet8p16>(const Packet8p16& a, const Packet8p16& b) { return _mm_max_epi16(a, b); }
+
+    template<> EIGEN_STRONG_INLINE Packet8p16 psqrt<Packet8p16>(const Packet8p16& a) { return eigen_posit::simd::p16_sqrt(a); }
+    template<> EIGEN_STRONG_INLINE Packet8p16 pexp<Packet8p16>(const Packet8p16& a) { return eigen_posit::simd::p16_exp(a); }
+    template<> EIGEN_STRONG_INLINE Packet8p16 plog<Packet8p16>(const Packet8p16& a) { return eigen_posit::simd::p16_log(a); }
+    template<> EIGEN_STRONG_INLINE Packet8p16 ptanh<Packet8p16>(const Packet8p16& a) { return eigen_posit::simd::p16_tanh(a); }
+
+    template<> EIGEN_STRONG_INLINE posit16 predux<Packet8p16>(const Packet8p16& a)
+    {
+        Packet8p16 quads = padd<Packet8p16>(a, _mm_shuffle_epi32(a, _MM_SHUFFLE(1, 0, 3, 2)));
+        Packet8p16 pairs = padd<Packet8p16>(quads, _mm_shuffle_epi32(quads, _MM_SHUFFLE(2, 3, 0, 1)));
+        return pfirst<Packet8p16>(padd<Packet8p16>(pairs, _mm_shufflelo_epi16(pairs, _MM_SHUFFLE(2, 3, 0, 1))));
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet8p16 preverse(const Packet8p16& a)
+    {
+        return _mm_shuffle_epi8(a, _mm_setr_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1));
+    }
+
+    template<int N>
+    EIGEN_STRONG_INLINE void ptranspose(PacketBlock<Packet8p16, N>& kernel)
+    {
+        PacketBlock<Packet8h, N> h;
+        for (int i{}; i < N; ++i) h.packet[i] = Packet8h(kernel.packet[i]);
+        ptranspose(h);
+        for (int i{}; i < N; ++i) kernel.packet[i] = Packet8p16(h.packet[i]);
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet16p8 pset1<Packet16p8>(const posit8& from) { return _mm_set1_epi8(char(from.value)); }
+    template<> EIGEN_STRONG_INLINE posit8 pfirst<Packet16p8>(const Packet16p8& a) { return eigen_posit::p8_from_bits(uint8_t(_mm_cvtsi128_si32(a))); }
+
+    template<> EIGEN_STRONG_INLINE Packet16p8 pload<Packet16p8>(const posit8* from) { EIGEN_DEBUG_ALIGNED_LOAD return _mm_load_si128(reinterpret_cast<const __m128i*>(from)); }
+    template<> EIGEN_STRONG_INLINE Packet16p8 ploadu<Packet16p8>(const posit8* from) { EIGEN_DEBUG_UNALIGNED_LOAD return _mm_loadu_si128(reinterpret_cast<const __m128i*>(from)); }
+    template<> EIGEN_STRONG_INLINE void pstore<posit8>(posit8* to, const Packet16p8& from) { EIGEN_DEBUG_ALIGNED_STORE _mm_store_si128(reinterpret_cast<__m128i*>(to), from); }
+    template<> EIGEN_STRONG_INLINE void pstoreu<posit8>(posit8* to, const Packet16p8& from) { EIGEN_DEBUG_UNALIGNED_STORE _mm_storeu_si128(reinterpret_cast<__m128i*>(to), from); }
+
+    template<> EIGEN_STRONG_INLINE Packet16p8 ploaddup<Packet16p8>(const posit8* from)
+    {
+        __m128i lo = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(from));
+        return _mm_unpacklo_epi8(lo, lo);
+    }
+    template<> EIGEN_STRONG_INLINE Packet16p8 ploadquad<Packet16p8>(const posit8* from)
+    {
+        __m128i lo = _mm_cvtsi32_si128(int(from[0].value | uint32_t(from[1].value) << 8 | uint32_t(from[2].value) << 16 | uint32_t(from[3].value) << 24));
+        return _mm_shuffle_epi8(lo, _mm_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3));
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet16p8 pgather<posit8, Packet16p8>(const posit8* from, Index stride)
+    {
+        EIGEN_ALIGN16 uint8_t lanes[16];
+        for (int i{}; i < 16; ++i) lanes[i] = from[i * stride].value;
+        return _mm_load_si128(reinterpret_cast<const __m128i*>(lanes));
+    }
+    template<> EIGEN_STRONG_INLINE void pscatter<posit8, Packet16p8>(posit8* to, const Packet16p8& from, Index stride)
+    {
+        EIGEN_ALIGN16 uint8_t lanes[16];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), from);
+        for (int i{}; i < 16; ++i) to[i * stride].value = lanes[i];
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet16p8 padd<Packet16p8>(const Packet16p8& a, const Packet16p8& b) { return eigen_posit::simd::p8_add(a, b); }
+    template<> EIGEN_STRONG_INLINE Packet16p8 psub<Packet16p8>(const Packet16p8& a, const Packet16p8& b) { return eigen_posit::simd::p8_sub(a, b); }
+    template<> EIGEN_STRONG_INLINE Packet16p8 pmul<Packet16p8>(const Packet16p8& a, const Packet16p8& b) { return eigen_posit::simd::p8_mul(a, b); }
+    template<> EIGEN_STRONG_INLINE Packet16p8 pdiv<Packet16p8>(const Packet16p8& a, const Packet16p8& b) { return eigen_posit::simd::p8_div(a, b); }
+    template<> EIGEN_STRONG_INLINE Packet16p8 pnegate(const Packet16p8& a) { return _mm_sub_epi8(_mm_setzero_si128(), a); }
+    template<> EIGEN_STRONG_INLINE Packet16p8 pconj(const Packet16p8& a) { return a; }
+    template<> EIGEN_STRONG_INLINE Packet16p8 pabs(const Packet16p8& a) { return _mm_abs_epi8(a); }
+    template<> EIGEN_STRONG_INLINE Packet16p8 pmin<Packet16p8>(const Packet16p8& a, const Packet16p8& b) { return _mm_min_epi8(a, b); }
+    template<> EIGEN_STRONG_INLINE Packet16p8 pmax<Packet16p8>(const Packet16p8& a, const Packet16p8& b) { return _mm_max_epi8(a, b); }
+
+    template<> EIGEN_STRONG_INLINE posit8 predux<Packet16p8>(const Packet16p8& a)
+    {
+        Packet16p8 octets = padd<Packet16p8>(a, _mm_shuffle_epi32(a, _MM_SHUFFLE(1, 0, 3, 2)));
+        Packet16p8 quads = padd<Packet16p8>(octets, _mm_shuffle_epi32(octets, _MM_SHUFFLE(2, 3, 0, 1)));
+        Packet16p8 pairs = padd<Packet16p8>(quads, _mm_shufflelo_epi16(quads, _MM_SHUFFLE(2, 3, 0, 1)));
+        return pfirst<Packet16p8>(padd<Packet16p8>(pairs, _mm_srli_epi16(pairs, 8)));
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet16p8 preverse(const Packet16p8& a)
+    {
+        return _mm_shuffle_epi8(a, _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+    }
+
+    template<int N>
+    EIGEN_STRONG_INLINE void ptranspose(PacketBlock<Packet16p8, N>& kernel)
+    {
+        PacketBlock<Packet16b, N> b;
+        for (int i{}; i < N; ++i) b.packet[i] = Packet16b(kernel.packet[i]);
+        ptranspose(b);
+        for (int i{}; i < N; ++i) kernel.packet[i] = Packet16p8(b.packet[i]);
+    }
+#endif
+
+#ifdef EIGEN_POSIT_SMALL_VECTORIZE_DISPATCH
+    // 16 lanes of raw bits, arithmetic through the kernel set picked at run
+    // time, as Packet16p32 in packet_math.h
+    struct Packet16p16 { uint16_t lane[16]; };
+    struct Packet16p8 { uint8_t lane[16]; };
+
+    template<>
+    struct packet_traits<posit16> : small_posit_packet_traits {
+        typedef Packet16p16 type;
+        typedef Packet16p16 half;
+        enum { size = 16, HasSqrt = 1, HasExp = 1, HasLog = 1, HasTanh = 1 };
+    };
+
+    template<>
+    struct packet_traits<posit8> : small_posit_packet_traits {
+        typedef Packet16p8 type;
+        typedef Packet16p8 half;
+        enum { size = 16 };
+    };
+
+    template<> struct unpacket_traits<Packet16p16> {
+        typedef posit16 type;
+        typedef Packet16p16 half;
+        enum { size = 16, alignment = Aligned16, vectorizable = true, masked_load_available = false, masked_store_available = false };
+    };
+
+    template<> EIGEN_STRONG_INLINE Packet16p16 pset1<Packet16p16>(const posit16& from)
+    {
+        Packet16p16 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = from.value;
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE posit16 pfirst<Packet16p16>(const Packet16p16& a) { return eigen_posit::p16_from_bits(a.lane[0]); }
+
+    template<> EIGEN_STRONG_INLINE Packet16p16 pload<Packet16p16>(const posit16* from) { EIGEN_DEBUG_ALIGNED_LOAD Packet16p16 r; std::memcpy(&r, from, sizeof r); return r; }
+    template<> EIGEN_STRONG_INLINE Packet16p16 ploadu<Packet16p16>(const posit16* from) { EIGEN_DEBUG_UNALIGNED_LOAD Packet16p16 r; std::memcpy(&r, from, sizeof r); return r; }
+    template<> EIGEN_STRONG_INLINE void pstore<posit16>(posit16* to, const Packet16p16& from)
+    {
+        EIGEN_DEBUG_ALIGNED_STORE
+        for (int i{}; i < 16; ++i) to[i].value = from.lane[i];
+    }
+    template<> EIGEN_STRONG_INLINE void pstoreu<posit16>(posit16* to, const Packet16p16& from)
+    {
+        EIGEN_DEBUG_UNALIGNED_STORE
+        for (int i{}; i < 16; ++i) to[i].value = from.lane[i];
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet16p16 ploaddup<Packet16p16>(const posit16* from)
+    {
+        Packet16p16 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = from[i / 2].value;
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE Packet16p16 ploadquad<Packet16p16>(const posit16* from)
+    {
+        Packet16p16 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = from[i / 4].value;
+        return r;
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet16p16 pgather<posit16, Packet16p16>(const posit16* from, Index stride)
+    {
+        Packet16p16 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = from[i * stride].value;
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE void pscatter<posit16, Packet16p16>(posit16* to, const Packet16p16& from, Index stride)
+    {
+        for (int i{}; i < 16; ++i) to[i * stride].value = from.lane[i];
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet16p16 padd<Packet16p16>(const Packet16p16& a, const Packet16p16& b) { Packet16p16 r; eigen_posit::active_kernels().p16_add(a.lane, b.lane, r.lane, 16); return r; }
+    template<> EIGEN_STRONG_INLINE Packet16p16 psub<Packet16p16>(const Packet16p16& a, const Packet16p16& b) { Packet16p16 r; eigen_posit::active_kernels().p16_sub(a.lane, b.lane, r.lane, 16); return r; }
+    template<> EIGEN_STRONG_INLINE Packet16p16 pmul<Packet16p16>(const Packet16p16& a, const Packet16p16& b) { Packet16p16 r; eigen_posit::active_kernels().p16_mul(a.lane, b.lane, r.lane, 16); return r; }
+    template<> EIGEN_STRONG_INLINE Packet16p16 pdiv<Packet16p16>(const Packet16p16& a, const Packet16p16& b) { Packet16p16 r; eigen_posit::active_kernels().p16_div(a.lane, b.lane, r.lane, 16); return r; }
+
+    template<> EIGEN_STRONG_INLINE Packet16p16 pnegate(const Packet16p16& a)
+    {
+        Packet16p16 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = uint16_t(0u - a.lane[i]);
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE Packet16p16 pconj(const Packet16p16& a) { return a; }
+    template<> EIGEN_STRONG_INLINE Packet16p16 pabs(const Packet16p16& a)
+    {
+        Packet16p16 r;
+        for (int i{}; i < 16; ++i) {
+            uint16_t sign = uint16_t(int16_t(a.lane[i]) >> 15);
+            r.lane[i] = uint16_t((a.lane[i] ^ sign) - sign);
+        }
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE Packet16p16 pmin<Packet16p16>(const Packet16p16& a, const Packet16p16& b)
+    {
+        Packet16p16 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = int16_t(b.lane[i]) < int16_t(a.lane[i]) ? b.lane[i] : a.lane[i];
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE Packet16p16 pmax<Packet16p16>(const Packet16p16& a, const Packet16p16& b)
+    {
+        Packet16p16 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = int16_t(a.lane[i]) < int16_t(b.lane[i]) ? b.lane[i] : a.lane[i];
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE Packet16p16 psqrt<Packet16p16>(const Packet16p16& a)
+    {
+        Packet16p16 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = eigen_posit::p16_sqrt(a.lane[i]);
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE Packet16p16 pexp<Packet16p16>(const Packet16p16& a)
+    {
+        Packet16p16 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = eigen_posit::p16_exp(a.lane[i]);
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE Packet16p16 plog<Packet16p16>(const Packet16p16& a)
+    {
+        Packet16p16 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = eigen_posit::p16_log(a.lane[i]);
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE Packet16p16 ptanh<Packet16p16>(const Packet16p16& a)
+    {
+        Packet16p16 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = eigen_posit::p16_tanh(a.lane[i]);
+        return r;
+    }
+
+    template<> EIGEN_STRONG_INLINE posit16 predux<Packet16p16>(const Packet16p16& a)
+    {
+        Packet16p16 t = a;
+        for (std::size_t n = 8; n > 0; n /= 2) eigen_posit::active_kernels().p16_add(t.lane, t.lane + n, t.lane, n);
+        return eigen_posit::p16_from_bits(t.lane[0]);
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet16p16 preverse(const Packet16p16& a)
+    {
+        Packet16p16 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = a.lane[15 - i];
+        return r;
+    }
+
+    template<int N>
+    EIGEN_STRONG_INLINE void ptranspose(PacketBlock<Packet16p16, N>& kernel)
+    {
+        PacketBlock<Packet16p16, N> in = kernel;
+        for (int f{}; f < N * 16; ++f) kernel.packet[f / 16].lane[f % 16] = in.packet[f % N].lane[f / N];
+    }
+
+    template<> struct unpacket_traits<Packet16p8> {
+        typedef posit8 type;
+        typedef Packet16p8 half;
+        enum { size = 16, alignment = Aligned16, vectorizable = true, masked_load_available = false, masked_store_available = false };
+    };
+
+    template<> EIGEN_STRONG_INLINE Packet16p8 pset1<Packet16p8>(const posit8& from)
+    {
+        Packet16p8 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = from.value;
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE posit8 pfirst<Packet16p8>(const Packet16p8& a) { return eigen_posit::p8_from_bits(a.lane[0]); }
+
+    template<> EIGEN_STRONG_INLINE Packet16p8 pload<Packet16p8>(const posit8* from) { EIGEN_DEBUG_ALIGNED_LOAD Packet16p8 r; std::memcpy(&r, from, sizeof r); return r; }
+    template<> EIGEN_STRONG_INLINE Packet16p8 ploadu<Packet16p8>(const posit8* from) { EIGEN_DEBUG_UNALIGNED_LOAD Packet16p8 r; std::memcpy(&r, from, sizeof r); return r; }
+    template<> EIGEN_STRONG_INLINE void pstore<posit8>(posit8* to, const Packet16p8& from)
+    {
+        EIGEN_DEBUG_ALIGNED_STORE
+        for (int i{}; i < 16; ++i) to[i].value = from.lane[i];
+    }
+    template<> EIGEN_STRONG_INLINE void pstoreu<posit8>(posit8* to, const Packet16p8& from)
+    {
+        EIGEN_DEBUG_UNALIGNED_STORE
+        for (int i{}; i < 16; ++i) to[i].value = from.lane[i];
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet16p8 ploaddup<Packet16p8>(const posit8* from)
+    {
+        Packet16p8 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = from[i / 2].value;
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE Packet16p8 ploadquad<Packet16p8>(const posit8* from)
+    {
+        Packet16p8 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = from[i / 4].value;
+        return r;
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet16p8 pgather<posit8, Packet16p8>(const posit8* from, Index stride)
+    {
+        Packet16p8 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = from[i * stride].value;
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE void pscatter<posit8, Packet16p8>(posit8* to, const Packet16p8& from, Index stride)
+    {
+        for (int i{}; i < 16; ++i) to[i * stride].value = from.lane[i];
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet16p8 padd<Packet16p8>(const Packet16p8& a, const Packet16p8& b) { Packet16p8 r; eigen_posit::active_kernels().p8_add(a.lane, b.lane, r.lane, 16); return r; }
+    template<> EIGEN_STRONG_INLINE Packet16p8 psub<Packet16p8>(const Packet16p8& a, const Packet16p8& b) { Packet16p8 r; eigen_posit::active_kernels().p8_sub(a.lane, b.lane, r.lane, 16); return r; }
+    template<> EIGEN_STRONG_INLINE Packet16p8 pmul<Packet16p8>(const Packet16p8& a, const Packet16p8& b) { Packet16p8 r; eigen_posit::active_kernels().p8_mul(a.lane, b.lane, r.lane, 16); return r; }
+    template<> EIGEN_STRONG_INLINE Packet16p8 pdiv<Packet16p8>(const Packet16p8& a, const Packet16p8& b) { Packet16p8 r; eigen_posit::active_kernels().p8_div(a.lane, b.lane, r.lane, 16); return r; }
+
+    template<> EIGEN_STRONG_INLINE Packet16p8 pnegate(const Packet16p8& a)
+    {
+        Packet16p8 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = uint8_t(0u - a.lane[i]);
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE Packet16p8 pconj(const Packet16p8& a) { return a; }
+    template<> EIGEN_STRONG_INLINE Packet16p8 pabs(const Packet16p8& a)
+    {
+        Packet16p8 r;
+        for (int i{}; i < 16; ++i) {
+            uint8_t sign = uint8_t(int8_t(a.lane[i]) >> 7);
+            r.lane[i] = uint8_t((a.lane[i] ^ sign) - sign);
+        }
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE Packet16p8 pmin<Packet16p8>(const Packet16p8& a, const Packet16p8& b)
+    {
+        Packet16p8 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = int8_t(b.lane[i]) < int8_t(a.lane[i]) ? b.lane[i] : a.lane[i];
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE Packet16p8 pmax<Packet16p8>(const Packet16p8& a, const Packet16p8& b)
+    {
+        Packet16p8 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = int8_t(a.lane[i]) < int8_t(b.lane[i]) ? b.lane[i] : a.lane[i];
+        return r;
+    }
+
+    template<> EIGEN_STRONG_INLINE posit8 predux<Packet16p8>(const Packet16p8& a)
+    {
+        Packet16p8 t = a;
+        for (std::size_t n = 8; n > 0; n /= 2) eigen_posit::active_kernels().p8_add(t.lane, t.lane + n, t.lane, n);
+        return eigen_posit::p8_from_bits(t.lane[0]);
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet16p8 preverse(const Packet16p8& a)
+    {
+        Packet16p8 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = a.lane[15 - i];
+        return r;
+    }
+
+    template<int N>
+    EIGEN_STRONG_INLINE void ptranspose(PacketBlock<Packet16p8, N>& kernel)
+    {
+        PacketBlock<Packet16p8, N> in = kernel;
+        for (int f{}; f < N * 16; ++f) kernel.packet[f / 16].lane[f % 16] = in.packet[f % N].lane[f / N];
+    }
+#endif
+
+    template<> struct functor_traits<scalar_sqrt_op<posit16>> : eigen_posit::detail::posit_sqrt_traits<posit16, packet_traits<posit16>::HasSqrt> {};
+
+    template<> struct sqrt_impl<posit16>
+    {
+        static EIGEN_ALWAYS_INLINE posit16 run(const posit16& x) { return eigen_posit::p16_from_bits(eigen_posit::p16_sqrt(x.value)); }
+    };
+
+    template<> struct log_impl<posit16>
+    {
+        static EIGEN_ALWAYS_INLINE posit16 run(const posit16& x) { return eigen_posit::p16_from_bits(eigen_posit::p16_log(x.value)); }
+    };
+
+    template<> struct hypot_impl<posit16>
+    {
+        static inline posit16 run(const posit16& x, const posit16& y) { return eigen_posit::p16_from_bits(eigen_posit::p16_hypot(x.value, y.value)); }
+    };
+}
+
+namespace numext
+{
+    template<> EIGEN_STRONG_INLINE posit16 abs<posit16>(const posit16& a)
+    {
+        uint16_t sign = uint16_t(int16_t(a.value) >> 15);
+        return eigen_posit::p16_from_bits(uint16_t((a.value ^ sign) - sign));
+    }
+
+    template<> EIGEN_STRONG_INLINE posit16 exp<posit16>(const posit16& x) { return eigen_posit::p16_from_bits(eigen_posit::p16_exp(x.value)); }
+    template<> EIGEN_STRONG_INLINE posit16 tanh<posit16>(const posit16& x) { return eigen_posit::p16_from_bits(eigen_posit::p16_tanh(x.value)); }
+
+    template<> EIGEN_STRONG_INLINE posit8 abs<posit8>(const posit8& a)
+    {
+        uint8_t sign = uint8_t(int8_t(a.value) >> 7);
+        return eigen_posit::p8_from_bits(uint8_t((a.value ^ sign) - sign));
+    }
+}
+}
+
+#pragma GCC diagnostic pop
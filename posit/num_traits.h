@@ -0,0 +1,52 @@
+#pragma once
+
+#include "softposit_cpp.h"
+#include "posit.h"
+#include <Eigen/Core>
+#include <type_traits>
+
+namespace eigen_posit
+{
+namespace detail
+{
+    template<typename T>
+    struct is_softposit : std::bool_constant<std::is_same_v<T, posit8> || std::is_same_v<T, posit16> || std::is_same_v<T, posit32>> {};
+}
+}
+
+// SoftPosit's operators are members, so a number on the left, as in Eigen's
+// 2 * v.lpNorm<1>() in rcond(), has no match; these convert it first.
+template<typename T, typename Posit, typename = std::enable_if_t<std::is_arithmetic_v<T> && eigen_posit::detail::is_softposit<Posit>::value>>
+Posit operator+(T a, const Posit& b) { return Posit(double(a)) + b; }
+template<typename T, typename Posit, typename = std::enable_if_t<std::is_arithmetic_v<T> && eigen_posit::detail::is_softposit<Posit>::value>>
+Posit operator-(T a, const Posit& b) { return Posit(double(a)) - b; }
+template<typename T, typename Posit, typename = std::enable_if_t<std::is_arithmetic_v<T> && eigen_posit::detail::is_softposit<Posit>::value>>
+Posit operator*(T a, const Posit& b) { return Posit(double(a)) * b; }
+template<typename T, typename Posit, typename = std::enable_if_t<std::is_arithmetic_v<T> && eigen_posit::detail::is_softposit<Posit>::value>>
+Posit operator/(T a, const Posit& b) { return Posit(double(a)) / b; }
+
+namespace Eigen
+{
+    template<> struct NumTraits<posit8> : eigen_posit::detail::posit_num_traits<posit8, 8, 0, eigen_posit::costs::softposit8> {};
+    template<> struct NumTraits<posit16> : eigen_posit::detail::posit_num_traits<posit16, 16, 1, eigen_posit::costs::softposit16> {};
+    template<> struct NumTraits<posit32> : eigen_posit::detail::posit_num_traits<posit32, 32, 2, eigen_posit::costs::softposit32> {};
+
+namespace internal
+{
+    // posit16 and posit32 vectorize sqrt; their traits are in lut_packet_math.h and packet_math.h
+    template<> struct functor_traits<scalar_sqrt_op<posit8>> : eigen_posit::detail::posit_sqrt_traits<posit8> {};
+
+    template<> struct functor_traits<scalar_cast_op<posit8, float>> : eigen_posit::detail::posit_cast_traits<posit8> {};
+    template<> struct functor_traits<scalar_cast_op<posit8, double>> : eigen_posit::detail::posit_cast_traits<posit8> {};
+    template<> struct functor_traits<scalar_cast_op<float, posit8>> : eigen_posit::detail::posit_cast_traits<posit8> {};
+    template<> struct functor_traits<scalar_cast_op<double, posit8>> : eigen_posit::detail::posit_cast_traits<posit8> {};
+    template<> struct functor_traits<scalar_cast_op<posit16, float>> : eigen_posit::detail::posit_cast_traits<posit16> {};
+    template<> struct functor_traits<scalar_cast_op<posit16, double>> : eigen_posit::detail::posit_cast_traits<posit16> {};
+    template<> struct functor_traits<scalar_cast_op<float, posit16>> : eigen_posit::detail::posit_cast_traits<posit16> {};
+    template<> struct functor_traits<scalar_cast_op<double, posit16>> : eigen_posit::detail::posit_cast_traits<posit16> {};
+    template<> struct functor_traits<scalar_cast_op<posit32, float>> : eigen_posit::detail::posit_cast_traits<posit32> {};
+    template<> struct functor_traits<scalar_cast_op<posit32, double>> : eigen_posit::detail::posit_cast_traits<posit32> {};
+    template<> struct functor_traits<scalar_cast_op<float, posit32>> : eigen_posit::detail::posit_cast_traits<posit32> {};
+    template<> struct functor_traits<scalar_cast_op<double, posit32>> : eigen_posit::detail::posit_cast_traits<posit32> {};
+}
+}
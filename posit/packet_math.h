@@ -0,0 +1,503 @@
+#pragma once
+
+#include "dispatch.h"
+#include "num_traits.h"
+#include "elementary.h"
+#include "kernels.h"
+#include "quire.h"
+#include <cstring>
+
+// Eigen packet math for posit32. A packet holds the raw posit bits, so loads,
+// stores, broadcasts and shuffles are plain integer moves; arithmetic runs the
+// bit-exact kernels from kernels.h. Posits order like their bits read as two's
+// complement integers, so min, max, abs and negation are integer instructions
+// too, scalar and packet alike. NaR, the most negative integer, orders below
+// every real: min() propagates it, max() drops it. With packet_traits<posit32> vectorizable,
+// posit matrices use Eigen's vectorized evaluators and the GEBP product kernel
+// instead of one SoftPosit call per coefficient. sqrt, exp, log and tanh are
+// vectorized too, through Eigen's double packet functions (elementary.h).
+//
+// Built with -msse4.2 or -mavx2 the packets inline the kernels for that
+// instruction set, and the binary needs it. A build for baseline x86-64 uses
+// Packet16p32 instead, whose arithmetic calls the kernel set picked from
+// cpuid at run time (dispatch.h): sixteen lanes, so a single call fills the
+// widest kernel. exp, log and tanh run the scalar kernels lane by lane there.
+
+#if defined(EIGEN_VECTORIZE_SSE4_2)
+#define EIGEN_POSIT_VECTORIZE_SSE
+#endif
+#if defined(EIGEN_VECTORIZE_AVX2) && defined(EIGEN_VECTORIZE_FMA)
+#define EIGEN_POSIT_VECTORIZE_AVX2
+#endif
+#if defined(EIGEN_VECTORIZE_SSE2) && !defined(EIGEN_POSIT_VECTORIZE_SSE) && !defined(EIGEN_POSIT_VECTORIZE_AVX2)
+#define EIGEN_POSIT_VECTORIZE_DISPATCH
+#endif
+
+namespace eigen_posit
+{
+    inline posit32 p32_from_bits(uint32_t bits)
+    {
+        posit32 r;
+        r.value = bits;
+        return r;
+    }
+
+#if defined(EIGEN_POSIT_VECTORIZE_SSE) || defined(EIGEN_POSIT_VECTORIZE_AVX2)
+namespace detail
+{
+    inline bool all_lanes(__m128i mask) { return _mm_movemask_epi8(mask) == 0xFFFF; }
+#ifdef EIGEN_POSIT_VECTORIZE_AVX2
+    inline bool all_lanes(__m256i mask) { return _mm256_movemask_epi8(mask) == -1; }
+#endif
+
+    // elementary.h on a packet: f runs on Eigen's double packets and each
+    // lane rounds once, except lanes near a rounding point, which take the
+    // scalar kernel.
+    template<typename Isa, typename F>
+    typename Isa::ivec p32_packet_elementary(typename Isa::ivec a, F f, uint32_t (*scalar)(uint32_t))
+    {
+        using namespace Eigen::internal;
+        typedef typename Isa::dvec D;
+        D x0, x1;
+        simd::p32_decode<Isa>(a, x0, x1);
+        D y0 = f(x0), y1 = f(x1);
+        const D below = pset1<D>(1.0 - elementary_tolerance), above = pset1<D>(1.0 + elementary_tolerance), zero = pset1<D>(0.0);
+        typename Isa::ivec lo = simd::p32_encode<Isa>(pmul(y0, below), pmul(y1, below), zero, zero);
+        typename Isa::ivec hi = simd::p32_encode<Isa>(pmul(y0, above), pmul(y1, above), zero, zero);
+        if (all_lanes(Isa::cmpeq(lo, hi))) return lo;
+
+        uint32_t in[Isa::lanes], low[Isa::lanes], high[Isa::lanes];
+        std::memcpy(in, &a, sizeof a);
+        std::memcpy(low, &lo, sizeof lo);
+        std::memcpy(high, &hi, sizeof hi);
+        for (int i{}; i < Isa::lanes; ++i)
+            if (low[i] != high[i]) low[i] = scalar(in[i]);
+        std::memcpy(&lo, low, sizeof lo);
+        return lo;
+    }
+
+    template<typename Isa>
+    typename Isa::ivec p32_packet_exp(typename Isa::ivec a)
+    {
+        using namespace Eigen::internal;
+        typedef typename Isa::dvec D;
+        const D limit = pset1<D>(p32_exp_limit);
+        typename Isa::ivec r = p32_packet_elementary<Isa>(a, [&](D x) { return pexp(pmax(pmin(x, limit), pnegate(limit))); }, &p32_exp);
+        typename Isa::ivec nar = Isa::set1(int32_t(p32_nar));
+        return Isa::select(Isa::cmpeq(a, nar), nar, r);
+    }
+
+    template<typename Isa>
+    typename Isa::ivec p32_packet_log(typename Isa::ivec a)
+    {
+        using namespace Eigen::internal;
+        typedef typename Isa::dvec D;
+        typename Isa::ivec r = p32_packet_elementary<Isa>(a, [](D x) { return plog(x); }, &p32_log);
+        // zero, negative numbers and NaR read as integers below 1
+        return Isa::select(Isa::cmpgt(Isa::set1(1), a), Isa::set1(int32_t(p32_nar)), r);
+    }
+
+    // tanh is odd and posits negate exactly, so the lanes go through |x|;
+    // tanh(x) = -expm1(-2x) / (2 + expm1(-2x)) keeps its accuracy near 0.
+    template<typename Isa>
+    typename Isa::ivec p32_packet_tanh(typename Isa::ivec a)
+    {
+        using namespace Eigen::internal;
+        typedef typename Isa::dvec D;
+        const D limit = pset1<D>(p32_tanh_limit);
+        typename Isa::ivec sign = Isa::template srai<31>(a);
+        typename Isa::ivec magnitude = Isa::sub(Isa::xor_(a, sign), sign);
+        typename Isa::ivec r = p32_packet_elementary<Isa>(magnitude, [&](D x) {
+            D e = generic_expm1(pmul(pset1<D>(-2.0), pmin(x, limit)));
+            return pnegate(pdiv(e, padd(pset1<D>(2.0), e)));
+        }, &p32_tanh);
+        r = Isa::sub(Isa::xor_(r, sign), sign);
+        typename Isa::ivec nar = Isa::set1(int32_t(p32_nar));
+        return Isa::select(Isa::cmpeq(a, nar), nar, r);
+    }
+}
+#endif
+}
+
+// the wrapped SIMD types trip -Wignored-attributes the same way Eigen's own do
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wignored-attributes"
+
+namespace Eigen
+{
+namespace internal
+{
+#ifdef EIGEN_POSIT_VECTORIZE_SSE
+    typedef eigen_packet_wrapper<__m128i, 16> Packet4p32;
+    template<> struct is_arithmetic<Packet4p32> { enum { value = true }; };
+#endif
+#ifdef EIGEN_POSIT_VECTORIZE_AVX2
+    typedef eigen_packet_wrapper<__m256i, 17> Packet8p32;
+    template<> struct is_arithmetic<Packet8p32> { enum { value = true }; };
+#endif
+#ifdef EIGEN_POSIT_VECTORIZE_DISPATCH
+    struct Packet16p32 { uint32_t lane[16]; };
+#endif
+
+    template<> EIGEN_STRONG_INLINE posit32 pmin<posit32>(const posit32& a, const posit32& b) { return int32_t(b.value) < int32_t(a.value) ? b : a; }
+    template<> EIGEN_STRONG_INLINE posit32 pmax<posit32>(const posit32& a, const posit32& b) { return int32_t(a.value) < int32_t(b.value) ? b : a; }
+
+#if defined(EIGEN_POSIT_VECTORIZE_SSE) || defined(EIGEN_POSIT_VECTORIZE_AVX2) || defined(EIGEN_POSIT_VECTORIZE_DISPATCH)
+    template<>
+    struct packet_traits<posit32> : default_packet_traits {
+#if defined(EIGEN_POSIT_VECTORIZE_DISPATCH)
+        typedef Packet16p32 type;
+        typedef Packet16p32 half;
+        enum { size = 16, HasHalfPacket = 0 };
+#elif defined(EIGEN_POSIT_VECTORIZE_AVX2)
+        typedef Packet8p32 type;
+        typedef Packet4p32 half;
+        enum { size = 8, HasHalfPacket = 1 };
+#else
+        typedef Packet4p32 type;
+        typedef Packet4p32 half;
+        enum { size = 4, HasHalfPacket = 0 };
+#endif
+        enum {
+            Vectorizable = 1,
+            AlignedOnScalar = 1,
+
+            HasAdd = 1,
+            HasSub = 1,
+            HasMul = 1,
+            HasDiv = 1,
+            HasNegate = 1,
+            HasConj = 1,
+            HasAbs = 1,
+            HasAbs2 = 1,
+            HasMin = 1,
+            HasMax = 1,
+            HasSqrt = 1,
+            HasExp = 1,
+            HasLog = 1,
+            HasTanh = 1,
+            HasSetLinear = 0,
+            HasBlend = 0,
+            HasCmp = 0
+        };
+    };
+#endif
+
+#ifdef EIGEN_POSIT_VECTORIZE_SSE
+    template<> struct unpacket_traits<Packet4p32> {
+        typedef posit32 type;
+        typedef Packet4p32 half;
+        enum { size = 4, alignment = Aligned16, vectorizable = true, masked_load_available = false, masked_store_available = false };
+    };
+
+    template<> EIGEN_STRONG_INLINE Packet4p32 pset1<Packet4p32>(const posit32& from) { return _mm_set1_epi32(int(from.value)); }
+    template<> EIGEN_STRONG_INLINE posit32 pfirst<Packet4p32>(const Packet4p32& a) { return eigen_posit::p32_from_bits(uint32_t(_mm_cvtsi128_si32(a))); }
+
+    template<> EIGEN_STRONG_INLINE Packet4p32 pload<Packet4p32>(const posit32* from) { EIGEN_DEBUG_ALIGNED_LOAD return _mm_load_si128(reinterpret_cast<const __m128i*>(from)); }
+    template<> EIGEN_STRONG_INLINE Packet4p32 ploadu<Packet4p32>(const posit32* from) { EIGEN_DEBUG_UNALIGNED_LOAD return _mm_loadu_si128(reinterpret_cast<const __m128i*>(from)); }
+    template<> EIGEN_STRONG_INLINE void pstore<posit32>(posit32* to, const Packet4p32& from) { EIGEN_DEBUG_ALIGNED_STORE _mm_store_si128(reinterpret_cast<__m128i*>(to), from); }
+    template<> EIGEN_STRONG_INLINE void pstoreu<posit32>(posit32* to, const Packet4p32& from) { EIGEN_DEBUG_UNALIGNED_STORE _mm_storeu_si128(reinterpret_cast<__m128i*>(to), from); }
+
+    template<> EIGEN_STRONG_INLINE Packet4p32 ploaddup<Packet4p32>(const posit32* from)
+    {
+        return _mm_shuffle_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(from)), _MM_SHUFFLE(1, 1, 0, 0));
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet4p32 pgather<posit32, Packet4p32>(const posit32* from, Index stride)
+    {
+        return _mm_set_epi32(int(from[3 * stride].value), int(from[2 * stride].value), int(from[stride].value), int(from[0].value));
+    }
+    template<> EIGEN_STRONG_INLINE void pscatter<posit32, Packet4p32>(posit32* to, const Packet4p32& from, Index stride)
+    {
+        EIGEN_ALIGN16 uint32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), from);
+        for (int i{}; i < 4; ++i) to[i * stride].value = lanes[i];
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet4p32 padd<Packet4p32>(const Packet4p32& a, const Packet4p32& b) { return eigen_posit::simd::p32_add<eigen_posit::simd::sse>(a, b); }
+    template<> EIGEN_STRONG_INLINE Packet4p32 psub<Packet4p32>(const Packet4p32& a, const Packet4p32& b) { return eigen_posit::simd::p32_sub<eigen_posit::simd::sse>(a, b); }
+    template<> EIGEN_STRONG_INLINE Packet4p32 pmul<Packet4p32>(const Packet4p32& a, const Packet4p32& b) { return eigen_posit::simd::p32_mul<eigen_posit::simd::sse>(a, b); }
+    template<> EIGEN_STRONG_INLINE Packet4p32 pdiv<Packet4p32>(const Packet4p32& a, const Packet4p32& b) { return eigen_posit::simd::p32_div<eigen_posit::simd::sse>(a, b); }
+    // negating a posit is two's complement negation of its bits, NaR maps to itself
+    template<> EIGEN_STRONG_INLINE Packet4p32 pnegate(const Packet4p32& a) { return _mm_sub_epi32(_mm_setzero_si128(), a); }
+    template<> EIGEN_STRONG_INLINE Packet4p32 pconj(const Packet4p32& a) { return a; }
+    template<> EIGEN_STRONG_INLINE Packet4p32 pabs(const Packet4p32& a) { return _mm_abs_epi32(a); }
+    template<> EIGEN_STRONG_INLINE Packet4p32 pmin<Packet4p32>(const Packet4p32& a, const Packet4p32& b) { return _mm_min_epi32(a, b); }
+    template<> EIGEN_STRONG_INLINE Packet4p32 pmax<Packet4p32>(const Packet4p32& a, const Packet4p32& b) { return _mm_max_epi32(a, b); }
+
+    template<> EIGEN_STRONG_INLINE Packet4p32 psqrt<Packet4p32>(const Packet4p32& a) { return eigen_posit::simd::p32_sqrt<eigen_posit::simd::sse>(a); }
+    template<> EIGEN_STRONG_INLINE Packet4p32 pexp<Packet4p32>(const Packet4p32& a) { return eigen_posit::detail::p32_packet_exp<eigen_posit::simd::sse>(a); }
+    template<> EIGEN_STRONG_INLINE Packet4p32 plog<Packet4p32>(const Packet4p32& a) { return eigen_posit::detail::p32_packet_log<eigen_posit::simd::sse>(a); }
+    template<> EIGEN_STRONG_INLINE Packet4p32 ptanh<Packet4p32>(const Packet4p32& a) { return eigen_posit::detail::p32_packet_tanh<eigen_posit::simd::sse>(a); }
+
+    template<> EIGEN_STRONG_INLINE posit32 predux<Packet4p32>(const Packet4p32& a)
+    {
+        Packet4p32 pairs = padd<Packet4p32>(a, _mm_shuffle_epi32(a, _MM_SHUFFLE(1, 0, 3, 2)));
+        return pfirst<Packet4p32>(padd<Packet4p32>(pairs, _mm_shuffle_epi32(pairs, _MM_SHUFFLE(2, 3, 0, 1))));
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet4p32 preverse(const Packet4p32& a) { return _mm_shuffle_epi32(a, _MM_SHUFFLE(0, 1, 2, 3)); }
+
+    EIGEN_STRONG_INLINE void ptranspose(PacketBlock<Packet4p32, 4>& kernel)
+    {
+        PacketBlock<Packet4f, 4> f;
+        for (int i{}; i < 4; ++i) f.packet[i] = _mm_castsi128_ps(kernel.packet[i]);
+        ptranspose(f);
+        for (int i{}; i < 4; ++i) kernel.packet[i] = _mm_castps_si128(f.packet[i]);
+    }
+#endif
+
+#ifdef EIGEN_POSIT_VECTORIZE_AVX2
+    template<> struct unpacket_traits<Packet8p32> {
+        typedef posit32 type;
+        typedef Packet4p32 half;
+        enum { size = 8, alignment = Aligned32, vectorizable = true, masked_load_available = false, masked_store_available = false };
+    };
+
+    template<> EIGEN_STRONG_INLINE Packet8p32 pset1<Packet8p32>(const posit32& from) { return _mm256_set1_epi32(int(from.value)); }
+    template<> EIGEN_STRONG_INLINE posit32 pfirst<Packet8p32>(const Packet8p32& a) { return eigen_posit::p32_from_bits(uint32_t(_mm_cvtsi128_si32(_mm256_castsi256_si128(a)))); }
+
+    template<> EIGEN_STRONG_INLINE Packet8p32 pload<Packet8p32>(const posit32* from) { EIGEN_DEBUG_ALIGNED_LOAD return _mm256_load_si256(reinterpret_cast<const __m256i*>(from)); }
+    template<> EIGEN_STRONG_INLINE Packet8p32 ploadu<Packet8p32>(const posit32* from) { EIGEN_DEBUG_UNALIGNED_LOAD return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(from)); }
+    template<> EIGEN_STRONG_INLINE void pstore<posit32>(posit32* to, const Packet8p32& from) { EIGEN_DEBUG_ALIGNED_STORE _mm256_store_si256(reinterpret_cast<__m256i*>(to), from); }
+    template<> EIGEN_STRONG_INLINE void pstoreu<posit32>(posit32* to, const Packet8p32& from) { EIGEN_DEBUG_UNALIGNED_STORE _mm256_storeu_si256(reinterpret_cast<__m256i*>(to), from); }
+
+    template<> EIGEN_STRONG_INLINE Packet8p32 ploaddup<Packet8p32>(const posit32* from)
+    {
+        __m256i lo = _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(from)));
+        return _mm256_permutevar8x32_epi32(lo, _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3));
+    }
+    template<> EIGEN_STRONG_INLINE Packet8p32 ploadquad<Packet8p32>(const posit32* from)
+    {
+        __m256i lo = _mm256_castsi128_si256(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(from)));
+        return _mm256_permutevar8x32_epi32(lo, _mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1));
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet8p32 pgather<posit32, Packet8p32>(const posit32* from, Index stride)
+    {
+        return _mm256_setr_epi32(int(from[0].value), int(from[stride].value), int(from[2 * stride].value), int(from[3 * stride].value),
+                                 int(from[4 * stride].value), int(from[5 * stride].value), int(from[6 * stride].value), int(from[7 * stride].value));
+    }
+    template<> EIGEN_STRONG_INLINE void pscatter<posit32, Packet8p32>(posit32* to, const Packet8p32& from, Index stride)
+    {
+        EIGEN_ALIGN32 uint32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), from);
+        for (int i{}; i < 8; ++i) to[i * stride].value = lanes[i];
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet8p32 padd<Packet8p32>(const Packet8p32& a, const Packet8p32& b) { return eigen_posit::simd::p32_add<eigen_posit::simd::avx2>(a, b); }
+    template<> EIGEN_STRONG_INLINE Packet8p32 psub<Packet8p32>(const Packet8p32& a, const Packet8p32& b) { return eigen_posit::simd::p32_sub<eigen_posit::simd::avx2>(a, b); }
+    template<> EIGEN_STRONG_INLINE Packet8p32 pmul<Packet8p32>(const Packet8p32& a, const Packet8p32& b) { return eigen_posit::simd::p32_mul<eigen_posit::simd::avx2>(a, b); }
+    template<> EIGEN_STRONG_INLINE Packet8p32 pdiv<Packet8p32>(const Packet8p32& a, const Packet8p32& b) { return eigen_posit::simd::p32_div<eigen_posit::simd::avx2>(a, b); }
+    template<> EIGEN_STRONG_INLINE Packet8p32 pnegate(const Packet8p32& a) { return _mm256_sub_epi32(_mm256_setzero_si256(), a); }
+    template<> EIGEN_STRONG_INLINE Packet8p32 pconj(const Packet8p32& a) { return a; }
+    template<> EIGEN_STRONG_INLINE Packet8p32 pabs(const Packet8p32& a) { return _mm256_abs_epi32(a); }
+    template<> EIGEN_STRONG_INLINE Packet8p32 pmin<Packet8p32>(const Packet8p32& a, const Packet8p32& b) { return _mm256_min_epi32(a, b); }
+    template<> EIGEN_STRONG_INLINE Packet8p32 pmax<Packet8p32>(const Packet8p32& a, const Packet8p32& b) { return _mm256_max_epi32(a, b); }
+
+    template<> EIGEN_STRONG_INLINE Packet8p32 psqrt<Packet8p32>(const Packet8p32& a) { return eigen_posit::simd::p32_sqrt<eigen_posit::simd::avx2>(a); }
+    template<> EIGEN_STRONG_INLINE Packet8p32 pexp<Packet8p32>(const Packet8p32& a) { return eigen_posit::detail::p32_packet_exp<eigen_posit::simd::avx2>(a); }
+    template<> EIGEN_STRONG_INLINE Packet8p32 plog<Packet8p32>(const Packet8p32& a) { return eigen_posit::detail::p32_packet_log<eigen_posit::simd::avx2>(a); }
+    template<> EIGEN_STRONG_INLINE Packet8p32 ptanh<Packet8p32>(const Packet8p32& a) { return eigen_posit::detail::p32_packet_tanh<eigen_posit::simd::avx2>(a); }
+
+    template<> EIGEN_STRONG_INLINE Packet4p32 predux_half_dowto4<Packet8p32>(const Packet8p32& a)
+    {
+        return padd<Packet4p32>(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1));
+    }
+    template<> EIGEN_STRONG_INLINE posit32 predux<Packet8p32>(const Packet8p32& a)
+    {
+        return predux<Packet4p32>(predux_half_dowto4<Packet8p32>(a));
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet8p32 preverse(const Packet8p32& a)
+    {
+        return _mm256_permutevar8x32_epi32(a, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    }
+
+    template<int N>
+    EIGEN_STRONG_INLINE void ptranspose(PacketBlock<Packet8p32, N>& kernel)
+    {
+        PacketBlock<Packet8f, N> f;
+        for (int i{}; i < N; ++i) f.packet[i] = _mm256_castsi256_ps(kernel.packet[i]);
+        ptranspose(f);
+        for (int i{}; i < N; ++i) kernel.packet[i] = _mm256_castps_si256(f.packet[i]);
+    }
+#endif
+
+#ifdef EIGEN_POSIT_VECTORIZE_DISPATCH
+    template<> struct unpacket_traits<Packet16p32> {
+        typedef posit32 type;
+        typedef Packet16p32 half;
+        enum { size = 16, alignment = Aligned16, vectorizable = true, masked_load_available = false, masked_store_available = false };
+    };
+
+    template<> EIGEN_STRONG_INLINE Packet16p32 pset1<Packet16p32>(const posit32& from)
+    {
+        Packet16p32 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = from.value;
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE posit32 pfirst<Packet16p32>(const Packet16p32& a) { return eigen_posit::p32_from_bits(a.lane[0]); }
+
+    template<> EIGEN_STRONG_INLINE Packet16p32 pload<Packet16p32>(const posit32* from) { EIGEN_DEBUG_ALIGNED_LOAD Packet16p32 r; std::memcpy(&r, from, sizeof r); return r; }
+    template<> EIGEN_STRONG_INLINE Packet16p32 ploadu<Packet16p32>(const posit32* from) { EIGEN_DEBUG_UNALIGNED_LOAD Packet16p32 r; std::memcpy(&r, from, sizeof r); return r; }
+    template<> EIGEN_STRONG_INLINE void pstore<posit32>(posit32* to, const Packet16p32& from)
+    {
+        EIGEN_DEBUG_ALIGNED_STORE
+        for (int i{}; i < 16; ++i) to[i].value = from.lane[i];
+    }
+    template<> EIGEN_STRONG_INLINE void pstoreu<posit32>(posit32* to, const Packet16p32& from)
+    {
+        EIGEN_DEBUG_UNALIGNED_STORE
+        for (int i{}; i < 16; ++i) to[i].value = from.lane[i];
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet16p32 ploaddup<Packet16p32>(const posit32* from)
+    {
+        Packet16p32 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = from[i / 2].value;
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE Packet16p32 ploadquad<Packet16p32>(const posit32* from)
+    {
+        Packet16p32 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = from[i / 4].value;
+        return r;
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet16p32 pgather<posit32, Packet16p32>(const posit32* from, Index stride)
+    {
+        Packet16p32 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = from[i * stride].value;
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE void pscatter<posit32, Packet16p32>(posit32* to, const Packet16p32& from, Index stride)
+    {
+        for (int i{}; i < 16; ++i) to[i * stride].value = from.lane[i];
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet16p32 padd<Packet16p32>(const Packet16p32& a, const Packet16p32& b) { Packet16p32 r; eigen_posit::active_kernels().add(a.lane, b.lane, r.lane, 16); return r; }
+    template<> EIGEN_STRONG_INLINE Packet16p32 psub<Packet16p32>(const Packet16p32& a, const Packet16p32& b) { Packet16p32 r; eigen_posit::active_kernels().sub(a.lane, b.lane, r.lane, 16); return r; }
+    template<> EIGEN_STRONG_INLINE Packet16p32 pmul<Packet16p32>(const Packet16p32& a, const Packet16p32& b) { Packet16p32 r; eigen_posit::active_kernels().mul(a.lane, b.lane, r.lane, 16); return r; }
+    template<> EIGEN_STRONG_INLINE Packet16p32 pdiv<Packet16p32>(const Packet16p32& a, const Packet16p32& b) { Packet16p32 r; eigen_posit::active_kernels().div(a.lane, b.lane, r.lane, 16); return r; }
+    template<> EIGEN_STRONG_INLINE Packet16p32 psqrt<Packet16p32>(const Packet16p32& a) { Packet16p32 r; eigen_posit::active_kernels().sqrt(a.lane, r.lane, 16); return r; }
+
+    // sign, order and magnitude are integer operations on the bits, as above
+    template<> EIGEN_STRONG_INLINE Packet16p32 pnegate(const Packet16p32& a)
+    {
+        Packet16p32 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = 0u - a.lane[i];
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE Packet16p32 pconj(const Packet16p32& a) { return a; }
+    template<> EIGEN_STRONG_INLINE Packet16p32 pabs(const Packet16p32& a)
+    {
+        Packet16p32 r;
+        for (int i{}; i < 16; ++i) {
+            uint32_t sign = uint32_t(int32_t(a.lane[i]) >> 31);
+            r.lane[i] = (a.lane[i] ^ sign) - sign;
+        }
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE Packet16p32 pmin<Packet16p32>(const Packet16p32& a, const Packet16p32& b)
+    {
+        Packet16p32 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = int32_t(b.lane[i]) < int32_t(a.lane[i]) ? b.lane[i] : a.lane[i];
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE Packet16p32 pmax<Packet16p32>(const Packet16p32& a, const Packet16p32& b)
+    {
+        Packet16p32 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = int32_t(a.lane[i]) < int32_t(b.lane[i]) ? b.lane[i] : a.lane[i];
+        return r;
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet16p32 pexp<Packet16p32>(const Packet16p32& a)
+    {
+        Packet16p32 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = eigen_posit::p32_exp(a.lane[i]);
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE Packet16p32 plog<Packet16p32>(const Packet16p32& a)
+    {
+        Packet16p32 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = eigen_posit::p32_log(a.lane[i]);
+        return r;
+    }
+    template<> EIGEN_STRONG_INLINE Packet16p32 ptanh<Packet16p32>(const Packet16p32& a)
+    {
+        Packet16p32 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = eigen_posit::p32_tanh(a.lane[i]);
+        return r;
+    }
+
+    // pairwise, halving the live lanes each step
+    template<> EIGEN_STRONG_INLINE posit32 predux<Packet16p32>(const Packet16p32& a)
+    {
+        Packet16p32 t = a;
+        for (std::size_t n = 8; n > 0; n /= 2) eigen_posit::active_kernels().add(t.lane, t.lane + n, t.lane, n);
+        return eigen_posit::p32_from_bits(t.lane[0]);
+    }
+
+    // The N x 16 block read column by column into N packets, as the other
+    // ptranspose overloads order it for N below the packet size.
+    template<int N>
+    EIGEN_STRONG_INLINE void ptranspose(PacketBlock<Packet16p32, N>& kernel)
+    {
+        PacketBlock<Packet16p32, N> in = kernel;
+        for (int f{}; f < N * 16; ++f) kernel.packet[f / 16].lane[f % 16] = in.packet[f % N].lane[f / N];
+    }
+
+    template<> EIGEN_STRONG_INLINE Packet16p32 preverse(const Packet16p32& a)
+    {
+        Packet16p32 r;
+        for (int i{}; i < 16; ++i) r.lane[i] = a.lane[15 - i];
+        return r;
+    }
+#endif
+}
+
+namespace internal
+{
+    // numext::sqrt, and with it cwiseSqrt(), without a libsoftposit call
+    template<> struct sqrt_impl<posit32>
+    {
+        static EIGEN_ALWAYS_INLINE posit32 run(const posit32& x) { return eigen_posit::p32_from_bits(eigen_posit::p32_sqrt(x.value)); }
+    };
+
+    template<> struct functor_traits<scalar_sqrt_op<posit32>> : eigen_posit::detail::posit_sqrt_traits<posit32, packet_traits<posit32>::HasSqrt> {};
+
+    template<> struct log_impl<posit32>
+    {
+        static EIGEN_ALWAYS_INLINE posit32 run(const posit32& x) { return eigen_posit::p32_from_bits(eigen_posit::p32_log(x.value)); }
+    };
+
+    // numext::hypot, as hypotNorm() and BDCSVD use it: x^2 + y^2 is
+    // exact in the quire, so the result rounds once and cannot overflow
+    template<> struct hypot_impl<posit32>
+    {
+        static inline posit32 run(const posit32& x, const posit32& y)
+        {
+            eigen_posit::p32_quire q;
+            q.add_product(x.value, x.value);
+            q.add_product(y.value, y.value);
+            return eigen_posit::p32_from_bits(q.to_posit_sqrt());
+        }
+    };
+}
+
+namespace numext
+{
+    // abs(INT_MIN) wraps to itself, so NaR stays NaR
+    template<> EIGEN_STRONG_INLINE posit32 abs<posit32>(const posit32& a)
+    {
+        uint32_t sign = uint32_t(int32_t(a.value) >> 31);
+        return eigen_posit::p32_from_bits((a.value ^ sign) - sign);
+    }
+
+    template<> EIGEN_STRONG_INLINE posit32 exp<posit32>(const posit32& x) { return eigen_posit::p32_from_bits(eigen_posit::p32_exp(x.value)); }
+    template<> EIGEN_STRONG_INLINE posit32 tanh<posit32>(const posit32& x) { return eigen_posit::p32_from_bits(eigen_posit::p32_tanh(x.value)); }
+}
+}
+
+#pragma GCC diagnostic pop
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Thread pool for the posit matrix products.
+//
+// Eigen multithreads products only through OpenMP, and only hands a thread
+// about 50k multiply-adds or more, a figure tuned for hardware float. A
+// posit multiply-add costs tens of float ones (decode, exact accumulation,
+// round), so posit products pay for extra threads at far smaller sizes.
+// The posit GEMM drivers cut the result into slices and run them here; the
+// calling thread takes a slice too. Products started from inside a slice run
+// serially.
+namespace eigen_posit
+{
+    // Fewest multiply-adds worth handing to a thread of its own; a wake-up
+    // and join costs a few microseconds, a posit multiply-add a few ns.
+    constexpr double parallel_min_work = 1 << 14;
+
+    class thread_pool
+    {
+    public:
+        explicit thread_pool(int threads)
+        {
+            for (int i{ 1 }; i < threads; ++i)
+                workers.emplace_back([this] { work(); });
+        }
+
+        ~thread_pool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop = true;
+            }
+            wake.notify_all();
+            for (std::thread& t : workers) t.join();
+        }
+
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        // Worker threads plus the caller.
+        int size() const { return int(workers.size()) + 1; }
+
+        // Runs task(0) ... task(n - 1) and returns once all have finished.
+        void run(int n, const std::function<void(int)>& task)
+        {
+            if (n <= 1 || workers.empty() || inside()) {
+                for (int i{}; i < n; ++i) task(i);
+                return;
+            }
+            std::lock_guard<std::mutex> submit(submitting);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                current = &task;
+                tasks = n;
+                next = 0;
+                busy = int(workers.size());
+                ++generation;
+            }
+            wake.notify_all();
+            drain();
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this] { return busy == 0; });
+            current = nullptr;
+        }
+
+    private:
+        static bool& inside()
+        {
+            thread_local bool flag{};
+            return flag;
+        }
+
+        void drain()
+        {
+            bool was_inside = inside();
+            inside() = true;
+            for (int i; (i = next.fetch_add(1)) < tasks;) (*current)(i);
+            inside() = was_inside;
+        }
+
+        void work()
+        {
+            unsigned seen{};
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&] { return stop || generation != seen; });
+                    if (stop) return;
+                    seen = generation;
+                }
+                drain();
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--busy == 0) done.notify_one();
+            }
+        }
+
+        std::vector<std::thread> workers;
+        std::mutex mutex, submitting;
+        std::condition_variable wake, done;
+        const std::function<void(int)>* current{};
+        int tasks{};
+        std::atomic<int> next{};
+        int busy{};
+        unsigned generation{};
+        bool stop{};
+    };
+
+namespace detail
+{
+    inline std::mutex& pool_mutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    inline std::unique_ptr<thread_pool>& pool_instance()
+    {
+        static std::unique_ptr<thread_pool> pool;
+        return pool;
+    }
+
+    inline int& thread_setting()
+    {
+        static int threads{ std::max(1, int(std::thread::hardware_concurrency())) };
+        return threads;
+    }
+}
+
+    // Threads the posit products may use; defaults to the hardware concurrency.
+    inline int num_threads() { return detail::thread_setting(); }
+
+    // Not to be called while a posit product is running.
+    inline void set_num_threads(int threads)
+    {
+        std::lock_guard<std::mutex> lock(detail::pool_mutex());
+        detail::thread_setting() = std::max(1, threads);
+        detail::pool_instance().reset();
+    }
+
+    inline thread_pool& default_pool()
+    {
+        std::lock_guard<std::mutex> lock(detail::pool_mutex());
+        std::unique_ptr<thread_pool>& pool = detail::pool_instance();
+        if (!pool) pool.reset(new thread_pool(num_threads()));
+        return *pool;
+    }
+
+    // Splits [0, n) into slices of whole grains, each worth at least
+    // parallel_min_work given the work per index, and runs f(begin, end) on
+    // them across the pool. Small ranges run as one call on this thread.
+    template<typename Index, typename F>
+    void parallel_slices(Index n, Index grain, double work_per_index, F&& f)
+    {
+        Index grains = (n + grain - 1) / grain;
+        Index slices = std::min<Index>({ Index(num_threads()), grains, Index(double(n) * work_per_index / parallel_min_work) });
+        if (slices <= 1) {
+            f(Index{}, n);
+            return;
+        }
+        Index step = (grains + slices - 1) / slices * grain;
+        slices = (n + step - 1) / step;
+        default_pool().run(int(slices), [&](int s) {
+            Index begin = s * step;
+            f(begin, std::min<Index>(n, begin + step));
+        });
+    }
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "parallel.h"
+#include "posit.h"
+#include <Eigen/Core>
+#include <algorithm>
+
+// Multithreaded coefficient-wise assignment for posit matrices and arrays.
+//
+// Eigen evaluates coefficient-wise expressions (pa + pb, pa.cwiseProduct(pb),
+// ...) on the calling thread only. At a few ns per software posit op,
+// large element-wise expressions are worth splitting across cores, so
+//
+//     eigen_posit::parallel(dst) = pa + pb;
+//
+// assigns through Eigen's own evaluators and assignment kernel, but in
+// chunks run on the posit thread pool (parallel.h). Linearly traversable
+// destinations are cut at cache-line boundaries so no two threads write the
+// same line; others are cut by whole columns (rows if row-major). Like
+// noalias(), the source must not read from dst. +=, -= work the same way.
+// The split is sized in posit multiplies, so only posit destinations take
+// it; nothing includes this header but code that asks for it.
+namespace eigen_posit
+{
+namespace detail
+{
+    template<typename Dst, typename Src, typename Func>
+    void parallel_assign(Dst& dst, const Src& src, const Func& func)
+    {
+        using namespace Eigen;
+        using namespace Eigen::internal;
+        typedef evaluator<Dst> DstEvaluator;
+        typedef evaluator<Src> SrcEvaluator;
+        typedef generic_dense_assignment_kernel<DstEvaluator, SrcEvaluator, Func> Kernel;
+        typedef copy_using_evaluator_traits<DstEvaluator, SrcEvaluator, Func> Traits;
+        typedef typename Traits::PacketType PacketType;
+        typedef typename Dst::Scalar Scalar;
+        constexpr Index packet = unpacket_traits<PacketType>::size;
+        constexpr bool linear = int(Traits::Traversal) == LinearVectorizedTraversal || int(Traits::Traversal) == LinearTraversal;
+
+        SrcEvaluator src_evaluator(src);
+        resize_if_allowed(dst, src, func);
+        DstEvaluator dst_evaluator(dst);
+        Kernel kernel(dst_evaluator, src_evaluator, func, dst.const_cast_derived());
+
+        // work per coefficient, in multiplies
+        double cost = std::max(1.0, double(SrcEvaluator::CoeffReadCost) / double(NumTraits<Scalar>::MulCost));
+
+        if constexpr (linear) {
+            const Index size = dst.size();
+            const Index line = std::max<Index>(1, 64 / Index(sizeof(Scalar)));
+            Index head{};
+            if constexpr (bool(has_direct_access<Dst>::ret))
+                head = std::min(size, first_aligned<64>(dst.data(), size));
+            parallel_slices(size - head, line, cost, [&](Index begin, Index end) {
+                begin = begin == 0 ? 0 : begin + head;
+                end += head;
+                Index i = begin;
+                if constexpr (int(Traits::Traversal) == LinearVectorizedTraversal)
+                    for (; i + packet <= end; i += packet)
+                        kernel.template assignPacket<Unaligned, Unaligned, PacketType>(i);
+                for (; i < end; ++i) kernel.assignCoeff(i);
+            });
+        } else {
+            const Index inner_size = dst.innerSize();
+            parallel_slices(dst.outerSize(), Index(1), cost * double(inner_size), [&](Index begin, Index end) {
+                for (Index outer = begin; outer < end; ++outer) {
+                    Index inner{};
+                    if constexpr (bool(Traits::Vectorized))
+                        for (; inner + packet <= inner_size; inner += packet)
+                            kernel.template assignPacketByOuterInner<Unaligned, Unaligned, PacketType>(outer, inner);
+                    for (; inner < inner_size; ++inner) kernel.assignCoeffByOuterInner(outer, inner);
+                }
+            });
+        }
+    }
+}
+
+    template<typename Dst>
+    class parallel_assignment
+    {
+        static_assert(detail::has_posit_costs<typename Dst::Scalar>::value,
+                      "eigen_posit::parallel: posit scalars only; its work threshold counts posit operations");
+
+    public:
+        explicit parallel_assignment(Dst& dst) : dst(dst) {}
+
+        template<typename Src>
+        Dst& operator=(const Eigen::DenseBase<Src>& src)
+        {
+            detail::parallel_assign(dst, src.derived(), Eigen::internal::assign_op<typename Dst::Scalar, typename Src::Scalar>());
+            return dst;
+        }
+
+        template<typename Src>
+        Dst& operator+=(const Eigen::DenseBase<Src>& src)
+        {
+            detail::parallel_assign(dst, src.derived(), Eigen::internal::add_assign_op<typename Dst::Scalar, typename Src::Scalar>());
+            return dst;
+        }
+
+        template<typename Src>
+        Dst& operator-=(const Eigen::DenseBase<Src>& src)
+        {
+            detail::parallel_assign(dst, src.derived(), Eigen::internal::sub_assign_op<typename Dst::Scalar, typename Src::Scalar>());
+            return dst;
+        }
+
+    private:
+        Dst& dst;
+    };
+
+    // Opt-in parallel assignment: eigen_posit::parallel(dst) = expr;
+    template<typename Dst>
+    parallel_assignment<Dst> parallel(Eigen::DenseBase<Dst>& dst)
+    {
+        return parallel_assignment<Dst>(dst.derived());
+    }
+
+    // Temporary destinations such as parallel(m.block(...)) = expr; the
+    // expression lives until the end of the statement, as the assignment does.
+    template<typename Dst>
+    parallel_assignment<Dst> parallel(Eigen::DenseBase<Dst>&& dst)
+    {
+        return parallel_assignment<Dst>(dst.derived());
+    }
+}
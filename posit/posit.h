@@ -0,0 +1,400 @@
+#pragma once
+
+#include "costs.h"
+#include <Eigen/Core>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+
+// Header-only posit<N, ES> scalar.
+//
+// SoftPosit's posit types call into libsoftposit for every operation, so the
+// compiler can neither inline nor vectorize through them, and their
+// constructors make Eigen initialize every coefficient. posit<N, ES> is a
+// trivially copyable wrapper around the raw bits with constexpr arithmetic
+// written out in integers: operands decode to a sign, a scale and a 63-bit
+// significand, add/sub/mul/div/sqrt run exactly (or with a sticky bit below
+// the rounding position), and the result rounds to nearest even once. The
+// bits and the rounding are the posit standard's, so posit<32, 2>,
+// posit<16, 1> and posit<8, 0> hold exactly the bits SoftPosit's posit32,
+// posit16 and posit8 hold and round the same way; from_bits()/bits() move
+// values between the two.
+namespace eigen_posit
+{
+namespace detail
+{
+    template<int N>
+    using posit_storage = std::conditional_t<(N <= 8), uint8_t, std::conditional_t<(N <= 16), uint16_t, uint32_t>>;
+
+    // value = sig * 2^(scale - 62), sig in [2^62, 2^63); bit 0 of sig may
+    // hold a sticky bit for anything cut off below it.
+    struct unpacked
+    {
+        bool negative;
+        int scale;
+        uint64_t sig;
+    };
+}
+
+    template<int N, int ES>
+    class posit
+    {
+        static_assert(N >= 3 && N <= 32, "posit: N must be in [3, 32]");
+        static_assert(ES >= 0 && ES <= N - 3, "posit: ES must be in [0, N - 3]");
+        static_assert(((N - 2) << ES) <= 1022, "posit: dynamic range must fit a double");
+
+    public:
+        typedef detail::posit_storage<N> storage;
+
+        static constexpr storage mask = storage(N == 32 ? ~uint32_t(0) : (uint32_t(1) << N) - 1);
+        static constexpr storage nar_bits = storage(uint32_t(1) << (N - 1));
+        static constexpr storage maxpos_bits = storage(nar_bits - 1);
+        static constexpr int max_scale = (N - 2) << ES;
+
+        storage value;
+
+        constexpr posit() = default;
+
+        constexpr posit(double x) : value(from_double(x)) {}
+
+        template<typename I, std::enable_if_t<std::is_integral_v<I>, int> = 0>
+        constexpr posit(I x) : value(from_integer(x)) {}
+
+        static constexpr posit from_bits(storage bits)
+        {
+            posit p;
+            p.value = storage(bits & mask);
+            return p;
+        }
+
+        constexpr storage bits() const { return value; }
+        constexpr bool isNaR() const { return value == nar_bits; }
+
+        // Exact: every posit<N, ES> is a double.
+        constexpr double toDouble() const
+        {
+            if (value == 0) return 0.0;
+            if (isNaR()) return std::numeric_limits<double>::quiet_NaN();
+            detail::unpacked u = unpack(value);
+            uint64_t mant = (u.sig >> 10) & ((uint64_t(1) << 52) - 1);
+            return std::bit_cast<double>(uint64_t(u.negative) << 63 | uint64_t(u.scale + 1023) << 52 | mant);
+        }
+
+        explicit constexpr operator double() const { return toDouble(); }
+        explicit constexpr operator float() const { return float(toDouble()); }
+
+        // Truncates toward zero; NaR and values outside I give I's minimum
+        // (its zero if unsigned), where a plain cast would be undefined.
+        template<typename I, std::enable_if_t<std::is_integral_v<I>, int> = 0>
+        explicit constexpr operator I() const
+        {
+            double x = toDouble();
+            if (!(x >= double(std::numeric_limits<I>::min()) && x < double(std::numeric_limits<I>::max()) + 1.0))
+                return std::numeric_limits<I>::min();
+            return I(x);
+        }
+
+        friend constexpr posit operator+(posit a, posit b) { return from_bits(add(a.value, b.value)); }
+        friend constexpr posit operator-(posit a, posit b) { return from_bits(add(a.value, storage(-b.value & mask))); }
+        friend constexpr posit operator*(posit a, posit b) { return from_bits(mul(a.value, b.value)); }
+        friend constexpr posit operator/(posit a, posit b) { return from_bits(div(a.value, b.value)); }
+        friend constexpr posit operator-(posit a) { return from_bits(storage(-a.value)); }
+        friend constexpr posit operator+(posit a) { return a; }
+
+        constexpr posit& operator+=(posit b) { return *this = *this + b; }
+        constexpr posit& operator-=(posit b) { return *this = *this - b; }
+        constexpr posit& operator*=(posit b) { return *this = *this * b; }
+        constexpr posit& operator/=(posit b) { return *this = *this / b; }
+
+        // Bits compare as two's complement integers, NaR below every real and
+        // equal to itself, like SoftPosit.
+        friend constexpr bool operator==(posit a, posit b) { return a.value == b.value; }
+        friend constexpr bool operator!=(posit a, posit b) { return a.value != b.value; }
+        friend constexpr bool operator<(posit a, posit b) { return a.ordered() < b.ordered(); }
+        friend constexpr bool operator<=(posit a, posit b) { return a.ordered() <= b.ordered(); }
+        friend constexpr bool operator>(posit a, posit b) { return a.ordered() > b.ordered(); }
+        friend constexpr bool operator>=(posit a, posit b) { return a.ordered() >= b.ordered(); }
+
+        friend constexpr posit abs(posit a) { return a.ordered() < 0 && !a.isNaR() ? -a : a; }
+        friend constexpr posit sqrt(posit a) { return from_bits(root(a.value)); }
+        friend constexpr bool isnan(posit a) { return a.isNaR(); }
+        friend constexpr bool isinf(posit) { return false; }
+        friend constexpr bool isfinite(posit a) { return !a.isNaR(); }
+
+        friend std::ostream& operator<<(std::ostream& out, posit a) { return out << a.toDouble(); }
+
+    private:
+        constexpr int32_t ordered() const { return int32_t(uint32_t(value) << (32 - N)); }
+
+        static constexpr detail::unpacked unpack(storage bits)
+        {
+            uint64_t x = uint64_t(bits) << (64 - N);
+            bool negative = x >> 63;
+            if (negative) x = 0 - x;
+            uint64_t body = x << 1;
+            uint64_t inv = uint64_t(int64_t(body) >> 63);
+            int lz = std::countl_zero(body ^ inv);
+            int k = inv ? lz - 1 : -lz;
+            uint64_t rest = lz + 1 < 64 ? body << (lz + 1) : 0;
+            int e = ES ? int(rest >> (64 - ES)) : 0;
+            uint64_t frac = rest << ES;
+            return { negative, k * (1 << ES) + e, uint64_t(1) << 62 | frac >> 2 };
+        }
+
+        // Rounds to nearest even; never to zero or NaR.
+        static constexpr storage pack(detail::unpacked u)
+        {
+            uint64_t body;
+            if (u.scale >= max_scale) body = maxpos_bits;
+            else if (u.scale < -max_scale) body = 1;
+            else {
+                int k = u.scale >> ES;
+                int e = u.scale & ((1 << ES) - 1);
+                int r = k >= 0 ? k + 2 : 1 - k;
+                uint64_t frac = u.sig << 2;
+                uint64_t tail = ES ? uint64_t(e) << (64 - ES) | frac >> ES : frac;
+                bool sticky = ES ? (frac << (64 - ES)) != 0 : false;
+                uint64_t regime = k >= 0 ? ~uint64_t(0) << (63 - k) : uint64_t(1) << (63 + k);
+                uint64_t full = regime | tail >> r;
+                sticky = sticky || (tail << (64 - r)) != 0 || (full & ((uint64_t(1) << (64 - N)) - 1)) != 0;
+                bool round = (full >> (64 - N)) & 1;
+                body = full >> (65 - N);
+                if (round && (sticky || (body & 1))) ++body;
+            }
+            return storage((u.negative ? 0 - body : body) & mask);
+        }
+
+        static constexpr storage from_double(double x)
+        {
+            uint64_t bits = std::bit_cast<uint64_t>(x);
+            bool negative = bits >> 63;
+            int biased = int((bits >> 52) & 0x7FF);
+            if ((bits << 1) == 0) return 0;
+            if (biased == 0x7FF) return nar_bits;
+            // subnormals are far below minpos
+            if (biased == 0) return storage((negative ? 0u - 1u : 1u) & mask);
+            return pack({ negative, biased - 1023, uint64_t(1) << 62 | (bits & ((uint64_t(1) << 52) - 1)) << 10 });
+        }
+
+        template<typename I>
+        static constexpr storage from_integer(I x)
+        {
+            if (x == 0) return 0;
+            bool negative = std::is_signed_v<I> && x < 0;
+            uint64_t m = negative ? 0 - uint64_t(x) : uint64_t(x);
+            int lz = std::countl_zero(m);
+            uint64_t sig = lz ? m << (lz - 1) : (m >> 1 | (m & 1));
+            return pack({ negative, 63 - lz, sig });
+        }
+
+        static constexpr storage add(storage a, storage b)
+        {
+            if (a == nar_bits || b == nar_bits) return nar_bits;
+            if (a == 0) return b;
+            if (b == 0) return a;
+            detail::unpacked x = unpack(a), y = unpack(b);
+            if (x.scale < y.scale || (x.scale == y.scale && x.sig < y.sig)) std::swap(x, y);
+
+            int shift = x.scale - y.scale;
+            uint64_t aligned = shift >= 63 ? 1 : shift ? (y.sig >> shift) | ((y.sig << (64 - shift)) != 0) : y.sig;
+            if (x.negative == y.negative) {
+                x.sig += aligned;
+                if (x.sig >> 63) {
+                    x.sig = (x.sig >> 1) | (x.sig & 1);
+                    ++x.scale;
+                }
+            } else {
+                x.sig -= aligned;
+                if (x.sig == 0) return 0;
+                int lz = std::countl_zero(x.sig) - 1;
+                x.sig <<= lz;
+                x.scale -= lz;
+            }
+            return pack(x);
+        }
+
+        // Significands carry at most 30 bits, so they multiply and divide
+        // exactly in 64-bit integers once shifted down by 32.
+        static constexpr storage mul(storage a, storage b)
+        {
+            if (a == nar_bits || b == nar_bits) return nar_bits;
+            if (a == 0 || b == 0) return 0;
+            detail::unpacked x = unpack(a), y = unpack(b);
+            uint64_t p = (x.sig >> 32) * (y.sig >> 32);
+            bool carry = p >> 61;
+            return pack({ x.negative != y.negative, x.scale + y.scale + carry, p << (carry ? 1 : 2) });
+        }
+
+        static constexpr storage div(storage a, storage b)
+        {
+            if (a == nar_bits || b == nar_bits || b == 0) return nar_bits;
+            if (a == 0) return 0;
+            detail::unpacked x = unpack(a), y = unpack(b);
+            uint64_t n = (x.sig >> 32) << 32;
+            uint64_t d = y.sig >> 32;
+            uint64_t q = n / d;
+            bool inexact = n % d != 0;
+            bool carry = q >> 32;
+            return pack({ x.negative != y.negative, x.scale - y.scale - !carry, q << (carry ? 30 : 31) | inexact });
+        }
+
+        static constexpr storage root(storage a)
+        {
+            if (a == 0 || a == nar_bits) return a;
+            detail::unpacked x = unpack(a);
+            if (x.negative) return nar_bits;
+            // an even scale halves exactly; m in [2^62, 2^64)
+            bool odd = x.scale & 1;
+            uint64_t m = x.sig << odd;
+            uint64_t r{}, rem = m;
+            for (uint64_t bit = uint64_t(1) << 62; bit; bit >>= 2) {
+                if (rem >= r + bit) {
+                    rem -= r + bit;
+                    r = (r >> 1) + bit;
+                } else
+                    r >>= 1;
+            }
+            return pack({ false, (x.scale - odd) / 2, r << 31 | (rem != 0) });
+        }
+    };
+
+namespace detail
+{
+    template<typename Self>
+    Self with_bits(uint64_t bits)
+    {
+        Self p{};
+        p.value = decltype(p.value)(bits);
+        return p;
+    }
+
+    constexpr op_costs header_costs(int n) { return n <= 8 ? costs::header8 : n <= 16 ? costs::header16 : costs::header32; }
+
+    // NumTraits for any posit type with N bits, ES exponent bits and its bits
+    // in a public `value` member: SoftPosit's posit8/16/32 and posit<N, ES>.
+    // Operation costs come from costs.h.
+    template<typename Posit, int N, int ES, op_costs Costs>
+    struct posit_num_traits
+    {
+        using Self = Posit;
+        using Real = Posit;
+        using NonInteger = Posit;
+        using Nested = Posit;
+        using Literal = float;
+
+        enum {
+            IsComplex = 0,
+            IsInteger = 0,
+            IsSigned = 1,
+            RequireInitialization = !std::is_trivially_default_constructible_v<Posit>,
+            ReadCost = 1,
+            AddCost = Costs.add,
+            MulCost = Costs.mul
+        };
+
+        static constexpr op_costs posit_costs = Costs;
+
+        // significand bits at 1.0, hidden bit included
+        static constexpr int digits() { return N - 2 - ES; }
+        static constexpr int digits10() { return int((N - 3 - ES) * 0.30103); }
+
+        static inline Real epsilon() { return Real(1.0 / double(uint64_t(1) << (N - 3 - ES))); }
+        static inline Real dummy_precision() { return std::max(epsilon(), Real(1e-5)); }
+        static inline Real highest() { return with_bits<Posit>((uint64_t(1) << (N - 1)) - 1); }
+        static inline Real lowest() { return -highest(); }
+        // Posits have no infinity; maxpos stands in for it, as in rcond(),
+        // where a singular factor's reciprocal norm is infinite.
+        static inline Real infinity() { return highest(); }
+        static inline Real quiet_NaN() { return with_bits<Posit>(uint64_t(1) << (N - 1)); }
+    };
+
+    template<typename T, typename = void>
+    struct has_posit_costs : std::false_type {};
+
+    template<typename T>
+    struct has_posit_costs<T, std::void_t<decltype(Eigen::NumTraits<T>::posit_costs)>> : std::true_type {};
+
+    template<typename Posit, bool Packet = false>
+    struct posit_sqrt_traits
+    {
+        enum { Cost = Eigen::NumTraits<Posit>::posit_costs.sqrt, PacketAccess = Packet };
+    };
+
+    template<typename Posit>
+    struct posit_cast_traits
+    {
+        enum { Cost = Eigen::NumTraits<Posit>::posit_costs.convert, PacketAccess = false };
+    };
+}
+}
+
+namespace Eigen
+{
+    template<int N, int ES>
+    struct NumTraits<eigen_posit::posit<N, ES>>
+        : eigen_posit::detail::posit_num_traits<eigen_posit::posit<N, ES>, N, ES, eigen_posit::detail::header_costs(N)> {};
+
+namespace internal
+{
+    // Eigen prices a division at 8 multiplies and a square root from the
+    // float instruction; posits use their measured costs instead.
+    template<typename T, bool Vectorized>
+    struct scalar_div_cost<T, Vectorized, std::enable_if_t<eigen_posit::detail::has_posit_costs<T>::value>>
+    {
+        enum { value = NumTraits<T>::posit_costs.div };
+    };
+
+    template<int N, int ES>
+    struct functor_traits<scalar_sqrt_op<eigen_posit::posit<N, ES>>> : eigen_posit::detail::posit_sqrt_traits<eigen_posit::posit<N, ES>> {};
+
+    template<int N, int ES>
+    struct functor_traits<scalar_cast_op<eigen_posit::posit<N, ES>, float>> : eigen_posit::detail::posit_cast_traits<eigen_posit::posit<N, ES>> {};
+    template<int N, int ES>
+    struct functor_traits<scalar_cast_op<eigen_posit::posit<N, ES>, double>> : eigen_posit::detail::posit_cast_traits<eigen_posit::posit<N, ES>> {};
+    template<int N, int ES>
+    struct functor_traits<scalar_cast_op<float, eigen_posit::posit<N, ES>>> : eigen_posit::detail::posit_cast_traits<eigen_posit::posit<N, ES>> {};
+    template<int N, int ES>
+    struct functor_traits<scalar_cast_op<double, eigen_posit::posit<N, ES>>> : eigen_posit::detail::posit_cast_traits<eigen_posit::posit<N, ES>> {};
+}
+}
+
+namespace std
+{
+    template<int N, int ES>
+    class numeric_limits<eigen_posit::posit<N, ES>>
+    {
+        typedef eigen_posit::posit<N, ES> P;
+
+    public:
+        static constexpr bool is_specialized = true;
+        static constexpr bool is_signed = true;
+        static constexpr bool is_integer = false;
+        static constexpr bool is_exact = false;
+        static constexpr bool has_infinity = false;
+        static constexpr bool has_quiet_NaN = true;
+        static constexpr bool has_signaling_NaN = false;
+        static constexpr bool is_iec559 = false;
+        static constexpr bool is_bounded = true;
+        static constexpr bool is_modulo = false;
+        static constexpr float_round_style round_style = round_to_nearest;
+        static constexpr int radix = 2;
+        static constexpr int digits = N - 2 - ES;
+        static constexpr int digits10 = int((N - 3 - ES) * 0.30103);
+        static constexpr int max_digits10 = int(digits * 0.30103) + 2;
+        static constexpr int min_exponent = -P::max_scale + 1;
+        static constexpr int max_exponent = P::max_scale + 1;
+
+        static constexpr P min() noexcept { return P::from_bits(1); }
+        static constexpr P max() noexcept { return P::from_bits(P::maxpos_bits); }
+        static constexpr P lowest() noexcept { return -max(); }
+        static constexpr P epsilon() noexcept { return P(1.0 / double(uint64_t(1) << (N - 3 - ES))); }
+        static constexpr P round_error() noexcept { return P(0.5); }
+        static constexpr P quiet_NaN() noexcept { return P::from_bits(P::nar_bits); }
+        static constexpr P infinity() noexcept { return P::from_bits(P::nar_bits); }
+        static constexpr P denorm_min() noexcept { return min(); }
+    };
+}
@@ -0,0 +1,483 @@
+#pragma once
+
+#include "gemm.h"
+#include "lu.h"
+#include "packet_math.h"
+#include "parallel.h"
+#include "quire.h"
+#include "redux.h"
+#include <Eigen/QR>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Householder QR factorizations of posit32 matrices and their least-squares
+// solves.
+//
+// Eigen's HouseholderQR is blocked, but it factors each panel and builds the
+// block reflector's triangular factor T one rounded operation at a time, and
+// ColPivHouseholderQR is not blocked at all: every reflector reaches the
+// whole trailing matrix as a matrix-vector product and a rank-one update,
+// with a SoftPosit call for each coefficient off a packet boundary. Here both
+// work in panels of qr_block columns and update the trailing matrix in the
+// compact WY form through the quire GEMM (gemm.h) and its threads:
+// A -= V T^T V^T A for HouseholderQR, A -= V F^T for ColPivHouseholderQR,
+// whose F accumulates the panel's reflectors applied to the trailing columns
+// as in LAPACK's xGEQP3. Within a panel every coefficient is one quire. A
+// HouseholderQR column takes all of the panel's earlier reflectors at once,
+// left-looking, before its own reflector is made. beta is the square root of
+// the column's exact sum of squares and tau = (beta - x0) / beta, each
+// rounded once. ColPivHouseholderQR keeps Eigen's pivoting on the updated
+// column norms and its norm downdate; as in LAPACK, a panel ends early when a
+// norm has to be computed afresh.
+//
+// solve() applies Q^T to the decoded right-hand sides one reflector at a
+// time, each dot product in the quire and each update rounded as in lu.h,
+// then solves with R through lu.h's triangular solves. For a tall matrix of
+// full column rank that is the least-squares solution. The factorizations
+// cover Matrix<posit32, Dynamic, Dynamic>, and HouseholderQR any posit32
+// matrix with unit inner stride; the solves cover both decompositions of
+// Matrix<posit32, Dynamic, Dynamic>.
+namespace eigen_posit
+{
+namespace detail
+{
+    // Columns per panel; a panel keeps a quire per column for its dot products.
+    constexpr Eigen::Index qr_block = 32;
+
+    // sum of x[i] v[i] over [from, to), x as bits and v unpacked
+    inline p32_quire qr_dot(const uint32_t* x, const p32_unpacked* v, Eigen::Index from, Eigen::Index to)
+    {
+        p32_quire q;
+        for (Eigen::Index i = from; i < to; ++i) {
+            q.nar |= x[i] == p32_nar;
+            q.add_product(p32_unpack(x[i]), v[i]);
+        }
+        return q;
+    }
+
+    inline uint32_t qr_norm(const uint32_t* x, Eigen::Index n)
+    {
+        p32_quire q;
+        for (Eigen::Index i{}; i < n; ++i) q.add_product(x[i], x[i]);
+        return q.to_posit_sqrt();
+    }
+
+    // Eigen's makeHouseholderInPlace on the n posit32 bits at x: x[0] becomes
+    // beta and x[1, n) the essential part; returns tau. beta, the square root
+    // of the exact sum of squares, and tau = (beta - x0) / beta round once.
+    inline uint32_t qr_reflector(uint32_t* x, Eigen::Index n)
+    {
+        p32_quire q;
+        bool zero = true;
+        for (Eigen::Index i = 1; i < n; ++i) {
+            q.add_product(x[i], x[i]);
+            zero = zero && x[i] == 0;
+        }
+        // Eigen leaves a zero tail, or a NaR one, whose norm compares below
+        // zero, as the identity
+        if (zero || q.nar) {
+            std::fill(x + 1, x + n, 0u);
+            return 0;
+        }
+        uint32_t c0 = x[0];
+        q.add_product(c0, c0);
+        uint32_t beta = q.to_posit_sqrt();
+        if (int32_t(c0) >= 0) beta = 0u - beta;
+        uint32_t d = p32_sub(c0, beta);
+        for (Eigen::Index i = 1; i < n; ++i) x[i] = p32_div(x[i], d);
+        p32_quire tau;
+        tau.add(beta);
+        tau.add(0u - c0);
+        x[0] = beta;
+        return tau.to_posit_divided(p32_to_double(beta));
+    }
+
+    // A panel of HouseholderQR, rows x cols with cols <= qr_block.
+    struct qr_panel
+    {
+        Eigen::Index rows{};
+        Eigen::Index cols{};
+        // column-major bits: R on and above the diagonal, V's essential parts below
+        std::vector<uint32_t> a;
+        // V row by row for the quires, v[i * qr_block + j] = V(i, j): ones on
+        // the diagonal, zeros above it
+        std::vector<p32_unpacked> v;
+        // column-major upper triangle with H_0 ... H_{cols - 1} = I - V T V^T
+        std::vector<uint32_t> t;
+        std::vector<uint32_t> tau;
+        // any NaR in V or T
+        bool nar{};
+
+        qr_panel(Eigen::Index rows, Eigen::Index cols)
+            : rows(rows), cols(cols), a(std::size_t(rows * cols)), v(std::size_t(rows * qr_block)), t(std::size_t(cols * cols)),
+              tau(std::size_t(cols))
+        {
+        }
+    };
+
+    // out[j] = sum over rows i in [from, rows) of V(i, j) x[i] for j < count,
+    // the rows split across threads
+    inline void qr_dots(const qr_panel& p, Eigen::Index from, Eigen::Index count, const p32_unpacked* x, p32_quire* out)
+    {
+        using Eigen::Index;
+        for (Index j{}; j < count; ++j) out[j].clear();
+        std::mutex merge;
+        parallel_slices(p.rows - from, Index(64), 4.0 * double(count), [&](Index begin, Index end) {
+            std::array<p32_quire, qr_block> q;
+            for (Index i = from + begin; i < from + end; ++i) {
+                const p32_unpacked* row = p.v.data() + i * qr_block;
+                for (Index j{}; j < count; ++j) q[j].add_product(row[j], x[i]);
+            }
+            std::lock_guard<std::mutex> lock(merge);
+            for (Index j{}; j < count; ++j) out[j].add(q[j]);
+        });
+    }
+
+    // Factors the panel left-looking: column c first takes the reflectors of
+    // columns 0 to c - 1 at once, x -= V T^T V^T x, then makes its own
+    // reflector, and column c of T follows from V^T v_c.
+    inline void qr_factor_panel(qr_panel& p)
+    {
+        using Eigen::Index;
+        const Index rows = p.rows;
+        std::vector<p32_unpacked> x(static_cast<std::size_t>(rows));
+        std::array<p32_quire, qr_block> z;
+        std::array<uint32_t, qr_block> zb;
+        std::array<p32_unpacked, qr_block> y;
+        auto t = [&](Index r, Index c) { return p.t[std::size_t(c * p.cols + r)]; };
+        for (Index c{}; c < p.cols; ++c) {
+            uint32_t* col = p.a.data() + c * rows;
+            if (c > 0 && (p.nar || std::find(col, col + rows, p32_nar) != col + rows)) {
+                std::fill(col, col + rows, p32_nar);
+            }
+            else if (c > 0) {
+                for (Index i{}; i < rows; ++i) x[i] = p32_unpack(col[i]);
+                qr_dots(p, 0, c, x.data(), z.data());
+                for (Index j{}; j < c; ++j) zb[j] = z[j].to_posit();
+                // y = -T^T V^T x
+                for (Index j{}; j < c; ++j) {
+                    p32_quire q;
+                    for (Index r{}; r <= j; ++r) q.add_product(t(r, j), zb[r]);
+                    y[j] = p32_unpack(0u - q.to_posit());
+                }
+                parallel_slices(rows, Index(64), 4.0 * double(c), [&](Index begin, Index end) {
+                    for (Index i = begin; i < end; ++i) {
+                        const p32_unpacked* row = p.v.data() + i * qr_block;
+                        p32_quire q;
+                        q.add(col[i]);
+                        for (Index j{}, last = std::min(c, i + 1); j < last; ++j) q.add_product(row[j], y[j]);
+                        col[i] = q.to_posit();
+                    }
+                });
+            }
+
+            uint32_t tau = p.tau[c] = qr_reflector(col + c, rows - c);
+            p.nar |= tau == p32_nar;
+            for (Index i = c; i < rows; ++i) {
+                p.nar |= i > c && col[i] == p32_nar;
+                p.v[i * qr_block + c] = p32_unpack(i == c ? p32_one : col[i]);
+            }
+
+            // T(0:c, c) = -tau T(0:c, 0:c) V(:, 0:c)^T v_c
+            if (c > 0) {
+                for (Index i = c; i < rows; ++i) x[i] = p.v[i * qr_block + c];
+                qr_dots(p, c, c, x.data(), z.data());
+                for (Index j{}; j < c; ++j) zb[j] = z[j].to_posit();
+                for (Index r{}; r < c; ++r) {
+                    p32_quire q;
+                    for (Index j = r; j < c; ++j) q.add_product(t(r, j), zb[j]);
+                    p.t[c * p.cols + r] = p32_mul(0u - tau, q.to_posit());
+                }
+            }
+            p.t[c * p.cols + c] = tau;
+        }
+    }
+
+    // householder_qr_inplace_blocked: each panel factored as above, then the
+    // columns right of it updated A -= V T^T V^T A, one GEMM per product.
+    template<typename MatrixQR, typename HCoeffs>
+    void householder_qr(MatrixQR& mat, HCoeffs& h_coeffs, Eigen::Index max_block)
+    {
+        using Eigen::Index;
+        typedef Eigen::Matrix<posit32, Eigen::Dynamic, Eigen::Dynamic> Matrix;
+        const Index rows = mat.rows(), cols = mat.cols(), size = std::min(rows, cols);
+        const Index block = std::max<Index>(1, std::min(max_block, qr_block));
+        for (Index k{}; k < size; k += block) {
+            Index bs = std::min(block, size - k), m = rows - k, trailing = cols - k - bs;
+            qr_panel p(m, bs);
+            for (Index j{}; j < bs; ++j)
+                for (Index i{}; i < m; ++i) p.a[j * m + i] = mat.coeff(k + i, k + j).value;
+            qr_factor_panel(p);
+            for (Index j{}; j < bs; ++j) {
+                for (Index i{}; i < m; ++i) mat.coeffRef(k + i, k + j) = p32_from_bits(p.a[j * m + i]);
+                h_coeffs.coeffRef(k + j) = p32_from_bits(p.tau[j]);
+            }
+            if (trailing == 0) continue;
+
+            Matrix v(m, bs), t(bs, bs);
+            for (Index j{}; j < bs; ++j) {
+                for (Index i{}; i < m; ++i) v(i, j) = p32_from_bits(i < j ? 0u : i == j ? p32_one : p.a[j * m + i]);
+                for (Index r{}; r < bs; ++r) t(r, j) = p32_from_bits(r <= j ? p.t[j * bs + r] : 0u);
+            }
+            auto a22 = mat.block(k, k + bs, m, trailing);
+            Matrix w(bs, trailing), tw(bs, trailing);
+            w.noalias() = v.transpose() * a22;
+            tw.noalias() = t.transpose() * w;
+            a22.noalias() -= v * tw;
+        }
+    }
+
+    // Eigen's column norm downdate once the pivot row of column c is final;
+    // true when the norm has to be computed afresh.
+    inline bool qr_downdate(uint32_t pivot_row, uint32_t& updated, uint32_t direct, double threshold)
+    {
+        if (updated == 0) return false;
+        double norm = p32_to_double(updated);
+        double ratio = std::fabs(p32_to_double(pivot_row)) / norm;
+        double temp = std::max(0.0, (1.0 + ratio) * (1.0 - ratio));
+        double drift = norm / p32_to_double(direct);
+        if (temp * drift * drift <= threshold) return true;
+        updated = p32_from_double(norm * std::sqrt(temp));
+        return false;
+    }
+
+    // ColPivHouseholderQR::computeInPlace, blocked as xGEQP3. Step j of the
+    // panel from column k pivots, brings the pivot column up to date,
+    // A(rk:, rk) -= V F(rk, :)^T, makes its reflector v, and appends column j
+    // of F = tau (A^T v - F V^T v) for the columns right of it; row rk of
+    // those columns is then brought up to date and their norms downdated. The
+    // rows below the panel wait for A -= V F^T.
+    template<typename HCoeffs, typename Transpositions, typename Permutation, typename Norms>
+    void colpiv_householder_qr(Eigen::Matrix<posit32, Eigen::Dynamic, Eigen::Dynamic>& qr, HCoeffs& h_coeffs,
+                               Transpositions& transpositions, Permutation& permutation, Norms& norms_updated,
+                               Norms& norms_direct, posit32& max_pivot, Eigen::Index& nonzero_pivots, Eigen::Index& det_pq)
+    {
+        using Eigen::Index;
+        typedef Eigen::Matrix<posit32, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrix;
+        const Index rows = qr.rows(), cols = qr.cols(), size = std::min(rows, cols);
+        uint32_t* a = reinterpret_cast<uint32_t*>(qr.data());
+        h_coeffs.resize(size);
+        transpositions.resize(cols);
+
+        std::vector<uint32_t> updated(cols), direct(cols);
+        parallel_slices(cols, Index(1), 4.0 * double(rows), [&](Index begin, Index end) {
+            for (Index c = begin; c < end; ++c) direct[c] = updated[c] = qr_norm(a + c * rows, rows);
+        });
+        // Eigen's rank threshold and downdate tolerance, in double
+        double eps = p32_to_double(Eigen::NumTraits<posit32>::epsilon().value);
+        double largest = cols > 0 ? p32_to_double(*std::max_element(updated.begin(), updated.end(), [](uint32_t x, uint32_t y) {
+            return int32_t(x) < int32_t(y);
+        })) : 0.0;
+        double rank_threshold = largest * eps * largest * eps / double(rows);
+        double downdate_threshold = std::sqrt(eps);
+
+        nonzero_pivots = size;
+        uint32_t biggest_pivot{};
+        Index swaps{};
+        // F row by row, f[(c - k) * qr_block + j] = F(c, j)
+        std::vector<uint32_t> f;
+        std::vector<char> stale(cols);
+        std::vector<p32_unpacked> v(rows);
+        std::array<uint32_t, qr_block> s;
+        for (Index k{}; k < size;) {
+            Index nb = std::min(qr_block, size - k);
+            f.assign(std::size_t((cols - k) * qr_block), 0u);
+            Index j{};
+            for (bool restart{}; j < nb && !restart; ++j) {
+                Index rk = k + j;
+                // the first column of largest updated norm; NaR orders lowest
+                Index p = rk;
+                for (Index c = rk + 1; c < cols; ++c)
+                    if (int32_t(updated[c]) > int32_t(updated[p])) p = c;
+                double norm = p32_to_double(updated[p]);
+                if (nonzero_pivots == size && norm * norm < rank_threshold * double(rows - rk)) nonzero_pivots = rk;
+                transpositions.coeffRef(rk) = typename Transpositions::Scalar(p);
+                if (p != rk) {
+                    std::swap_ranges(a + rk * rows, a + (rk + 1) * rows, a + p * rows);
+                    std::swap_ranges(f.begin() + (rk - k) * qr_block, f.begin() + (rk - k + 1) * qr_block, f.begin() + (p - k) * qr_block);
+                    std::swap(updated[rk], updated[p]);
+                    std::swap(direct[rk], direct[p]);
+                    ++swaps;
+                }
+
+                uint32_t* col = a + rk * rows;
+                if (j > 0) {
+                    const uint32_t* frow = f.data() + (rk - k) * qr_block;
+                    parallel_slices(rows - rk, Index(64), 4.0 * double(j), [&](Index begin, Index end) {
+                        for (Index i = rk + begin; i < rk + end; ++i) {
+                            p32_quire q;
+                            q.add(col[i]);
+                            for (Index jj{}; jj < j; ++jj) q.sub_product(a[(k + jj) * rows + i], frow[jj]);
+                            col[i] = q.to_posit();
+                        }
+                    });
+                }
+
+                uint32_t tau = qr_reflector(col + rk, rows - rk);
+                h_coeffs.coeffRef(rk) = p32_from_bits(tau);
+                uint32_t sign = uint32_t(int32_t(col[rk]) >> 31), magnitude = (col[rk] ^ sign) - sign;
+                if (int32_t(magnitude) > int32_t(biggest_pivot)) biggest_pivot = magnitude;
+
+                bool v_nar = tau == p32_nar;
+                for (Index i = rk; i < rows; ++i) {
+                    v_nar |= i > rk && col[i] == p32_nar;
+                    v[i] = p32_unpack(i == rk ? p32_one : col[i]);
+                }
+                // s = V^T v over the panel's earlier reflectors
+                for (Index jj{}; jj < j; ++jj) {
+                    p32_quire q = qr_dot(a + (k + jj) * rows, v.data(), rk, rows);
+                    q.nar |= v_nar;
+                    s[jj] = q.to_posit();
+                }
+
+                parallel_slices(cols - rk - 1, Index(8), 4.0 * double(rows - rk + 2 * j), [&](Index begin, Index end) {
+                    for (Index c = rk + 1 + begin; c < rk + 1 + end; ++c) {
+                        uint32_t* fc = f.data() + (c - k) * qr_block;
+                        uint32_t* ac = a + c * rows;
+                        p32_quire q = qr_dot(ac, v.data(), rk, rows);
+                        q.nar |= v_nar;
+                        for (Index jj{}; jj < j; ++jj) q.sub_product(fc[jj], s[jj]);
+                        fc[j] = p32_mul(tau, q.to_posit());
+
+                        p32_quire r;
+                        r.add(ac[rk]);
+                        for (Index jj{}; jj < j; ++jj) r.sub_product(a[(k + jj) * rows + rk], fc[jj]);
+                        r.sub_product(p32_one, fc[j]);
+                        ac[rk] = r.to_posit();
+                        stale[c] = qr_downdate(ac[rk], updated[c], direct[c], downdate_threshold);
+                    }
+                });
+                restart = std::find(stale.begin() + rk + 1, stale.end(), 1) != stale.end();
+            }
+
+            Index below = rows - k - j, right = cols - k - j;
+            if (below > 0 && right > 0) {
+                Eigen::Map<const RowMatrix, 0, Eigen::OuterStride<>> fm(reinterpret_cast<const posit32*>(f.data()) + j * qr_block, right, j,
+                                                                        Eigen::OuterStride<>(qr_block));
+                qr.bottomRightCorner(below, right).noalias() -= qr.block(k + j, k, below, j) * fm.transpose();
+            }
+            for (Index c = k + j; c < cols; ++c) {
+                if (!stale[c]) continue;
+                direct[c] = updated[c] = qr_norm(a + c * rows + k + j, below);
+                stale[c] = 0;
+            }
+            k += j;
+        }
+
+        norms_updated.resize(cols);
+        norms_direct.resize(cols);
+        for (Index c{}; c < cols; ++c) {
+            norms_updated.coeffRef(c) = p32_from_bits(updated[c]);
+            norms_direct.coeffRef(c) = p32_from_bits(direct[c]);
+        }
+        max_pivot = p32_from_bits(biggest_pivot);
+        permutation.setIdentity(cols);
+        for (Index c{}; c < size; ++c) permutation.applyTranspositionOnTheRight(c, transpositions.coeff(c));
+        det_pq = swaps % 2 ? -1 : 1;
+    }
+
+    // Q^T c for the first `length` reflectors of dec, one column of c per
+    // thread: w = v^T x in the quire, then x -= v (tau w), each product and
+    // difference rounded.
+    template<typename QR>
+    void apply_householder_transpose(const QR& dec, Eigen::Matrix<posit32, Eigen::Dynamic, Eigen::Dynamic>& c, Eigen::Index length)
+    {
+        using Eigen::Index;
+        const auto& qr = dec.matrixQR();
+        const auto& h_coeffs = dec.hCoeffs();
+        const Index rows = qr.rows();
+        parallel_slices(c.cols(), Index(1), 8.0 * double(rows) * double(length), [&](Index begin, Index end) {
+            std::vector<double> x(rows), v(rows);
+            const double one = 1.0;
+            for (Index j = begin; j < end; ++j) {
+                for (Index i{}; i < rows; ++i) x[i] = p32_to_double(c(i, j).value);
+                for (Index k{}; k < length; ++k) {
+                    uint32_t tau = h_coeffs.coeff(k).value;
+                    if (tau == 0) continue;
+                    p32_quire q;
+                    q.nar = tau == p32_nar || x[k] != x[k];
+                    q.add_product(p32_unpack_decoded(x[k]), p32_unpack(p32_one));
+                    for (Index i = k + 1; i < rows; ++i) {
+                        v[i] = p32_to_double(qr.coeff(i, k).value);
+                        q.nar |= v[i] != v[i] || x[i] != x[i];
+                        q.add_product(p32_unpack_decoded(v[i]), p32_unpack_decoded(x[i]));
+                    }
+                    double t = p32_to_double(p32_mul(tau, q.to_posit()));
+                    lu_update<posit32>(&x[k], &one, t, 1);
+                    lu_update<posit32>(x.data() + k + 1, v.data() + k + 1, t, rows - k - 1);
+                }
+                for (Index i{}; i < rows; ++i) c(i, j) = p32_from_bits(p32_from_double(x[i]));
+            }
+        });
+    }
+
+    // The first `rank` rows of R^-1 Q^T b, as Eigen's QR solves compute them.
+    template<typename QR, typename Rhs>
+    Eigen::Matrix<posit32, Eigen::Dynamic, Eigen::Dynamic> qr_solve(const QR& dec, Eigen::Index rank, const Rhs& rhs)
+    {
+        Eigen::Matrix<posit32, Eigen::Dynamic, Eigen::Dynamic> c = rhs;
+        apply_householder_transpose(dec, c, rank);
+        dec.matrixQR().topLeftCorner(rank, rank).template triangularView<Eigen::Upper>().solveInPlace(c.topRows(rank));
+        return c;
+    }
+}
+}
+
+namespace Eigen
+{
+namespace internal
+{
+    // Unit inner stride, as Eigen's own blocked path; anything else keeps Eigen's.
+    template<typename MatrixQR, typename HCoeffs>
+    struct householder_qr_inplace_blocked<MatrixQR, HCoeffs, posit32, true>
+    {
+        static void run(MatrixQR& mat, HCoeffs& hCoeffs, Index maxBlockSize = 32, posit32* /*tempData*/ = 0)
+        {
+            eigen_posit::detail::householder_qr(mat, hCoeffs, maxBlockSize);
+        }
+    };
+
+    template<typename DstXprType, typename RhsType>
+    struct Assignment<DstXprType, Solve<HouseholderQR<Matrix<posit32, Dynamic, Dynamic>>, RhsType>, assign_op<posit32, posit32>, Dense2Dense>
+    {
+        typedef Solve<HouseholderQR<Matrix<posit32, Dynamic, Dynamic>>, RhsType> SrcXprType;
+
+        static void run(DstXprType& dst, const SrcXprType& src, const assign_op<posit32, posit32>&)
+        {
+            const Index cols = src.dec().cols(), rank = std::min(src.dec().rows(), cols);
+            Matrix<posit32, Dynamic, Dynamic> c = eigen_posit::detail::qr_solve(src.dec(), rank, src.rhs());
+            if (dst.rows() != cols || dst.cols() != c.cols()) dst.resize(cols, c.cols());
+            dst.topRows(rank) = c.topRows(rank);
+            dst.bottomRows(cols - rank).setZero();
+        }
+    };
+
+    template<typename DstXprType, typename RhsType>
+    struct Assignment<DstXprType, Solve<ColPivHouseholderQR<Matrix<posit32, Dynamic, Dynamic>>, RhsType>, assign_op<posit32, posit32>, Dense2Dense>
+    {
+        typedef Solve<ColPivHouseholderQR<Matrix<posit32, Dynamic, Dynamic>>, RhsType> SrcXprType;
+
+        static void run(DstXprType& dst, const SrcXprType& src, const assign_op<posit32, posit32>&)
+        {
+            const Index cols = src.dec().cols(), rank = src.dec().nonzeroPivots();
+            Matrix<posit32, Dynamic, Dynamic> c = eigen_posit::detail::qr_solve(src.dec(), rank, src.rhs());
+            if (dst.rows() != cols || dst.cols() != c.cols()) dst.resize(cols, c.cols());
+            const auto& order = src.dec().colsPermutation().indices();
+            for (Index i{}; i < rank; ++i) dst.row(order.coeff(i)) = c.row(i);
+            for (Index i = rank; i < cols; ++i) dst.row(order.coeff(i)).setZero();
+        }
+    };
+}
+
+    template<>
+    inline void ColPivHouseholderQR<Matrix<posit32, Dynamic, Dynamic>>::computeInPlace()
+    {
+        eigen_posit::detail::colpiv_householder_qr(m_qr, m_hCoeffs, m_colsTranspositions, m_colsPermutation, m_colNormsUpdated,
+                                                   m_colNormsDirect, m_maxpivot, m_nonzero_pivots, m_det_pq);
+        m_isInitialized = true;
+    }
+}
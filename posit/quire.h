@@ -0,0 +1,237 @@
+#pragma once
+
+#include "kernels.h"
+
+// Exact dot-product accumulation for posit32.
+//
+// The posit standard pairs posit32 with a 512-bit quire: a two's complement
+// fixed-point register wide enough to hold any sum of posit32 products
+// exactly (every posit32 product is a multiple of minpos^2 = 2^-240 and at
+// most maxpos^2 = 2^240). p32_quire implements it with 32-bit digits kept in
+// int64 slots. Adding a product touches three digits and never propagates a
+// carry; carries are resolved once, when the quire is rounded back to posit32.
+// The digits are biased 64 bits below 2^-240 so a product can be placed with
+// a left shift only, which pads the register to 640 bits.
+namespace eigen_posit
+{
+    using uint128 = unsigned __int128;
+
+    // A posit32 unpacked for exact integer arithmetic: value = sig * 2^(scale - 27),
+    // with |sig| < 2^28. Zero has sig = 0; NaR is tracked separately.
+    struct p32_unpacked
+    {
+        int32_t sig;
+        int32_t scale;
+    };
+
+    // A posit32 value already decoded to double, as kept by the decoded
+    // kernels of lu.h and qr.h; zero and NaN (NaR) unpack to zero.
+    inline p32_unpacked p32_unpack_decoded(double x)
+    {
+        if (x == 0.0 || x != x) return {0, 0};
+        uint64_t d = std::bit_cast<uint64_t>(x);
+        int32_t sig = int32_t((uint64_t(1) << 27) | ((d >> 25) & ((uint64_t(1) << 27) - 1)));
+        return {d >> 63 ? -sig : sig, int32_t((d >> 52) & 0x7FF) - 1023};
+    }
+
+    inline p32_unpacked p32_unpack(uint32_t bits)
+    {
+        if (bits == 0 || bits == p32_nar) return {0, 0};
+        return p32_unpack_decoded(p32_to_double(bits));
+    }
+
+    struct p32_quire
+    {
+        static constexpr int digits = 20;
+        // bit position of 2^0 for a product of two unpacked significands is
+        // scale_a + scale_b + product_bias (the 54 fraction bits are folded in)
+        static constexpr int product_bias = 304 - 54;
+
+        int64_t digit[digits];
+        bool nar;
+
+        p32_quire() { clear(); }
+
+        // Digits absorb up to 2^31 products before they can overflow; callers
+        // adding more must normalize() at least every this many batches.
+        static constexpr long normalize_interval(long batch) { return (long(1) << 31) / batch; }
+
+        void clear()
+        {
+            for (int i{}; i < digits; ++i) digit[i] = 0;
+            nar = false;
+        }
+
+        // Adds a * b given unpacked operands; the inner loop of every fused dot product.
+        void add_product(p32_unpacked a, p32_unpacked b)
+        {
+            int pos = a.scale + b.scale + product_bias;
+            __int128 v = __int128(int64_t(a.sig) * b.sig) << (pos & 31);
+            int64_t* d = digit + (pos >> 5);
+            d[0] += int64_t(uint32_t(v));
+            d[1] += int64_t(uint32_t(v >> 32));
+            d[2] += int64_t(v >> 64);
+        }
+
+        void add_product(uint32_t a, uint32_t b)
+        {
+            if (a == p32_nar || b == p32_nar) nar = true;
+            add_product(p32_unpack(a), p32_unpack(b));
+        }
+
+        void sub_product(uint32_t a, uint32_t b) { add_product(0u - a, b); }
+
+        void add(uint32_t a) { add_product(a, 0x40000000u); }
+
+        // Merges another quire; both should be normalized if either took many products.
+        void add(const p32_quire& other)
+        {
+            for (int i{}; i < digits; ++i) digit[i] += other.digit[i];
+            nar |= other.nar;
+        }
+
+        // Resolves the carries; afterwards every digit but the last is in [0, 2^32).
+        void normalize()
+        {
+            int64_t carry{};
+            for (int i{}; i < digits; ++i) {
+                int64_t t = digit[i] + carry;
+                digit[i] = t & 0xFFFFFFFF;
+                carry = t >> 32;
+            }
+            digit[digits - 1] += carry * (int64_t(1) << 32);
+        }
+
+        // Replaces the sum by its magnitude in normalized digits; returns whether it was negative.
+        bool to_magnitude()
+        {
+            normalize();
+            bool negative = digit[digits - 1] < 0;
+            if (negative) {
+                int64_t carry = 1;
+                for (int i{}; i < digits; ++i) {
+                    int64_t t = (~digit[i] & 0xFFFFFFFF) + carry;
+                    digit[i] = t & 0xFFFFFFFF;
+                    carry = t >> 32;
+                }
+            }
+            return negative;
+        }
+
+        // The exact sum as a double truncated to 53 bits plus the sign of the
+        // cut-off remainder in err (0 if nothing was cut). Ignores nar.
+        double to_double(double& err) const
+        {
+            p32_quire q = *this;
+            bool negative = q.to_magnitude();
+            err = 0.0;
+
+            int top = digits - 1;
+            while (top >= 0 && q.digit[top] == 0) --top;
+            if (top < 0) return 0.0;
+
+            // 96-bit window under the leading digit, everything below is sticky
+            uint128 window = uint128(q.digit[top]) << 64;
+            if (top >= 1) window |= uint128(q.digit[top - 1]) << 32;
+            if (top >= 2) window |= uint128(q.digit[top - 2]);
+            bool sticky{};
+            for (int i{}; i < top - 2; ++i) sticky |= q.digit[i] != 0;
+
+            int width = 128 - std::countl_zero(uint64_t(window >> 64));
+            int drop = width - 53;
+            sticky |= (window & ((uint128(1) << drop) - 1)) != 0;
+            double magnitude = std::ldexp(double(uint64_t(window >> drop)), drop + 32 * (top - 2) - 304);
+            if (sticky) err = negative ? -1.0 : 1.0;
+            return negative ? -magnitude : magnitude;
+        }
+
+        // Rounds the exact sum to posit32 once.
+        uint32_t to_posit() const
+        {
+            if (nar) return p32_nar;
+            double err;
+            double sum = to_double(err);
+            return sum == 0.0 ? 0u : p32_from_double(sum, err);
+        }
+
+        // The exact sum split as hi + lo + rest: hi is its leading 53 bits,
+        // lo the 53 after them, and err gets the sign of the rest (0 if none).
+        // Ignores nar.
+        void to_double_double(double& hi, double& lo, double& err) const
+        {
+            p32_quire q = *this;
+            bool negative = q.to_magnitude();
+            hi = lo = err = 0.0;
+
+            int top = digits - 1;
+            while (top >= 0 && q.digit[top] == 0) --top;
+            if (top < 0) return;
+            int lead = 32 * top + 31 - std::countl_zero(uint32_t(q.digit[top]));
+
+            // the 53 bits from bit `low` up, as an integer; bits outside the digits are zero
+            auto field = [&](int low) {
+                int first = low >> 5;
+                uint128 window{};
+                for (int i = first + 2; i >= first; --i) window = window << 32 | (i >= 0 && i < digits ? uint32_t(q.digit[i]) : 0u);
+                return double(uint64_t(window >> (low - 32 * first)) & ((uint64_t(1) << 53) - 1));
+            };
+            int cut = lead - 105;
+            hi = std::ldexp(field(lead - 52), lead - 52 - 304);
+            lo = std::ldexp(field(cut), cut - 304);
+            bool sticky{};
+            for (int i{}; i < digits && 32 * i < cut; ++i)
+                sticky |= (32 * i + 32 <= cut ? uint32_t(q.digit[i]) : uint32_t(q.digit[i]) << (32 - (cut - 32 * i))) != 0;
+            if (negative) hi = -hi, lo = -lo;
+            if (sticky) err = negative ? -1.0 : 1.0;
+        }
+
+        // Rounds the exact sum divided by d, a posit32 value, to posit32 once.
+        uint32_t to_posit_divided(double d) const
+        {
+            if (nar || !(d != 0.0)) return p32_nar;
+            double hi, lo, err;
+            to_double_double(hi, lo, err);
+            if (hi == 0.0) return 0u;
+            // Posit32 values and midpoints have at most 29 significant bits, so
+            // b, the quotient rounded to 31 bits, has none strictly between it
+            // and the exact quotient; the residual's sign then settles the
+            // rounding. b * d has at most 59 bits and lies within 2^-30 of hi,
+            // so fma gives hi - b * d exactly, and on lo's 2^-105 grid.
+            double b = round_to_31_bits(hi / d);
+            double r = std::fma(-b, d, hi);
+            double s = r + lo;
+            double residual = s != 0.0 ? s : err;
+            return p32_from_double(b, d < 0.0 ? -residual : residual);
+        }
+
+        // Rounds the square root of the exact sum, which must be positive, to posit32 once.
+        uint32_t to_posit_sqrt() const
+        {
+            if (nar) return p32_nar;
+            double hi, lo, err;
+            to_double_double(hi, lo, err);
+            if (hi < 0.0) return p32_nar;
+            if (hi == 0.0) return 0u;
+            // as in to_posit_divided; b * b has at most 62 bits
+            double b = round_to_31_bits(std::sqrt(hi));
+            double r = std::fma(-b, b, hi);
+            double s = r + lo;
+            return p32_from_double(b, s != 0.0 ? s : err);
+        }
+
+    private:
+        static double round_to_31_bits(double x)
+        {
+            uint64_t bits = std::bit_cast<uint64_t>(x) + (uint64_t(1) << 21);
+            return std::bit_cast<double>(bits & ~((uint64_t(1) << 22) - 1));
+        }
+    };
+
+    // Fused dot product: sum(a[i] * b[i]) rounded once.
+    inline uint32_t p32_fdp(const uint32_t* a, const uint32_t* b, long n, long stride_a = 1, long stride_b = 1)
+    {
+        p32_quire q;
+        for (long i{}; i < n; ++i) q.add_product(a[i * stride_a], b[i * stride_b]);
+        return q.to_posit();
+    }
+}
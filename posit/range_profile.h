@@ -0,0 +1,353 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+// Dynamic-range profiling, to pick a posit format for the data.
+//
+// A posit's precision depends on the magnitude: posit<N, ES> spends a run of
+// regime bits that grows with |log2 x| / 2^ES, so its fraction is widest
+// around 1 and narrows towards maxpos and minpos. Which format keeps an error
+// budget therefore depends on where the values actually lie, intermediates
+// included. range_probe is a double in disguise: running a pipeline on
+// Eigen matrices of it records the binary scale floor(log2 |x|) of every
+// value converted in and every arithmetic result, read straight from the
+// double's exponent bits, on average one value in sample_period() per
+// thread, at random. observe()
+// adds a whole matrix of any type. recommend() then finds the narrowest
+// posit<N, ES> and power-of-two scaling that give the central `coverage` of
+// the sampled values at least the fraction bits a relative error budget
+// needs.
+namespace eigen_posit
+{
+    // Counts of sampled values by binary scale, plus zeros and non-finite values.
+    struct range_histogram
+    {
+        static constexpr int min_scale = -1074;
+        static constexpr int max_scale = 1023;
+
+        std::array<uint64_t, max_scale - min_scale + 1> scales{};
+        uint64_t zeros{};
+        uint64_t nonfinite{};
+
+        void add(double x)
+        {
+            uint64_t bits = std::bit_cast<uint64_t>(x);
+            int exponent = int(bits >> 52) & 0x7FF;
+            if (exponent == 0x7FF) ++nonfinite;
+            else if (exponent != 0) ++scales[exponent - 1023 - min_scale];
+            else if (bits << 1) ++scales[std::ilogb(x) - min_scale];
+            else ++zeros;
+        }
+
+        range_histogram& operator+=(const range_histogram& o)
+        {
+            for (std::size_t i{}; i < scales.size(); ++i) scales[i] += o.scales[i];
+            zeros += o.zeros;
+            nonfinite += o.nonfinite;
+            return *this;
+        }
+
+        // nonzero finite samples
+        uint64_t count() const
+        {
+            uint64_t n{};
+            for (uint64_t c : scales) n += c;
+            return n;
+        }
+
+        // Smallest scale with at least a share q of the nonzero samples at or below it.
+        int quantile(double q) const
+        {
+            double target = std::max(1.0, q * double(count()));
+            double seen{};
+            for (std::size_t i{}; i < scales.size(); ++i) {
+                seen += double(scales[i]);
+                if (seen >= target) return int(i) + min_scale;
+            }
+            return max_scale;
+        }
+    };
+
+    // Fraction bits posit<n, es> keeps for values of binary scale `scale`;
+    // negative once the regime leaves no room, or past maxpos and minpos.
+    constexpr int posit_fraction_bits(int n, int es, int scale)
+    {
+        int k = scale >= 0 ? scale >> es : -((-scale + (1 << es) - 1) >> es);
+        int regime = k >= 0 ? k + 2 : 1 - k;
+        return n - 1 - regime - es;
+    }
+
+    struct posit_choice
+    {
+        int bits{};
+        int es{};
+        // multiply the data by 2^shift before rounding to posit<bits, es>
+        int shift{};
+        // fewest fraction bits over the covered scales
+        int fraction_bits{ INT_MIN };
+        // fraction bits the error budget asks for
+        int needed_bits{};
+        // share of the nonzero samples that get at least needed_bits
+        double covered{};
+        bool meets_budget{};
+
+        friend std::ostream& operator<<(std::ostream& out, const posit_choice& c)
+        {
+            out << "posit<" << c.bits << ", " << c.es << "> scaled by 2^" << c.shift << ": " << c.fraction_bits
+                << " fraction bits or more where " << c.needed_bits << " are needed, on " << 100.0 * c.covered << "% of values";
+            if (!c.meets_budget) out << " (over budget)";
+            return out;
+        }
+    };
+
+    // The narrowest of posit8, posit16 and posit32, over ES 0 to 3 and a
+    // power-of-two scaling, whose fraction bits across the central `coverage`
+    // of h's samples keep the relative error at most relative_error; among
+    // equally wide formats the one with the most bits to spare. Falls back on
+    // the best 32-bit format, marked as over budget.
+    inline posit_choice recommend(const range_histogram& h, double relative_error, double coverage = 0.999)
+    {
+        posit_choice best;
+        uint64_t total = h.count();
+        if (total == 0) return best;
+
+        // round to nearest: f fraction bits leave at most 2^-(f + 1) relative error
+        int needed = std::max(0, int(std::ceil(-std::log2(relative_error))) - 1);
+        double tail = (1.0 - coverage) / 2;
+        int lo = h.quantile(tail), hi = h.quantile(1.0 - tail);
+
+        for (int n : { 8, 16, 32 }) {
+            for (int es{}; es <= 3; ++es) {
+                // fraction bits peak at scale 0 and fall off both ways, so the
+                // window's ends decide; try shifts around centring it
+                int centre = -((lo + hi) >> 1);
+                for (int shift = centre - (1 << es) - 1; shift <= centre + (1 << es) + 1; ++shift) {
+                    int f = std::min(posit_fraction_bits(n, es, lo + shift), posit_fraction_bits(n, es, hi + shift));
+                    bool meets = f >= needed;
+                    bool better = best.bits == 0
+                        || (meets && (!best.meets_budget || n < best.bits || (n == best.bits && f > best.fraction_bits)))
+                        || (!meets && !best.meets_budget && (n > best.bits || (n == best.bits && f > best.fraction_bits)));
+                    if (!better) continue;
+                    best.bits = n;
+                    best.es = es;
+                    best.shift = shift;
+                    best.fraction_bits = f;
+                    best.meets_budget = meets;
+                }
+            }
+        }
+
+        best.needed_bits = needed;
+        uint64_t covered{};
+        for (std::size_t i{}; i < h.scales.size(); ++i)
+            if (posit_fraction_bits(best.bits, best.es, int(i) + range_histogram::min_scale + best.shift) >= needed)
+                covered += h.scales[i];
+        best.covered = double(covered) / double(total);
+        return best;
+    }
+
+namespace detail
+{
+    struct thread_histogram
+    {
+        range_histogram histogram;
+        // values left to skip before the next sample
+        uint32_t countdown{};
+        // xorshift64 state drawing the skips
+        uint64_t rng;
+
+        thread_histogram();
+        ~thread_histogram();
+    };
+
+    struct histogram_registry
+    {
+        std::mutex mutex;
+        std::vector<thread_histogram*> live;
+        // histograms of threads that have exited
+        range_histogram retired;
+    };
+
+    // Never destroyed: pool threads may exit after static destructors run.
+    inline histogram_registry& histograms()
+    {
+        static histogram_registry* r = new histogram_registry;
+        return *r;
+    }
+
+    inline thread_histogram::thread_histogram()
+    {
+        // distinct nonzero seed per thread
+        static std::atomic<uint64_t> threads{};
+        rng = (threads.fetch_add(1, std::memory_order_relaxed) + 1) * 0x9e3779b97f4a7c15ull;
+        std::lock_guard<std::mutex> lock(histograms().mutex);
+        histograms().live.push_back(this);
+    }
+
+    inline thread_histogram::~thread_histogram()
+    {
+        histogram_registry& r = histograms();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.retired += histogram;
+        r.live.erase(std::find(r.live.begin(), r.live.end(), this));
+    }
+
+    inline thread_histogram& local_histogram()
+    {
+        thread_local thread_histogram h;
+        return h;
+    }
+
+    inline std::atomic<uint32_t>& sample_period_setting()
+    {
+        static std::atomic<uint32_t> period{ 16 };
+        return period;
+    }
+
+    // Skips uniform on [0, 2 period - 2], one value in period on average. A
+    // fixed stride would lock onto one phase of a periodic pattern, such as
+    // the alternating products and sums of a dot product.
+    inline uint32_t next_skip(thread_histogram& t, uint32_t period)
+    {
+        t.rng ^= t.rng << 13;
+        t.rng ^= t.rng >> 7;
+        t.rng ^= t.rng << 17;
+        return uint32_t(t.rng % (2 * uint64_t(period) - 1));
+    }
+
+    inline void sample(double x)
+    {
+        thread_histogram& t = local_histogram();
+        if (t.countdown-- != 0) return;
+        t.countdown = next_skip(t, sample_period_setting().load(std::memory_order_relaxed));
+        t.histogram.add(x);
+    }
+}
+
+    // Every how many values a thread records one, on average; 1 records them all.
+    inline uint32_t sample_period() { return detail::sample_period_setting().load(); }
+    inline void set_sample_period(uint32_t period) { detail::sample_period_setting() = std::max<uint32_t>(1, period); }
+
+    // Merged histogram of every thread; call once the profiled code is done.
+    inline range_histogram range_profile()
+    {
+        detail::histogram_registry& r = detail::histograms();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        range_histogram total = r.retired;
+        for (const detail::thread_histogram* t : r.live) total += t->histogram;
+        return total;
+    }
+
+    inline void reset_range_profile()
+    {
+        detail::histogram_registry& r = detail::histograms();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.retired = range_histogram{};
+        for (detail::thread_histogram* t : r.live) t->histogram = range_histogram{};
+    }
+
+    // Samples the coefficients of m, converted to double, into the profile.
+    template<typename Derived>
+    void observe(const Eigen::DenseBase<Derived>& m)
+    {
+        for (Eigen::Index j{}; j < m.cols(); ++j)
+            for (Eigen::Index i{}; i < m.rows(); ++i) detail::sample(double(m.coeff(i, j)));
+    }
+
+    // Double arithmetic that samples every value converted in and every result.
+    class range_probe
+    {
+    public:
+        double value;
+
+        range_probe() = default;
+        range_probe(double x) : value(x) { detail::sample(x); }
+
+        // Eigen's integer constants are not data; not sampled.
+        template<typename I, std::enable_if_t<std::is_integral_v<I>, int> = 0>
+        range_probe(I x) : value(double(x)) {}
+
+        explicit operator double() const { return value; }
+        explicit operator float() const { return float(value); }
+
+        friend range_probe operator+(range_probe a, range_probe b) { return a.value + b.value; }
+        friend range_probe operator-(range_probe a, range_probe b) { return a.value - b.value; }
+        friend range_probe operator*(range_probe a, range_probe b) { return a.value * b.value; }
+        friend range_probe operator/(range_probe a, range_probe b) { return a.value / b.value; }
+        friend range_probe operator-(range_probe a) { return raw(-a.value); }
+        friend range_probe operator+(range_probe a) { return a; }
+
+        range_probe& operator+=(range_probe b) { return *this = *this + b; }
+        range_probe& operator-=(range_probe b) { return *this = *this - b; }
+        range_probe& operator*=(range_probe b) { return *this = *this * b; }
+        range_probe& operator/=(range_probe b) { return *this = *this / b; }
+
+        friend bool operator==(range_probe a, range_probe b) { return a.value == b.value; }
+        friend bool operator!=(range_probe a, range_probe b) { return a.value != b.value; }
+        friend bool operator<(range_probe a, range_probe b) { return a.value < b.value; }
+        friend bool operator<=(range_probe a, range_probe b) { return a.value <= b.value; }
+        friend bool operator>(range_probe a, range_probe b) { return a.value > b.value; }
+        friend bool operator>=(range_probe a, range_probe b) { return a.value >= b.value; }
+
+        friend range_probe abs(range_probe a) { return raw(std::fabs(a.value)); }
+        friend range_probe sqrt(range_probe a) { return std::sqrt(a.value); }
+        friend bool isnan(range_probe a) { return std::isnan(a.value); }
+        friend bool isinf(range_probe a) { return std::isinf(a.value); }
+        friend bool isfinite(range_probe a) { return std::isfinite(a.value); }
+
+        friend std::ostream& operator<<(std::ostream& out, range_probe a) { return out << a.value; }
+
+    private:
+        // sign changes and copies move no magnitude; not sampled
+        static range_probe raw(double x)
+        {
+            range_probe r;
+            r.value = x;
+            return r;
+        }
+    };
+}
+
+namespace Eigen
+{
+    template<>
+    struct NumTraits<eigen_posit::range_probe> : GenericNumTraits<eigen_posit::range_probe>
+    {
+        typedef eigen_posit::range_probe Real;
+        typedef eigen_posit::range_probe NonInteger;
+        typedef eigen_posit::range_probe Literal;
+        typedef eigen_posit::range_probe Nested;
+
+        enum {
+            IsComplex = 0,
+            IsInteger = 0,
+            IsSigned = 1,
+            RequireInitialization = 0,
+            ReadCost = 1,
+            AddCost = 2,
+            MulCost = 2
+        };
+
+        static constexpr int digits() { return std::numeric_limits<double>::digits; }
+        static constexpr int digits10() { return std::numeric_limits<double>::digits10; }
+
+        static inline Real epsilon() { return Real(std::numeric_limits<double>::epsilon()); }
+        static inline Real dummy_precision() { return Real(1e-12); }
+        static inline Real highest() { return Real(std::numeric_limits<double>::max()); }
+        static inline Real lowest() { return Real(std::numeric_limits<double>::lowest()); }
+        static inline Real infinity() { return Real(std::numeric_limits<double>::infinity()); }
+        static inline Real quiet_NaN() { return Real(std::numeric_limits<double>::quiet_NaN()); }
+    };
+}
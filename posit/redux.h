@@ -0,0 +1,153 @@
+#pragma once
+
+#include "packet_math.h"
+#include "parallel.h"
+#include "quire.h"
+#include <algorithm>
+#include <vector>
+
+// Quire-accumulated reductions for posit32.
+//
+// Eigen reduces with a rounded + per coefficient. For posit32, sum() and
+// everything built on it (dot(), squaredNorm(), norm()) instead accumulate
+// the exact sum in a quire and round once. Eigen's mean() then divides that
+// sum, a second rounding; eigen_posit::mean() divides the quire instead.
+// dot() and squaredNorm() reduce a coefficient-wise product or abs2
+// expression; those are recognized and their products enter the quire
+// unrounded, so dot() is the fused dot product of the posit standard. Long
+// reductions are split into chunks with one quire each, which run on the
+// posit thread pool (parallel.h) and merge in chunk order, so the result
+// does not depend on the thread count.
+namespace eigen_posit
+{
+namespace detail
+{
+    constexpr Eigen::Index quire_redux_chunk = Eigen::Index(1) << 14;
+
+    // Feeds one coefficient of the reduced expression into a quire.
+    template<typename XprType>
+    struct quire_terms
+    {
+        Eigen::internal::evaluator<XprType> eval;
+
+        explicit quire_terms(const XprType& xpr) : eval(xpr) {}
+        void add(p32_quire& q, Eigen::Index row, Eigen::Index col) const { q.add(eval.coeff(row, col).value); }
+    };
+
+    template<typename Lhs, typename Rhs>
+    struct quire_product_terms
+    {
+        Eigen::internal::evaluator<Lhs> lhs;
+        Eigen::internal::evaluator<Rhs> rhs;
+
+        template<typename XprType>
+        explicit quire_product_terms(const XprType& xpr) : lhs(xpr.lhs()), rhs(xpr.rhs()) {}
+        void add(p32_quire& q, Eigen::Index row, Eigen::Index col) const { q.add_product(lhs.coeff(row, col).value, rhs.coeff(row, col).value); }
+    };
+
+    template<typename Lhs, typename Rhs>
+    struct quire_terms<Eigen::CwiseBinaryOp<Eigen::internal::scalar_product_op<posit32, posit32>, Lhs, Rhs>> : quire_product_terms<Lhs, Rhs>
+    {
+        using quire_product_terms<Lhs, Rhs>::quire_product_terms;
+    };
+
+    template<typename Lhs, typename Rhs>
+    struct quire_terms<Eigen::CwiseBinaryOp<Eigen::internal::scalar_conj_product_op<posit32, posit32>, Lhs, Rhs>> : quire_product_terms<Lhs, Rhs>
+    {
+        using quire_product_terms<Lhs, Rhs>::quire_product_terms;
+    };
+
+    template<typename Arg>
+    struct quire_terms<Eigen::CwiseUnaryOp<Eigen::internal::scalar_abs2_op<posit32>, Arg>>
+    {
+        Eigen::internal::evaluator<Arg> arg;
+
+        template<typename XprType>
+        explicit quire_terms(const XprType& xpr) : arg(xpr.nestedExpression()) {}
+        void add(p32_quire& q, Eigen::Index row, Eigen::Index col) const
+        {
+            uint32_t x = arg.coeff(row, col).value;
+            q.add_product(x, x);
+        }
+    };
+
+    // Accumulates the coefficients [begin, end) in storage order.
+    template<typename XprType>
+    void quire_accumulate(const quire_terms<XprType>& terms, const XprType& xpr, Eigen::Index begin, Eigen::Index end, p32_quire& q)
+    {
+        Eigen::Index inner_size = xpr.innerSize();
+        Eigen::Index outer = begin / inner_size, inner = begin % inner_size;
+        for (Eigen::Index i = begin; i < end; ++i) {
+            if (XprType::IsRowMajor) terms.add(q, outer, inner);
+            else terms.add(q, inner, outer);
+            if (++inner == inner_size) {
+                inner = 0;
+                ++outer;
+            }
+        }
+        q.normalize();
+    }
+
+    // The exact sum of every coefficient, unrounded.
+    template<typename XprType>
+    p32_quire quire_total(const XprType& xpr)
+    {
+        quire_terms<XprType> terms(xpr);
+        Eigen::Index size = xpr.size();
+        Eigen::Index chunks = (size + quire_redux_chunk - 1) / quire_redux_chunk;
+        p32_quire q;
+        if (chunks == 1) {
+            quire_accumulate(terms, xpr, 0, size, q);
+            return q;
+        }
+        std::vector<p32_quire> partial(chunks);
+        parallel_slices(chunks, Eigen::Index(1), double(quire_redux_chunk), [&](Eigen::Index c0, Eigen::Index c1) {
+            for (Eigen::Index c = c0; c < c1; ++c)
+                quire_accumulate(terms, xpr, c * quire_redux_chunk, std::min(size, (c + 1) * quire_redux_chunk), partial[c]);
+        });
+        for (const p32_quire& p : partial) q.add(p);
+        return q;
+    }
+
+    template<typename XprType>
+    posit32 quire_sum(const XprType& xpr) { return p32_from_bits(quire_total(xpr).to_posit()); }
+
+    // Shared body of the redux_impl specializations below; the traversal Eigen
+    // picked for packets is irrelevant once the sum goes through a quire.
+    struct quire_redux
+    {
+        template<typename Evaluator, typename Func, typename XprType>
+        static posit32 run(const Evaluator&, const Func&, const XprType& xpr) { return quire_sum(xpr); }
+    };
+}
+
+    // The mean of a posit32 expression, its quire sum divided by the size and
+    // rounded once. Eigen's mean() divides the rounded sum(), which rounds
+    // twice. The division is exact for sizes below 2^28.
+    template<typename Derived>
+    posit32 mean(const Eigen::DenseBase<Derived>& xpr)
+    {
+        return p32_from_bits(detail::quire_total(xpr.derived()).to_posit_divided(double(xpr.size())));
+    }
+}
+
+namespace Eigen
+{
+namespace internal
+{
+    template<typename Evaluator>
+    struct redux_impl<scalar_sum_op<posit32, posit32>, Evaluator, DefaultTraversal, NoUnrolling> : eigen_posit::detail::quire_redux {};
+
+    template<typename Evaluator>
+    struct redux_impl<scalar_sum_op<posit32, posit32>, Evaluator, DefaultTraversal, CompleteUnrolling> : eigen_posit::detail::quire_redux {};
+
+    template<typename Evaluator>
+    struct redux_impl<scalar_sum_op<posit32, posit32>, Evaluator, LinearVectorizedTraversal, NoUnrolling> : eigen_posit::detail::quire_redux {};
+
+    template<typename Evaluator>
+    struct redux_impl<scalar_sum_op<posit32, posit32>, Evaluator, LinearVectorizedTraversal, CompleteUnrolling> : eigen_posit::detail::quire_redux {};
+
+    template<typename Evaluator, int Unrolling>
+    struct redux_impl<scalar_sum_op<posit32, posit32>, Evaluator, SliceVectorizedTraversal, Unrolling> : eigen_posit::detail::quire_redux {};
+}
+}
@@ -0,0 +1,333 @@
+#pragma once
+
+#include "lu.h"
+#include "parallel.h"
+#include "quire.h"
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+// Mixed-precision iterative refinement.
+//
+// A posit16 factorization moves half the bytes of a posit32 one and runs on
+// the table-driven posit16 kernels, but its solutions carry only posit16's 12
+// fraction bits. IterativeRefinementSolver recovers the storage precision
+// from it as LAPACK's dsgesv does: x starts as the low-precision solution,
+// and each step solves A d = r with the same factorization, where
+// r = b - A x is computed in a wider precision, then adds d to x. While the
+// factor's unit roundoff times cond(A) stays well below 1, every step gains
+// about as many bits as the factor holds. The three precisions are template
+// parameters:
+//
+//   Storage    A, b and x; the precision x converges to
+//   Factor     Decomposition's matrix, e.g. PartialPivLU<Matrix<posit16, ...>>
+//   Residual   a scalar type for Eigen to evaluate b - A x in, or p32_quire:
+//              every entry summed exactly and read out once, in double
+//              (posit32, posit16 and posit8 storage, through quire_storage).
+//              With Residual = Storage a posit Storage still sums in the
+//              quire, then rounds every entry to Storage once.
+//
+// A, scaled by a power of two so that its largest entry is near 1 where posits
+// carry the most fraction bits, is rounded to Factor once by compute(); every
+// residual is scaled the same way, column by column, before it is rounded.
+// A column has converged once no correction exceeds an ulp (of Storage) of
+// the entry it corrects. It has stagnated when a correction is not finite,
+// or its largest ratio to those ulps is over half the step before's, or a
+// step after the first does not shrink the largest entry of the residual
+// (the step is then undone), or maxIterations() steps pass first. A
+// stagnated column whose residual already passes LAPACK's normwise backward
+// error test is kept, unless it ends with a larger residual than its first
+// iterate had: its residual precision can do no better. Otherwise the solve
+// starts over on a Decomposition of A in Storage precision, refined the same
+// way; that one is computed at the first fallback, and later solves go
+// straight to it until the next compute().
+// Storage and Factor may be posit32, posit16, float or double.
+namespace eigen_posit
+{
+namespace detail
+{
+    template<typename Scalar>
+    double refine_decode(const Scalar& x)
+    {
+        if constexpr (std::is_arithmetic_v<Scalar>) return double(x);
+        else return lu_format<Scalar>::decode(x);
+    }
+
+    // Rounds x + err, err below half an ulp of x, to Scalar.
+    template<typename Scalar>
+    Scalar refine_encode(double x, double err = 0.0)
+    {
+        if constexpr (std::is_arithmetic_v<Scalar>) return Scalar(x);
+        else return lu_format<Scalar>::encode(x, err);
+    }
+
+    // Gap between |x| rounded to Scalar and the next value away from zero;
+    // at the largest value, the gap below it.
+    template<typename Scalar>
+    double refine_ulp(double x)
+    {
+        Scalar below = refine_encode<Scalar>(std::fabs(x)), above = below;
+        if constexpr (std::is_arithmetic_v<Scalar>) {
+            above = std::nextafter(below, std::numeric_limits<Scalar>::max());
+            if (above == below) below = std::nextafter(above, Scalar(0));
+        } else {
+            ++above.value;
+            // maxpos has no successor
+            if (!(refine_decode(above) > refine_decode(below))) above = below, --below.value;
+        }
+        return refine_decode(above) - refine_decode(below);
+    }
+
+    // scale * m, rounded once to To.
+    template<typename To, typename Derived>
+    Eigen::Matrix<To, Eigen::Dynamic, Eigen::Dynamic> refine_cast(const Eigen::MatrixBase<Derived>& m, double scale = 1.0)
+    {
+        Eigen::Matrix<To, Eigen::Dynamic, Eigen::Dynamic> out(m.rows(), m.cols());
+        for (Eigen::Index j{}; j < m.cols(); ++j)
+            for (Eigen::Index i{}; i < m.rows(); ++i) out(i, j) = refine_encode<To>(refine_decode(m.coeff(i, j)) * scale);
+        return out;
+    }
+
+    // The power of two nearest below the largest |x| of m, or 1 if m is all
+    // zero or holds NaR; its reciprocal scales m to [1, 2).
+    template<typename Derived>
+    double refine_magnitude(const Eigen::MatrixBase<Derived>& m)
+    {
+        double largest{};
+        for (Eigen::Index j{}; j < m.cols(); ++j)
+            for (Eigen::Index i{}; i < m.rows(); ++i) largest = std::max(largest, std::fabs(refine_decode(m.coeff(i, j))));
+        return largest > 0.0 && std::isfinite(largest) ? std::ldexp(1.0, std::ilogb(largest)) : 1.0;
+    }
+
+    // b - a x, every entry summed exactly in a quire; rows are sliced across
+    // the thread pool. NaR entries give NaN.
+    template<typename Scalar>
+    Eigen::MatrixXd quire_residual(const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>& a,
+                                   const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>& x,
+                                   const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>& b)
+    {
+        using Eigen::Index;
+        typedef quire_storage<Scalar> storage;
+        Index rows = a.rows(), depth = a.cols();
+        Eigen::MatrixXd r(rows, b.cols());
+        std::vector<p32_unpacked> minus_x(depth);
+        for (Index j{}; j < b.cols(); ++j) {
+            bool x_nar{};
+            for (Index k{}; k < depth; ++k) {
+                uint32_t v = storage::widen(x(k, j));
+                x_nar |= v == p32_nar;
+                minus_x[k] = p32_unpack(0u - v);
+            }
+            // a quire product is worth about four float adds
+            parallel_slices(rows, Index(8), 4.0 * double(depth), [&](Index begin, Index end) {
+                std::vector<p32_quire> q(end - begin);
+                for (Index i = begin; i < end; ++i) q[i - begin].add(storage::widen(b(i, j)));
+                for (Index k{}; k < depth; ++k) {
+                    const Scalar* column = a.data() + k * rows;
+                    for (Index i = begin; i < end; ++i) {
+                        uint32_t v = storage::widen(column[i]);
+                        q[i - begin].nar |= v == p32_nar;
+                        q[i - begin].add_product(p32_unpack(v), minus_x[k]);
+                    }
+                    if ((k + 1) % p32_quire::normalize_interval(1) == 0)
+                        for (p32_quire& s : q) s.normalize();
+                }
+                for (Index i = begin; i < end; ++i) {
+                    double err;
+                    r(i, j) = q[i - begin].nar || x_nar ? std::nan("") : q[i - begin].to_double(err);
+                }
+            });
+        }
+        return r;
+    }
+}
+
+    template<template<typename> class Decomposition, typename Storage, typename Factor, typename Residual = p32_quire>
+    class IterativeRefinementSolver
+    {
+    public:
+        typedef Eigen::Matrix<Storage, Eigen::Dynamic, Eigen::Dynamic> StorageMatrix;
+        typedef Eigen::Matrix<Factor, Eigen::Dynamic, Eigen::Dynamic> FactorMatrix;
+
+        IterativeRefinementSolver() = default;
+
+        template<typename InputType>
+        explicit IterativeRefinementSolver(const Eigen::EigenBase<InputType>& a) { compute(a); }
+
+        template<typename InputType>
+        IterativeRefinementSolver& compute(const Eigen::EigenBase<InputType>& a)
+        {
+            matrix = a.derived();
+            if constexpr (wide_residual) wide = detail::refine_cast<ResidualScalar>(matrix);
+            scale = detail::refine_magnitude(matrix);
+            Eigen::VectorXd row_sums = Eigen::VectorXd::Zero(matrix.rows());
+            for (Eigen::Index j{}; j < matrix.cols(); ++j)
+                for (Eigen::Index i{}; i < matrix.rows(); ++i) row_sums(i) += std::fabs(detail::refine_decode(matrix(i, j)));
+            norm = row_sums.size() ? row_sums.maxCoeff() : 0.0;
+            low.compute(detail::refine_cast<Factor>(matrix, 1.0 / scale));
+            high_computed = false;
+            return *this;
+        }
+
+        // Refines every column of b to Storage precision; iterations(),
+        // fellBack() and info() then describe this solve. Not safe to call
+        // from several threads at once.
+        template<typename Rhs>
+        StorageMatrix solve(const Eigen::MatrixBase<Rhs>& b) const
+        {
+            StorageMatrix rhs = b.template cast<Storage>(), x;
+            steps = 0;
+            fell_back = high_computed;
+            if (!fell_back && refine(low, scale, rhs, x, std::is_same_v<Factor, Storage>)) return x;
+            fell_back = true;
+            if (!high_computed) {
+                high.compute(matrix);
+                high_computed = true;
+            }
+            refine(high, 1.0, rhs, x, true);
+            return x;
+        }
+
+        // Residuals computed and corrections applied by the last solve, over
+        // both factorizations.
+        int iterations() const { return steps; }
+        // Whether the last solve used the Storage decomposition.
+        bool fellBack() const { return fell_back; }
+        // Success if every column of the last solve converged, else NoConvergence.
+        Eigen::ComputationInfo info() const { return result; }
+
+        int maxIterations() const { return max_iterations; }
+        IterativeRefinementSolver& setMaxIterations(int n)
+        {
+            max_iterations = n;
+            return *this;
+        }
+
+        // The low-precision factorization, of A scaled as described above.
+        const Decomposition<FactorMatrix>& factorDecomposition() const { return low; }
+
+    private:
+        static constexpr bool quire_residual = std::is_same_v<Residual, p32_quire>;
+        static constexpr bool posit_storage = std::is_same_v<Storage, posit32> || std::is_same_v<Storage, posit16> || std::is_same_v<Storage, posit8>;
+        static constexpr bool wide_residual = !quire_residual && !std::is_same_v<Residual, Storage>;
+        typedef std::conditional_t<wide_residual, Residual, Storage> ResidualScalar;
+
+        Eigen::MatrixXd residual(const StorageMatrix& b, const StorageMatrix& x) const
+        {
+            if constexpr (quire_residual) return detail::quire_residual(matrix, x, b);
+            else if constexpr (wide_residual) {
+                Eigen::Matrix<ResidualScalar, Eigen::Dynamic, Eigen::Dynamic> r = detail::refine_cast<ResidualScalar>(b);
+                r.noalias() -= wide * detail::refine_cast<ResidualScalar>(x);
+                return detail::refine_cast<double>(r);
+            } else if constexpr (posit_storage) {
+                return detail::refine_cast<double>(detail::refine_cast<Storage>(detail::quire_residual(matrix, x, b)));
+            } else {
+                StorageMatrix r = b;
+                r.noalias() -= matrix * x;
+                return detail::refine_cast<double>(r);
+            }
+        }
+
+        // LAPACK's test, in the infinity norm: |b - A x| <= sqrt(n) |A| ulp(|x|).
+        bool backward_stable(const Eigen::MatrixXd& r, const StorageMatrix& x, Eigen::Index j) const
+        {
+            double x_largest{};
+            for (Eigen::Index i{}; i < x.rows(); ++i) x_largest = std::max(x_largest, std::fabs(detail::refine_decode(x(i, j))));
+            return r.col(j).cwiseAbs().maxCoeff() <= std::sqrt(double(x.rows())) * norm * detail::refine_ulp<Storage>(x_largest);
+        }
+
+        // Solves for x from zero with dec, which factors matrix / factor_scale.
+        // A stagnating column that is not backward_stable(), or whose residual
+        // ends above its first iterate's, makes it return false, unless final:
+        // then the column keeps its last accepted x and the solve reports
+        // NoConvergence.
+        template<typename Dec>
+        bool refine(const Dec& dec, double factor_scale, const StorageMatrix& b, StorageMatrix& x, bool final) const
+        {
+            using Eigen::Index;
+            typedef typename Dec::MatrixType::Scalar Scalar;
+            Index n = matrix.cols(), cols = b.cols();
+            x = StorageMatrix::Zero(n, cols);
+            Eigen::MatrixXd r = detail::refine_cast<double>(b), d(n, cols);
+            std::vector<double> previous(cols, std::numeric_limits<double>::infinity()), unscale(cols);
+            // largest residual entry of each column's first iterate
+            std::vector<double> first(cols, std::numeric_limits<double>::infinity());
+            std::vector<bool> done(cols, false), stepped(cols);
+            result = Eigen::Success;
+            // a column stops short of convergence; false if that ends this solve
+            auto stagnate = [&](Index j, bool finite) {
+                done[j] = true;
+                if (finite && r.col(j).cwiseAbs().maxCoeff() <= first[j] && backward_stable(r, x, j)) return true;
+                if (!final) return false;
+                result = Eigen::NoConvergence;
+                return true;
+            };
+            for (int step{};; ++step) {
+                Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic> scaled(n, cols);
+                for (Index j{}; j < cols; ++j) {
+                    double magnitude = detail::refine_magnitude(r.col(j));
+                    unscale[j] = magnitude / factor_scale;
+                    for (Index i{}; i < n; ++i) scaled(i, j) = detail::refine_encode<Scalar>(r(i, j) / magnitude);
+                }
+                Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic> y = dec.solve(scaled);
+
+                bool all_done = true;
+                StorageMatrix before = x;
+                for (Index j{}; j < cols; ++j) {
+                    stepped[j] = false;
+                    if (done[j]) continue;
+                    // the largest correction, in ulps of the entry it corrects
+                    double moved{};
+                    for (Index i{}; i < n; ++i) {
+                        d(i, j) = detail::refine_decode(y(i, j)) * unscale[j];
+                        moved = std::max(moved, std::fabs(d(i, j)) / detail::refine_ulp<Storage>(detail::refine_decode(x(i, j))));
+                    }
+                    bool finite = d.col(j).allFinite();
+                    if (!finite || moved > previous[j] / 2 || step >= max_iterations) {
+                        if (!stagnate(j, finite)) return false;
+                        continue;
+                    }
+                    previous[j] = moved;
+                    for (Index i{}; i < n; ++i) {
+                        double xi = detail::refine_decode(x(i, j)), sum = xi + d(i, j);
+                        x(i, j) = detail::refine_encode<Storage>(sum, two_sum_err(xi, d(i, j), sum));
+                    }
+                    done[j] = moved <= 1.0;
+                    stepped[j] = !done[j];
+                    all_done = all_done && done[j];
+                }
+                if (all_done) return true;
+                Eigen::MatrixXd next = residual(b, x);
+                ++steps;
+                // undo a later step that left the residual no smaller; the
+                // first iterate is always kept, as x = 0 is no solution
+                for (Index j{}; j < cols; ++j) {
+                    if (!stepped[j]) continue;
+                    double size = next.col(j).cwiseAbs().maxCoeff();
+                    if (step == 0) first[j] = size;
+                    if (step == 0 || size < r.col(j).cwiseAbs().maxCoeff()) continue;
+                    x.col(j) = before.col(j);
+                    next.col(j) = r.col(j);
+                    if (!stagnate(j, true)) return false;
+                }
+                r = next;
+            }
+        }
+
+        StorageMatrix matrix;
+        Eigen::Matrix<ResidualScalar, Eigen::Dynamic, Eigen::Dynamic> wide;
+        double scale{ 1.0 };
+        // infinity norm of A
+        double norm{};
+        Decomposition<FactorMatrix> low;
+        mutable Decomposition<StorageMatrix> high;
+        mutable bool high_computed{};
+        int max_iterations{ 30 };
+        mutable int steps{};
+        mutable bool fell_back{};
+        mutable Eigen::ComputationInfo result{ Eigen::Success };
+    };
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "softposit_cpp.h"
+#include <Eigen/Core>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Sorting and selection over posit vectors without decoding.
+//
+// A posit's bits read as a two's complement integer order exactly like its
+// value, with NaR (the most negative integer) below every real. Flipping the
+// sign bit turns that into plain unsigned order, so sort() and argsort() are
+// LSD radix sorts on the bits, one byte per pass, and top_k() selects on
+// integer keys. Works for posit8, posit16 and posit32 vectors.
+namespace eigen_posit
+{
+namespace detail
+{
+    template<typename Posit>
+    using posit_bits = decltype(Posit::value);
+
+    template<typename Posit>
+    inline posit_bits<Posit> order_key(const Posit& p)
+    {
+        typedef posit_bits<Posit> bits;
+        return bits(p.value ^ (bits(1) << (8 * sizeof(bits) - 1)));
+    }
+
+    // Stable radix sort of keys[0, n), carrying payload along if given.
+    template<typename Key, typename Payload>
+    void radix_sort(Key* keys, Payload* payload, std::size_t n)
+    {
+        std::vector<Key> key_buffer(n);
+        std::vector<Payload> payload_buffer(payload ? n : 0);
+        Key* src = keys;
+        Key* dst = key_buffer.data();
+        Payload* payload_src = payload;
+        Payload* payload_dst = payload_buffer.data();
+
+        for (unsigned shift{}; shift < 8 * sizeof(Key); shift += 8) {
+            std::size_t offset[257]{};
+            for (std::size_t i{}; i < n; ++i) ++offset[((src[i] >> shift) & 0xFF) + 1];
+            // every key has the same byte here: nothing to move
+            if (offset[((src[0] >> shift) & 0xFF) + 1] == n) continue;
+            for (int d{}; d < 256; ++d) offset[d + 1] += offset[d];
+            for (std::size_t i{}; i < n; ++i) {
+                std::size_t at = offset[(src[i] >> shift) & 0xFF]++;
+                dst[at] = src[i];
+                if (payload) payload_dst[at] = payload_src[i];
+            }
+            std::swap(src, dst);
+            std::swap(payload_src, payload_dst);
+        }
+        if (src != keys) {
+            std::copy(src, src + n, keys);
+            if (payload) std::copy(payload_src, payload_src + n, payload);
+        }
+    }
+}
+
+    typedef Eigen::Matrix<Eigen::Index, Eigen::Dynamic, 1> index_vector;
+
+    // Sorts a posit vector (or any vector block) ascending in place.
+    template<typename Derived>
+    void sort(const Eigen::DenseBase<Derived>& v)
+    {
+        EIGEN_STATIC_ASSERT_VECTOR_ONLY(Derived);
+        typedef typename Derived::Scalar Posit;
+        typedef detail::posit_bits<Posit> bits;
+        Derived& dst = v.const_cast_derived();
+        const Eigen::Index n = dst.size();
+        if (n < 2) return;
+
+        std::vector<bits> keys(n);
+        for (Eigen::Index i{}; i < n; ++i) keys[i] = detail::order_key(dst.coeff(i));
+        detail::radix_sort(keys.data(), static_cast<Eigen::Index*>(nullptr), keys.size());
+        const bits flip = bits(bits(1) << (8 * sizeof(bits) - 1));
+        for (Eigen::Index i{}; i < n; ++i) dst.coeffRef(i).value = bits(keys[i] ^ flip);
+    }
+
+    // The stable permutation that sorts v ascending: v(argsort(v)(i)) is the i-th smallest.
+    template<typename Derived>
+    index_vector argsort(const Eigen::DenseBase<Derived>& v)
+    {
+        EIGEN_STATIC_ASSERT_VECTOR_ONLY(Derived);
+        typedef detail::posit_bits<typename Derived::Scalar> bits;
+        const Eigen::Index n = v.size();
+        index_vector order(n);
+        if (n == 0) return order;
+
+        std::vector<bits> keys(n);
+        for (Eigen::Index i{}; i < n; ++i) {
+            keys[i] = detail::order_key(v.coeff(i));
+            order(i) = i;
+        }
+        detail::radix_sort(keys.data(), order.data(), keys.size());
+        return order;
+    }
+
+    // Indices of the k largest entries of v, largest first; equal values keep index order.
+    template<typename Derived>
+    index_vector top_k(const Eigen::DenseBase<Derived>& v, Eigen::Index k)
+    {
+        EIGEN_STATIC_ASSERT_VECTOR_ONLY(Derived);
+        const Eigen::Index n = v.size();
+        eigen_assert(uint64_t(n) <= (uint64_t(1) << 32) && "top_k: vector too long");
+        k = std::clamp<Eigen::Index>(k, 0, n);
+
+        // key above, inverted index below: one integer compare orders both
+        std::vector<uint64_t> ranked(n);
+        for (Eigen::Index i{}; i < n; ++i)
+            ranked[i] = (uint64_t(detail::order_key(v.coeff(i))) << 32) | uint32_t(~uint32_t(i));
+        std::nth_element(ranked.begin(), ranked.begin() + k - (k > 0), ranked.end(), std::greater<uint64_t>());
+        std::sort(ranked.begin(), ranked.begin() + k, std::greater<uint64_t>());
+
+        index_vector top(k);
+        for (Eigen::Index i{}; i < k; ++i) top(i) = Eigen::Index(~uint32_t(ranked[i]));
+        return top;
+    }
+}
@@ -0,0 +1,58 @@
+#include "softposit_cpp.h"
+#include "../posit/cholesky.h"
+#include "../posit/lu.h"
+#include "../posit/posit.h"
+#include <Eigen/Dense>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+
+// rcond() of the posit32 and posit<32, 2> decompositions, which needs
+// NumTraits::infinity() and a number times a posit, against double's; and
+// posit to integer conversion of NaR and of values out of range.
+
+namespace
+{
+    int failures{};
+
+    void check(bool ok, const char* what)
+    {
+        if (ok) return;
+        std::cerr << "FAIL " << what << "\n";
+        ++failures;
+    }
+
+    // Hager's estimate in posit32 against the same estimate in double.
+    bool near(double estimate, double reference) { return std::fabs(estimate - reference) <= 1e-3 * reference; }
+}
+
+int main()
+{
+    using namespace Eigen;
+    typedef Matrix<posit32, Dynamic, Dynamic> MatrixP32;
+    typedef eigen_posit::posit<32, 2> header32;
+    typedef Matrix<header32, Dynamic, Dynamic> MatrixH32;
+
+    MatrixXd r = MatrixXd::Random(24, 24);
+    MatrixXd spd = r * r.transpose() + MatrixXd::Identity(24, 24);
+    MatrixP32 a = spd.cast<posit32>();
+    // the posit-rounded matrix, so both sides estimate the same condition
+    MatrixXd exact = a.cast<double>();
+
+    double llt = LLT<MatrixXd>(exact).rcond(), ldlt = LDLT<MatrixXd>(exact).rcond(), lu = PartialPivLU<MatrixXd>(exact).rcond();
+    check(near(LLT<MatrixP32>(a).rcond().toDouble(), llt), "posit32 LLT rcond");
+    check(near(LDLT<MatrixP32>(a).rcond().toDouble(), ldlt), "posit32 LDLT rcond");
+    check(near(PartialPivLU<MatrixP32>(a).rcond().toDouble(), lu), "posit32 PartialPivLU rcond");
+    check(near(double(PartialPivLU<MatrixH32>(exact.cast<header32>()).rcond()), lu), "posit<32, 2> PartialPivLU rcond");
+    check(NumTraits<posit32>::infinity() == NumTraits<posit32>::highest(), "posit32 infinity() is maxpos");
+
+    header32 nar = header32::from_bits(header32::nar_bits);
+    check(int(nar) == INT32_MIN, "NaR to int");
+    check(uint32_t(nar) == 0, "NaR to unsigned");
+    check(int16_t(header32(1e6)) == INT16_MIN, "out of range to int16_t");
+    check(int(header32(-3.75)) == -3, "truncation toward zero");
+
+    if (failures) return 1;
+    std::cout << "num_traits: ok\n";
+    return 0;
+}
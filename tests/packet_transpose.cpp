@@ -0,0 +1,56 @@
+#include "softposit_cpp.h"
+#include "../posit/cast.h"
+#include "../posit/gemm.h"
+#include "../posit/packet_math.h"
+#include "../posit/qr.h"
+#include <Eigen/Dense>
+#include <iostream>
+
+// Products and solves whose kernels transpose blocks of packets, on posit32
+// with the default flags: Packet16p32 there, whose ptranspose is the plain
+// lane shuffle of packet_math.h. Each is checked against the same operation
+// in double on the posit-rounded operands.
+
+namespace
+{
+    int failures{};
+
+    template<typename Result>
+    void check(const Result& result, const Eigen::MatrixXd& reference, double tolerance, const char* what)
+    {
+        double error = (result.template cast<double>() - reference).norm() / reference.norm();
+        if (error <= tolerance) return;
+        std::cerr << "FAIL " << what << ": relative error " << error << "\n";
+        ++failures;
+    }
+}
+
+int main()
+{
+    using namespace Eigen;
+    typedef Matrix<posit32, Dynamic, Dynamic> MatrixP32;
+    const int n = 40;
+
+    MatrixP32 a = (MatrixXd::Random(n, n) + 4.0 * MatrixXd::Identity(n, n)).cast<posit32>();
+    MatrixP32 b = MatrixXd::Random(n, n).cast<posit32>();
+    MatrixXd da = a.cast<double>(), db = b.cast<double>();
+
+    MatrixP32 upper = a.triangularView<Upper>() * b;
+    check(upper, MatrixXd(da.triangularView<Upper>()) * db, 1e-6, "triangularView<Upper>() * B");
+
+    MatrixP32 symmetric = a.selfadjointView<Lower>() * b;
+    check(symmetric, MatrixXd(da.selfadjointView<Lower>()) * db, 1e-6, "selfadjointView<Lower>() * B");
+
+    MatrixP32 x = b;
+    a.triangularView<Lower>().solveInPlace<OnTheRight>(x);
+    MatrixXd dx = db;
+    da.triangularView<Lower>().solveInPlace<OnTheRight>(dx);
+    check(x, dx, 1e-5, "triangularView<Lower>().solveInPlace<OnTheRight>()");
+
+    MatrixP32 q = HouseholderQR<MatrixP32>(a).householderQ();
+    check(q, MatrixXd(HouseholderQR<MatrixXd>(da).householderQ()), 1e-5, "HouseholderQR::householderQ()");
+
+    if (failures) return 1;
+    std::cout << "packet_transpose: ok\n";
+    return 0;
+}
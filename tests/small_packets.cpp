@@ -0,0 +1,80 @@
+#include "softposit_cpp.h"
+#include "../posit/cast.h"
+#include "../posit/lut_gemm.h"
+#include <Eigen/Dense>
+#include <iostream>
+
+// posit16 and posit8 packet arithmetic with the default flags: Packet16p16
+// and Packet16p8 there, whose arithmetic calls the dispatched kernels. Each
+// kernel set the host supports must give the scalar table results bit for
+// bit, including the tail of an array that does not fill a packet; products
+// whose kernels transpose packet blocks are checked against double.
+
+namespace
+{
+    int failures{};
+
+    void fail(const char* set, const char* what)
+    {
+        std::cerr << "FAIL " << set << ": " << what << "\n";
+        ++failures;
+    }
+
+    template<typename P, typename Bits>
+    void check_arithmetic(const char* set, Bits (*add)(Bits, Bits), Bits (*sub)(Bits, Bits), Bits (*mul)(Bits, Bits), Bits (*div)(Bits, Bits))
+    {
+        typedef Eigen::Array<P, Eigen::Dynamic, 1> ArrayP;
+        const int n = 1001;
+        ArrayP a = (3.0 * Eigen::ArrayXd::Random(n)).cast<P>();
+        ArrayP b = (3.0 * Eigen::ArrayXd::Random(n)).cast<P>();
+        ArrayP sum = a + b, difference = a - b, product = a * b, quotient = a / b;
+        ArrayP minimum = a.min(b), magnitude = a.abs(), negated = -a;
+        for (int i{}; i < n; ++i) {
+            Bits x = a[i].value, y = b[i].value;
+            if (sum[i].value != add(x, y)) return fail(set, "a + b");
+            if (difference[i].value != sub(x, y)) return fail(set, "a - b");
+            if (product[i].value != mul(x, y)) return fail(set, "a * b");
+            if (quotient[i].value != div(x, y)) return fail(set, "a / b");
+            if (minimum[i] != (x == y || a[i] < b[i] ? a[i] : b[i])) return fail(set, "a.min(b)");
+            if (magnitude[i] != Eigen::numext::abs(a[i])) return fail(set, "a.abs()");
+            if (negated[i].value != Bits(0u - x)) return fail(set, "-a");
+        }
+    }
+
+    template<typename Result>
+    void check(const char* set, const Result& result, const Eigen::MatrixXd& reference, double tolerance, const char* what)
+    {
+        double error = (result.template cast<double>() - reference).norm() / reference.norm();
+        if (error > tolerance) fail(set, what);
+    }
+}
+
+int main()
+{
+    using namespace Eigen;
+    static_assert(internal::packet_traits<posit16>::Vectorizable && internal::packet_traits<posit8>::Vectorizable,
+                  "posit16 and posit8 vectorize in every x86-64 build");
+    typedef Matrix<posit16, Dynamic, Dynamic> MatrixP16;
+
+    for (eigen_posit::isa target : {eigen_posit::isa::scalar, eigen_posit::isa::sse42, eigen_posit::isa::avx2, eigen_posit::isa::avx512}) {
+        if (!eigen_posit::select_kernels(target)) continue;
+        const char* set = eigen_posit::active_kernels().name;
+        check_arithmetic<posit16, uint16_t>(set, eigen_posit::p16_add, eigen_posit::p16_sub, eigen_posit::p16_mul, eigen_posit::p16_div);
+        check_arithmetic<posit8, uint8_t>(set, eigen_posit::p8_add, eigen_posit::p8_sub, eigen_posit::p8_mul, eigen_posit::p8_div);
+
+        const int n = 40;
+        MatrixP16 a = (MatrixXd::Random(n, n) + 4.0 * MatrixXd::Identity(n, n)).cast<posit16>();
+        MatrixP16 b = MatrixXd::Random(n, n).cast<posit16>();
+        MatrixXd da = a.cast<double>(), db = b.cast<double>();
+        MatrixP16 upper = a.triangularView<Upper>() * b;
+        check(set, upper, MatrixXd(da.triangularView<Upper>()) * db, 1e-2, "triangularView<Upper>() * B");
+        MatrixP16 symmetric = a.selfadjointView<Lower>() * b;
+        check(set, symmetric, MatrixXd(da.selfadjointView<Lower>()) * db, 1e-2, "selfadjointView<Lower>() * B");
+        posit16 total = a.sum();
+        if (std::abs(double(total) - da.sum()) > 1e-2 * da.cwiseAbs().sum()) fail(set, "sum()");
+    }
+
+    if (failures) return 1;
+    std::cout << "small_packets: ok\n";
+    return 0;
+}